@@ -32,6 +32,7 @@
 #include "FixDpiDialog.h"
 #include "ImageInfo.h"
 #include "ImageMetadataLoader.h"
+#include "ImagePrefetcher.h"
 #include "LoadFileTask.h"
 #include "LoadFilesStatusDialog.h"
 #include "NewOpenProjectPanel.h"
@@ -414,6 +415,8 @@ void MainWindow::switchToNewProject(const std::shared_ptr<ProjectPages>& pages,
   m_pageOrientationPropagator = std::make_unique<PageOrientationPropagator>(
       m_stages->pageSplitFilter(), createCompositeCacheDrivenTask(m_stages->fixOrientationFilterIdx()));
 
+  ImagePrefetcher::instance().clear();
+
   // Thumbnails are stored relative to the output directory,
   // so recreate the thumbnail cache.
   if (outDir.isEmpty()) {
@@ -1116,6 +1119,8 @@ void MainWindow::startBatchProcessing() {
   }
 
   m_interactiveQueue->cancelAndClear();
+  // Batch processing visits every page anyway, so don't compete with it.
+  ImagePrefetcher::instance().clear();
 
   m_batchQueue = std::make_unique<ProcessingTaskQueue>();
   PageInfo page(m_thumbSequence->selectionLeader());
@@ -1209,6 +1214,11 @@ void MainWindow::filterResult(const BackgroundTaskPtr& task, const FilterResultP
   // for instance because thumbnail invalidation is done from here.
   result->updateUI(this);
 
+  if (!isBatchProcessingInProgress() && result->filter()) {
+    // The current page is on screen, so let's get its neighbours ready.
+    prefetchAdjacentPages();
+  }
+
   if (isBatchProcessingInProgress()) {
     if (m_batchQueue->allProcessed()) {
       stopBatchProcessing();
@@ -1566,6 +1576,21 @@ bool MainWindow::checkReadyForOutput(const PageId* ignore) const {
   return m_stages->pageLayoutFilter()->checkReadyForOutput(*m_pages, ignore);
 }
 
+void MainWindow::prefetchAdjacentPages() {
+  const PageId currentPage(m_thumbSequence->selectionLeader().id());
+  const ImageId& currentImage = currentPage.imageId();
+
+  std::vector<ImageId> imageIds;
+  // The next page goes first, as moving forward is more common.
+  for (const PageInfo& page : {m_thumbSequence->nextPage(currentPage), m_thumbSequence->prevPage(currentPage)}) {
+    if (!page.isNull() && (page.imageId() != currentImage)) {
+      imageIds.push_back(page.imageId());
+    }
+  }
+
+  ImagePrefetcher::instance().prefetch(imageIds);
+}
+
 void MainWindow::loadPageInteractive(const PageInfo& page) {
   assert(!isBatchProcessingInProgress());
 
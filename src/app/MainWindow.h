@@ -254,6 +254,12 @@ class MainWindow : public QMainWindow, private FilterUiInterface, private Ui::Ma
 
   void loadPageInteractive(const PageInfo& page);
 
+  /**
+   * \brief Starts loading the images of the pages around the selected one
+   *        in the background.
+   */
+  void prefetchAdjacentPages();
+
   void updateWindowTitle();
 
   bool closeProjectInteractive();
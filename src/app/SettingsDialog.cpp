@@ -75,6 +75,7 @@ SettingsDialog::SettingsDialog(QWidget* parent) : QDialog(parent) {
   ui.marginsDeviationThresholdSB->setValue(settings.getMarginsDeviationThreshold());
 
   ui.autoSaveProjectCB->setChecked(settings.isAutoSaveProjectEnabled());
+  ui.lowBatchPriorityCB->setChecked(settings.isLowBatchPriorityEnabled());
 
   ui.thumbnailQualitySB->setValue(settings.getThumbnailQuality().width());
   ui.thumbnailSizeSB->setValue(settings.getMaxLogicalThumbnailSize().toSize().width());
@@ -92,6 +93,7 @@ void SettingsDialog::commitChanges() {
 
   settings.setOpenGlEnabled(ui.enableOpenglCb->isChecked());
   settings.setAutoSaveProjectEnabled(ui.autoSaveProjectCB->isChecked());
+  settings.setLowBatchPriorityEnabled(ui.lowBatchPriorityCB->isChecked());
   settings.setHighlightDeviationEnabled(ui.highlightDeviationCB->isChecked());
   settings.setColorScheme(ui.colorSchemeBox->currentData().toString());
 
@@ -11,6 +11,7 @@
 const bool ApplicationSettings::DEFAULT_OPENGL_STATE = false;
 const QString ApplicationSettings::DEFAULT_COLOR_SCHEME = "dark";
 const bool ApplicationSettings::DEFAULT_AUTO_SAVE_PROJECT = false;
+const bool ApplicationSettings::DEFAULT_LOW_BATCH_PRIORITY = true;
 const int ApplicationSettings::DEFAULT_TIFF_BW_COMPRESSION = COMPRESSION_CCITTFAX4;
 const int ApplicationSettings::DEFAULT_TIFF_COLOR_COMPRESSION = COMPRESSION_LZW;
 const bool ApplicationSettings::DEFAULT_BLACK_ON_WHITE_DETECTION = true;
@@ -33,6 +34,7 @@ const bool ApplicationSettings::DEFAULT_SHOW_CANCELING_SELECTION_QUESTION = true
 const QString ApplicationSettings::ROOT_KEY = "settings";
 const QString ApplicationSettings::OPENGL_STATE_KEY = "enable_opengl";
 const QString ApplicationSettings::AUTO_SAVE_PROJECT_KEY = "auto_save_project";
+const QString ApplicationSettings::LOW_BATCH_PRIORITY_KEY = "low_batch_priority";
 const QString ApplicationSettings::COLOR_SCHEME_KEY = "color_scheme";
 const QString ApplicationSettings::TIFF_BW_COMPRESSION_KEY = "bw_compression";
 const QString ApplicationSettings::TIFF_COLOR_COMPRESSION_KEY = "color_compression";
@@ -88,6 +90,14 @@ void ApplicationSettings::setAutoSaveProjectEnabled(bool enabled) {
   m_settings.setValue(getKey(AUTO_SAVE_PROJECT_KEY), enabled);
 }
 
+bool ApplicationSettings::isLowBatchPriorityEnabled() const {
+  return m_settings.value(getKey(LOW_BATCH_PRIORITY_KEY), DEFAULT_LOW_BATCH_PRIORITY).toBool();
+}
+
+void ApplicationSettings::setLowBatchPriorityEnabled(bool enabled) {
+  m_settings.setValue(getKey(LOW_BATCH_PRIORITY_KEY), enabled);
+}
+
 int ApplicationSettings::getTiffBwCompression() const {
   return m_settings.value(getKey(TIFF_BW_COMPRESSION_KEY), DEFAULT_TIFF_BW_COMPRESSION).toInt();
 }
@@ -32,6 +32,10 @@ class ApplicationSettings {
 
   void setAutoSaveProjectEnabled(bool enabled);
 
+  bool isLowBatchPriorityEnabled() const;
+
+  void setLowBatchPriorityEnabled(bool enabled);
+
   int getTiffBwCompression() const;
 
   void setTiffBwCompression(int compression);
@@ -110,6 +114,7 @@ class ApplicationSettings {
   static const bool DEFAULT_OPENGL_STATE;
   static const QString DEFAULT_COLOR_SCHEME;
   static const bool DEFAULT_AUTO_SAVE_PROJECT;
+  static const bool DEFAULT_LOW_BATCH_PRIORITY;
   static const int DEFAULT_TIFF_BW_COMPRESSION;
   static const int DEFAULT_TIFF_COLOR_COMPRESSION;
   static const bool DEFAULT_BLACK_ON_WHITE_DETECTION;
@@ -132,6 +137,7 @@ class ApplicationSettings {
   static const QString ROOT_KEY;
   static const QString OPENGL_STATE_KEY;
   static const QString AUTO_SAVE_PROJECT_KEY;
+  static const QString LOW_BATCH_PRIORITY_KEY;
   static const QString COLOR_SCHEME_KEY;
   static const QString TIFF_BW_COMPRESSION_KEY;
   static const QString TIFF_COLOR_COMPRESSION_KEY;
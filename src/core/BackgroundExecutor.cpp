@@ -4,46 +4,72 @@
 #include "BackgroundExecutor.h"
 
 #include <QCoreApplication>
+#include <QMutex>
+#include <QMutexLocker>
 #include <QThread>
+#include <QWaitCondition>
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <deque>
 
 #include "OutOfMemoryHandler.h"
 
-class BackgroundExecutor::Dispatcher : public QObject {
+class BackgroundExecutor::LaneThread : public QThread {
  public:
-  explicit Dispatcher(Impl& owner);
+  LaneThread(Impl& owner, QThread::Priority threadPriority);
+
+  /**
+   * Discards pending tasks and waits for the running one to finish.
+   */
+  ~LaneThread() override;
+
+  void enqueueTask(const TaskPtr& task, const void* requester, Priority priority);
 
  protected:
-  void customEvent(QEvent* event) override;
+  void run() override;
 
  private:
+  struct Entry {
+    TaskPtr task;
+    const void* requester;
+    Priority priority;
+  };
+
+  /**
+   * Takes the first of the highest priority tasks out of the queue.
+   * Must be called with m_mutex locked and with a non-empty queue.
+   */
+  TaskPtr takeNextTask();
+
   Impl& m_owner;
+  QMutex m_mutex;
+  QWaitCondition m_cond;
+  std::deque<Entry> m_queue;
+  QThread::Priority m_threadPriority;
+  bool m_exiting;
 };
 
 
-class BackgroundExecutor::Impl : public QThread {
+class BackgroundExecutor::Impl : public QObject {
  public:
-  explicit Impl(BackgroundExecutor& owner);
+  Impl();
 
   ~Impl() override;
 
-  void enqueueTask(const TaskPtr& task);
+  void enqueueTask(const TaskPtr& task, Lane lane, const void* requester, Priority priority);
 
  protected:
-  void run() override;
-
   void customEvent(QEvent* event) override;
 
  private:
-  BackgroundExecutor& m_owner;
-  Dispatcher m_dispatcher;
-  bool m_threadStarted;
+  std::array<std::unique_ptr<LaneThread>, LANE_COUNT> m_lanes;
 };
 
 
 /*============================ BackgroundExecutor ==========================*/
 
-BackgroundExecutor::BackgroundExecutor() : m_impl(std::make_unique<Impl>(*this)) {}
+BackgroundExecutor::BackgroundExecutor() : m_impl(std::make_unique<Impl>()) {}
 
 BackgroundExecutor::~BackgroundExecutor() = default;
 
@@ -52,54 +78,111 @@ void BackgroundExecutor::shutdown() {
 }
 
 void BackgroundExecutor::enqueueTask(const TaskPtr& task) {
+  enqueueTask(task, GENERAL_LANE, nullptr, NORMAL_PRIORITY);
+}
+
+void BackgroundExecutor::enqueueTask(const TaskPtr& task,
+                                     const Lane lane,
+                                     const void* requester,
+                                     const Priority priority) {
   if (m_impl) {
-    m_impl->enqueueTask(task);
+    m_impl->enqueueTask(task, lane, requester, priority);
   }
 }
 
-/*===================== BackgroundExecutor::Dispatcher =====================*/
+/*===================== BackgroundExecutor::LaneThread =====================*/
 
-BackgroundExecutor::Dispatcher::Dispatcher(Impl& owner) : m_owner(owner) {}
+BackgroundExecutor::LaneThread::LaneThread(Impl& owner, const QThread::Priority threadPriority)
+    : m_owner(owner), m_threadPriority(threadPriority), m_exiting(false) {}
 
-void BackgroundExecutor::Dispatcher::customEvent(QEvent* event) {
-  try {
-    auto* evt = dynamic_cast<TaskEvent*>(event);
-    assert(evt);
-
-    const TaskPtr& task = evt->payload();
-    assert(task);
+BackgroundExecutor::LaneThread::~LaneThread() {
+  {
+    const QMutexLocker locker(&m_mutex);
+    m_exiting = true;
+    m_queue.clear();
+  }
+  m_cond.wakeAll();
+  wait();
+}
 
-    const TaskResultPtr result((*task)());
-    if (result) {
-      QCoreApplication::postEvent(&m_owner, new ResultEvent(result));
+void BackgroundExecutor::LaneThread::enqueueTask(const TaskPtr& task,
+                                                 const void* requester,
+                                                 const Priority priority) {
+  {
+    const QMutexLocker locker(&m_mutex);
+    if (requester) {
+      // Latest wins: whatever this requester asked for before is obsolete now.
+      m_queue.erase(std::remove_if(m_queue.begin(), m_queue.end(),
+                                   [requester](const Entry& entry) { return entry.requester == requester; }),
+                    m_queue.end());
     }
-  } catch (const std::bad_alloc&) {
-    OutOfMemoryHandler::instance().handleOutOfMemorySituation();
+    m_queue.push_back(Entry{task, requester, priority});
+  }
+  m_cond.wakeOne();
+
+  if (!isRunning()) {
+    start(m_threadPriority);
   }
 }
 
-/*======================= BackgroundExecutor::Impl =========================*/
+BackgroundExecutor::TaskPtr BackgroundExecutor::LaneThread::takeNextTask() {
+  assert(!m_queue.empty());
 
-BackgroundExecutor::Impl::Impl(BackgroundExecutor& owner)
-    : m_owner(owner), m_dispatcher(*this), m_threadStarted(false) {
-  m_dispatcher.moveToThread(this);
+  auto it = m_queue.begin();
+  for (auto candidate = m_queue.begin(); candidate != m_queue.end(); ++candidate) {
+    if (candidate->priority > it->priority) {
+      it = candidate;
+    }
+  }
+
+  TaskPtr task(std::move(it->task));
+  m_queue.erase(it);
+  return task;
 }
 
-BackgroundExecutor::Impl::~Impl() {
-  exit();
-  wait();
+void BackgroundExecutor::LaneThread::run() {
+  while (true) {
+    TaskPtr task;
+    {
+      QMutexLocker locker(&m_mutex);
+      while (m_queue.empty() && !m_exiting) {
+        m_cond.wait(&m_mutex);
+      }
+      if (m_exiting) {
+        return;
+      }
+      task = takeNextTask();
+    }
+
+    try {
+      const TaskResultPtr result((*task)());
+      if (result) {
+        QCoreApplication::postEvent(&m_owner, new ResultEvent(result));
+      }
+    } catch (const std::bad_alloc&) {
+      OutOfMemoryHandler::instance().handleOutOfMemorySituation();
+    }
+  }
 }
 
-void BackgroundExecutor::Impl::enqueueTask(const TaskPtr& task) {
-  QCoreApplication::postEvent(&m_dispatcher, new TaskEvent(task));
-  if (!m_threadStarted) {
-    start();
-    m_threadStarted = true;
+/*======================= BackgroundExecutor::Impl =========================*/
+
+BackgroundExecutor::Impl::Impl() {
+  for (int i = 0; i < LANE_COUNT; ++i) {
+    // LowPriority would be a no-op for SCHED_OTHER threads on Linux.
+    const QThread::Priority threadPriority = (i == PREFETCH_LANE) ? QThread::IdlePriority : QThread::InheritPriority;
+    m_lanes[i] = std::make_unique<LaneThread>(*this, threadPriority);
   }
 }
 
-void BackgroundExecutor::Impl::run() {
-  exec();
+BackgroundExecutor::Impl::~Impl() = default;
+
+void BackgroundExecutor::Impl::enqueueTask(const TaskPtr& task,
+                                           const Lane lane,
+                                           const void* requester,
+                                           const Priority priority) {
+  assert(lane >= 0 && lane < LANE_COUNT);
+  m_lanes[lane]->enqueueTask(task, requester, priority);
 }
 
 void BackgroundExecutor::Impl::customEvent(QEvent* event) {
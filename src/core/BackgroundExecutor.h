@@ -10,6 +10,16 @@
 #include "NonCopyable.h"
 #include "PayloadEvent.h"
 
+/**
+ * \brief Executes tasks in a small pool of background threads.
+ *
+ * Tasks are distributed among lanes, each lane being served by its own thread,
+ * so that unrelated kinds of work (like rendering a view and building a despeckle
+ * preview) don't queue behind each other.  Within a lane, tasks with a higher
+ * priority are started first.  A task submitted on behalf of a requester replaces
+ * any task of the same requester that is still waiting in that lane, so only
+ * the latest request of each requester gets executed.
+ */
 class BackgroundExecutor {
   DECLARE_NON_COPYABLE(BackgroundExecutor)
 
@@ -17,6 +27,14 @@ class BackgroundExecutor {
   using TaskResultPtr = std::shared_ptr<AbstractCommand<void>>;
   using TaskPtr = std::shared_ptr<AbstractCommand<TaskResultPtr>>;
 
+  /**
+   * Tasks in PREFETCH_LANE are speculative and run at idle thread priority,
+   * so that they only consume the time nothing else needs.
+   */
+  enum Lane { GENERAL_LANE, VIEW_RENDERING_LANE, DESPECKLE_PREVIEW_LANE, ZONE_MASK_LANE, PREFETCH_LANE, LANE_COUNT };
+
+  enum Priority { NORMAL_PRIORITY, VISIBLE_PRIORITY };
+
   BackgroundExecutor();
 
   /**
@@ -25,7 +43,8 @@ class BackgroundExecutor {
   ~BackgroundExecutor();
 
   /**
-   * \brief Waits for pending jobs to finish and stop the background thread.
+   * \brief Discards pending jobs, waits for the running ones to finish
+   *        and stops the background threads.
    *
    * The destructor also performs these tasks, so this method is only
    * useful to prematuraly stop task processing.  After shutdown, any
@@ -40,14 +59,27 @@ class BackgroundExecutor {
    * That functor may optionally return another one, that is
    * to be executed in the thread where this BackgroundExecutor
    * object was constructed.
+   *
+   * The task goes to GENERAL_LANE with normal priority and is never coalesced.
    */
   void enqueueTask(const TaskPtr& task);
 
+  /**
+   * \brief Enqueue a task for execution in the given lane.
+   *
+   * \param task The task to execute.  See enqueueTask(const TaskPtr&).
+   * \param lane The lane to execute the task in.
+   * \param requester An opaque key identifying the object on whose behalf
+   *        the task is executed.  Tasks of the same requester still waiting
+   *        in \p lane are discarded.  Pass nullptr to disable coalescing.
+   * \param priority The priority of the task within its lane.
+   */
+  void enqueueTask(const TaskPtr& task, Lane lane, const void* requester, Priority priority = NORMAL_PRIORITY);
+
  private:
   class Impl;
-  class Dispatcher;
+  class LaneThread;
 
-  using TaskEvent = PayloadEvent<TaskPtr>;
   using ResultEvent = PayloadEvent<TaskResultPtr>;
 
   std::unique_ptr<Impl> m_impl;
@@ -9,10 +9,14 @@
 #include <QDebug>
 #include <QImage>
 #include <cmath>
+#include <memory>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "DebugImages.h"
 #include "Dpi.h"
+#include "CancellationPoint.h"
 #include "FastQueue.h"
 #include "TaskStatus.h"
 
@@ -242,6 +246,20 @@ struct Connection {
   };
 };
 
+using Connections = std::unordered_map<Connection, uint32_t, Connection::hash>;  // conn -> sqdist
+
+/**
+ * \brief Connections along with the order they were first found in.
+ *
+ * Remapping the labels of these in order gives the same Connections as
+ * building them from a Voronoi diagram with its regions remapped, down to
+ * the order of iteration, which the results of tagSourceComponent() depend on.
+ */
+struct OrderedConnections {
+  std::unordered_map<Connection, size_t, Connection::hash> index;
+  std::vector<std::pair<Connection, uint32_t>> list;  // (conn, sqdist)
+};
+
 /**
  * \brief A directional assiciation between two connected components.
  */
@@ -274,12 +292,7 @@ struct TargetSourceConn {
  * \brief If the association didn't exist, create it,
  *        otherwise the minimum distance.
  */
-void updateDistance(std::unordered_map<Connection, uint32_t, Connection::hash>& conns,
-                    uint32_t label1,
-                    uint32_t label2,
-                    uint32_t sqdist) {
-  using Connections = std::unordered_map<Connection, uint32_t, Connection::hash>;
-
+void updateDistance(Connections& conns, uint32_t label1, uint32_t label2, uint32_t sqdist) {
   const Connection conn(label1, label2);
   auto it(conns.find(conn));
   if (it == conns.end()) {
@@ -289,6 +302,17 @@ void updateDistance(std::unordered_map<Connection, uint32_t, Connection::hash>&
   }
 }
 
+void updateDistance(OrderedConnections& conns, uint32_t label1, uint32_t label2, uint32_t sqdist) {
+  const Connection conn(label1, label2);
+  const auto it(conns.index.find(conn));
+  if (it == conns.index.end()) {
+    conns.index.emplace(conn, conns.list.size());
+    conns.list.emplace_back(conn, sqdist);
+  } else if (sqdist < conns.list[it->second].second) {
+    conns.list[it->second].second = sqdist;
+  }
+}
+
 /**
  * \brief Tag the source component with ANCHORED_TO_SMALL, ANCHORED_TO_BIG
  *        or none of the above.
@@ -348,6 +372,7 @@ void voronoi(ConnectivityMap& cmap, std::vector<Distance>& dist) {
 
   // Top to bottom scan.
   for (int y = 1; y < height; ++y) {
+    CancellationPoint::poll();
     distLine += width;
     cmapLine += width;
     distLine[0].reset(0);
@@ -404,6 +429,7 @@ void voronoi(ConnectivityMap& cmap, std::vector<Distance>& dist) {
 
   // Bottom to top scan.
   for (int y = height - 2; y >= 1; --y) {
+    CancellationPoint::poll();
     distLine -= width;
     cmapLine -= width;
     distLine[0].reset(0);
@@ -478,6 +504,7 @@ void voronoiSpecial(ConnectivityMap& cmap, std::vector<Distance>& dist, const Di
 
   // Top to bottom scan.
   for (int y = 1; y < height - 1; ++y) {
+    CancellationPoint::poll();
     distLine += width;
     cmapLine += width;
     distLine[0].reset(0);
@@ -544,6 +571,7 @@ void voronoiSpecial(ConnectivityMap& cmap, std::vector<Distance>& dist, const Di
 
   // Bottom to top scan.
   for (int y = height - 2; y >= 1; --y) {
+    CancellationPoint::poll();
     distLine -= width;
     cmapLine -= width;
     distLine[0].reset(0);
@@ -613,9 +641,10 @@ void voronoiSpecial(ConnectivityMap& cmap, std::vector<Distance>& dist, const Di
  * Calculate the minimum distance between components from neighboring
  * Voronoi segments.
  */
+template <typename ConnectionsT>
 void voronoiDistances(const ConnectivityMap& cmap,
                       const std::vector<Distance>& distanceMatrix,
-                      std::unordered_map<Connection, uint32_t, Connection::hash>& conns) {
+                      ConnectionsT& conns) {
   const int width = cmap.size().width();
   const int height = cmap.size().height();
 
@@ -624,6 +653,7 @@ void voronoiDistances(const ConnectivityMap& cmap,
   const uint32_t* const cmapData = cmap.data();
   const Distance* const distanceData = &distanceMatrix[0] + width + 3;
   for (int y = 0, offset = 0; y < height; ++y, offset += 2) {
+    CancellationPoint::poll();
     for (int x = 0; x < width; ++x, ++offset) {
       const uint32_t label = cmapData[offset];
       assert(label != 0);
@@ -652,12 +682,53 @@ void voronoiDistances(const ConnectivityMap& cmap,
   }
 }  // voronoiDistances
 
-void despeckleImpl(BinaryImage& image,
-                   const Dpi& dpi,
-                   const Settings& settings,
-                   const TaskStatus& status,
-                   DebugImages* const dbg) {
-  ConnectivityMap cmap(image, CONN8);
+}  // namespace
+
+/**
+ * Everything despeckling an image involves that doesn't depend on the despeckling
+ * level: connected components of the image, their Voronoi regions and the distances
+ * between the neighbouring ones.
+ */
+class Despeckle::Analysis {
+ public:
+  Analysis(const BinaryImage& image, const Dpi& dpi) : image(image), dpi(dpi) {}
+
+  BinaryImage image;
+
+  Dpi dpi;
+
+  /**
+   * Voronoi regions of connected components of the image.  Black pixels
+   * are labeled with their connected component.  Empty for a white image.
+   */
+  ConnectivityMap regions;
+
+  /**
+   * The number of pixels and the bounding box of each connected component.
+   */
+  std::vector<uint32_t> numPixels;
+  std::vector<BoundingBox> boundingBoxes;
+
+  /**
+   * The offsets from each pixel of the padded Voronoi diagram to the nearest
+   * black pixel.  They only depend on which pixels are black, so the diagram
+   * of components unified at any level is this one with its regions remapped.
+   */
+  std::vector<Distance> distances;
+
+  /**
+   * Squared distances between connected components with adjacent Voronoi regions,
+   * in the order they were found in.
+   */
+  std::vector<std::pair<Connection, uint32_t>> conns;
+};
+
+namespace {
+void analyzeImpl(Despeckle::Analysis& analysis, const TaskStatus& status, DebugImages* const dbg) {
+  // The distance transforms below poll for cancellation through it.
+  const CancellationPoint::Scope cancellationScope(status);
+
+  ConnectivityMap cmap(analysis.image, CONN8);
   if (cmap.maxLabel() == 0) {
     // Completely white image?
     return;
@@ -665,35 +736,77 @@ void despeckleImpl(BinaryImage& image,
 
   status.throwIfCancelled();
 
-  std::vector<Component> components(cmap.maxLabel() + 1);
-  std::vector<BoundingBox> boundingBoxes(cmap.maxLabel() + 1);
-
-  const int width = image.width();
-  const int height = image.height();
+  std::vector<uint32_t>& numPixels = analysis.numPixels;
+  std::vector<BoundingBox>& boundingBoxes = analysis.boundingBoxes;
+  numPixels.resize(cmap.maxLabel() + 1);
+  boundingBoxes.resize(cmap.maxLabel() + 1);
 
-  uint32_t* const cmapData = cmap.data();
+  const int width = cmap.size().width();
+  const int height = cmap.size().height();
 
   // Count the number of pixels and a bounding rect of each component.
-  uint32_t* cmapLine = cmapData;
+  const uint32_t* cmapLine = cmap.data();
   const int cmapStride = cmap.stride();
   for (int y = 0; y < height; ++y) {
     for (int x = 0; x < width; ++x) {
       const uint32_t label = cmapLine[x];
-      ++components[label].numPixels;
+      ++numPixels[label];
       boundingBoxes[label].extend(x, y);
     }
     cmapLine += cmapStride;
   }
 
   status.throwIfCancelled();
+  // Build a Voronoi diagram.  Which components end up being unified
+  // into a big one depends on the level, but the regions don't.
+  std::vector<Distance> distanceMatrix;
+  voronoi(cmap, distanceMatrix);
+  if (dbg) {
+    dbg->add(cmap.visualized(), "voronoi");
+  }
+
+  status.throwIfCancelled();
+
+  // Now build a bidirectional map of distances between neighboring
+  // connected components.
+  OrderedConnections conns;
+  voronoiDistances(cmap, distanceMatrix, conns);
+
+  analysis.regions.swap(cmap);
+  analysis.distances.swap(distanceMatrix);
+  analysis.conns.swap(conns.list);
+}
+
+BinaryImage despeckleImpl(const Despeckle::Analysis& analysis,
+                          const Settings& settings,
+                          const TaskStatus& status,
+                          DebugImages* const dbg) {
+  // The distance transforms below poll for cancellation through it.
+  const CancellationPoint::Scope cancellationScope(status);
+
+  BinaryImage image(analysis.image);
+  const ConnectivityMap& regions = analysis.regions;
+  if (regions.maxLabel() == 0) {
+    return image;
+  }
+
+  status.throwIfCancelled();
+
+  std::vector<Component> components(regions.maxLabel() + 1);
+  for (uint32_t label = 0; label <= regions.maxLabel(); ++label) {
+    components[label].numPixels = analysis.numPixels[label];
+  }
+
+  const int width = image.width();
+  const int height = image.height();
 
   // Unify big components into one.
   std::vector<uint32_t> remappingTable(components.size());
   uint32_t unifiedBigComponent = 0;
   uint32_t nextAvailComponent = 1;
-  for (uint32_t label = 1; label <= cmap.maxLabel(); ++label) {
-    if ((boundingBoxes[label].width() < settings.bigObjectThreshold)
-        && (boundingBoxes[label].height() < settings.bigObjectThreshold)) {
+  for (uint32_t label = 1; label <= regions.maxLabel(); ++label) {
+    const BoundingBox& box = analysis.boundingBoxes[label];
+    if ((box.width() < settings.bigObjectThreshold) && (box.height() < settings.bigObjectThreshold)) {
       components[nextAvailComponent] = components[label];
       remappingTable[label] = nextAvailComponent;
       ++nextAvailComponent;
@@ -710,41 +823,19 @@ void despeckleImpl(BinaryImage& image,
     }
   }
   components.resize(nextAvailComponent);
-  std::vector<BoundingBox>().swap(boundingBoxes);  // We don't need them any more.
-  status.throwIfCancelled();
 
   const uint32_t maxLabel = nextAvailComponent - 1;
-  // Remapping individual pixels.
-  cmapLine = cmapData;
-  for (int y = 0; y < height; ++y) {
-    for (int x = 0; x < width; ++x) {
-      cmapLine[x] = remappingTable[cmapLine[x]];
-    }
-    cmapLine += cmapStride;
-  }
-  if (dbg) {
-    dbg->add(cmap.visualized(), "big_components_unified");
-  }
-
-  status.throwIfCancelled();
-  // Build a Voronoi diagram.
-  std::vector<Distance> distanceMatrix;
-  voronoi(cmap, distanceMatrix);
-  if (dbg) {
-    dbg->add(cmap.visualized(), "voronoi");
-  }
 
-  status.throwIfCancelled();
-
-  Distance* const distanceData = &distanceMatrix[0] + width + 3;
-
-  // Now build a bidirectional map of distances between neighboring
-  // connected components.
-
-  using Connections = std::unordered_map<Connection, uint32_t, Connection::hash>;  // conn -> sqdist
+  // Unifying components merges their Voronoi regions, so the connections
+  // between unified components are the closest ones between their parts.
   Connections conns;
-
-  voronoiDistances(cmap, distanceMatrix, conns);
+  for (const std::pair<Connection, uint32_t>& pair : analysis.conns) {
+    const uint32_t label1 = remappingTable[pair.first.lesserLabel];
+    const uint32_t label2 = remappingTable[pair.first.greaterLabel];
+    if (label1 != label2) {
+      updateDistance(conns, label1, label2, pair.second);
+    }
+  }
 
   status.throwIfCancelled();
 
@@ -776,7 +867,24 @@ void despeckleImpl(BinaryImage& image,
     // Give such components a second chance.  Maybe they do have
     // big neighbors, but Voronoi regions from a smaller ones
     // block the path to the bigger ones.
+    // That needs the Voronoi diagram of unified components.
+    // Unifying doesn't move any black pixels, so it's the diagram
+    // we already have, with its regions remapped.
+    ConnectivityMap cmap(regions);
+    uint32_t* const cmapData = cmap.data();
+    uint32_t* cmapCell = cmap.paddedData();
+    for (int todo = (width + 2) * (height + 2); todo > 0; --todo, ++cmapCell) {
+      *cmapCell = remappingTable[*cmapCell];
+    }
+    if (dbg) {
+      dbg->add(cmap.visualized(), "voronoi_unified");
+    }
 
+    status.throwIfCancelled();
+
+    std::vector<Distance> distanceMatrix(analysis.distances);
+
+    Distance* const distanceData = &distanceMatrix[0] + width + 3;
     const Distance zeroDistance(Distance::zero());
     const Distance specialDistance(Distance::special());
     for (int y = 0, offset = 0; y < height; ++y, offset += 2) {
@@ -820,9 +928,6 @@ void despeckleImpl(BinaryImage& image,
 
   status.throwIfCancelled();
 
-  // Clear the distance matrix.
-  std::vector<Distance>().swap(distanceMatrix);
-
   // Remove tags from components.
   for (Component& comp : components) {
     comp.clearTags();
@@ -895,19 +1000,37 @@ void despeckleImpl(BinaryImage& image,
   const uint32_t msb = uint32_t(1) << 31;
   uint32_t* imageLine = image.data();
   const int imageStride = image.wordsPerLine();
-  cmapLine = cmapData;
+  const uint32_t* regionsLine = regions.data();
+  const int regionsStride = regions.stride();
   for (int y = 0; y < height; ++y) {
     for (int x = 0; x < width; ++x) {
-      if (!components[cmapLine[x]].anchoredToBig()) {
+      if (!components[remappingTable[regionsLine[x]]].anchoredToBig()) {
         imageLine[x >> 5] &= ~(msb >> (x & 31));
       }
     }
     imageLine += imageStride;
-    cmapLine += cmapStride;
+    regionsLine += regionsStride;
   }
+  return image;
 }
 }  // namespace
 
+std::shared_ptr<const Despeckle::Analysis> Despeckle::analyze(const BinaryImage& src,
+                                                              const Dpi& dpi,
+                                                              const TaskStatus& status,
+                                                              DebugImages* const dbg) {
+  auto analysis = std::make_shared<Analysis>(src, dpi);
+  analyzeImpl(*analysis, status, dbg);
+  return analysis;
+}
+
+BinaryImage Despeckle::despeckle(const Analysis& analysis,
+                                 const double level,
+                                 const TaskStatus& status,
+                                 DebugImages* const dbg) {
+  return despeckleImpl(analysis, Settings::get(level, analysis.dpi), status, dbg);
+}
+
 BinaryImage Despeckle::despeckle(const BinaryImage& src,
                                  const Dpi& dpi,
                                  const Level level,
@@ -923,8 +1046,9 @@ void Despeckle::despeckleInPlace(BinaryImage& image,
                                  const Level level,
                                  const TaskStatus& status,
                                  DebugImages* const dbg) {
-  const Settings settings = Settings::get(level, dpi);
-  despeckleImpl(image, dpi, settings, status, dbg);
+  Analysis analysis(image, dpi);
+  analyzeImpl(analysis, status, dbg);
+  image = despeckleImpl(analysis, Settings::get(level, dpi), status, dbg);
 }
 
 imageproc::BinaryImage Despeckle::despeckle(const imageproc::BinaryImage& src,
@@ -942,7 +1066,8 @@ void Despeckle::despeckleInPlace(imageproc::BinaryImage& image,
                                  const double level,
                                  const TaskStatus& status,
                                  DebugImages* dbg) {
-  const Settings settings = Settings::get(level, dpi);
-  despeckleImpl(image, dpi, settings, status, dbg);
+  Analysis analysis(image, dpi);
+  analyzeImpl(analysis, status, dbg);
+  image = despeckleImpl(analysis, Settings::get(level, dpi), status, dbg);
 }
 // Despeckle::despeckleInPlace
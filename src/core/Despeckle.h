@@ -4,6 +4,8 @@
 #ifndef SCANTAILOR_CORE_DESPECKLE_H_
 #define SCANTAILOR_CORE_DESPECKLE_H_
 
+#include <memory>
+
 class Dpi;
 class TaskStatus;
 class DebugImages;
@@ -16,6 +18,37 @@ class Despeckle {
  public:
   enum Level { CAUTIOUS, NORMAL, AGGRESSIVE };
 
+  /**
+   * \brief The level-independent part of despeckling an image.
+   *
+   * Despeckling the same image at different levels may reuse it
+   * to skip the most expensive steps.
+   */
+  class Analysis;
+
+  /**
+   * \brief Analyzes a binary image for despeckling at any level.
+   *
+   * \param src The image to analyze.  Must not be null.
+   * \param dpi DPI of \p src.
+   * \param status For asynchronous task cancellation.
+   * \param dbg An optional sink for debugging images.
+   */
+  static std::shared_ptr<const Analysis> analyze(const imageproc::BinaryImage& src,
+                                                 const Dpi& dpi,
+                                                 const TaskStatus& status,
+                                                 DebugImages* dbg = nullptr);
+
+  /**
+   * \brief Despeckles an analyzed image.
+   *
+   * Gives the same result as despeckling the image the analysis was made of.
+   */
+  static imageproc::BinaryImage despeckle(const Analysis& analysis,
+                                          double level,
+                                          const TaskStatus& status,
+                                          DebugImages* dbg = nullptr);
+
   /**
    * \brief Removes small speckles from a binary image.
    *
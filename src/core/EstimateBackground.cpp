@@ -12,6 +12,7 @@
 #include <PolygonRasterizer.h>
 #include <PolynomialLine.h>
 #include <PolynomialSurface.h>
+#include <RasterOp.h>
 #include <RasterOpGeneric.h>
 #include <Scale.h>
 #include <SeedFill.h>
@@ -28,6 +29,21 @@
 
 using namespace imageproc;
 
+namespace {
+/**
+ * Pixels of the downscaled background deviating from the fitted surface
+ * by more than this are taken for something other than the background.
+ */
+const int RESIDUAL_THRESHOLD = 40;
+
+/**
+ * If more than this fraction of the mask deviates from the surface, it's
+ * the surface that is off, typically due to a shadow, rather than the mask.
+ * The mask is left as it is then.
+ */
+const double MAX_OUTLIER_FRACTION = 0.1;
+}  // namespace
+
 struct AbsoluteDifference {
   static uint8_t transform(uint8_t src, uint8_t dst) { return static_cast<uint8_t>(std::abs(int(src) - int(dst))); }
 };
@@ -138,6 +154,69 @@ static void morphologicalPreprocessingInPlace(GrayImage& image, DebugImages* dbg
   }
 }  // morphologicalPreprocessingInPlace
 
+PolynomialSurface refineBackgroundFit(const GrayImage& background,
+                                     BinaryImage& mask,
+                                     const TaskStatus& status,
+                                     DebugImages* dbg) {
+  PolynomialSurface surface(8, 5, background, mask);
+
+  const int maskPixels = mask.countBlackPixels();
+  if (maskPixels == 0) {
+    return surface;
+  }
+
+  status.throwIfCancelled();
+
+  const GrayImage approximated(surface.render(background.size()));
+  const int width = background.width();
+  const int height = background.height();
+  const uint8_t* bgLine = background.data();
+  const int bgStride = background.stride();
+  const uint8_t* approxLine = approximated.data();
+  const int approxStride = approximated.stride();
+  const uint32_t* maskLine = mask.data();
+  const int maskStride = mask.wordsPerLine();
+
+  BinaryImage outliers(background.size(), WHITE);
+  uint32_t* outliersLine = outliers.data();
+  const int outliersStride = outliers.wordsPerLine();
+  const uint32_t msb = uint32_t(1) << 31;
+  int numOutliers = 0;
+
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      const uint32_t bit = msb >> (x & 31);
+      if ((maskLine[x >> 5] & bit) && std::abs(int(bgLine[x]) - int(approxLine[x])) > RESIDUAL_THRESHOLD) {
+        outliersLine[x >> 5] |= bit;
+        ++numOutliers;
+      }
+    }
+    bgLine += bgStride;
+    approxLine += approxStride;
+    maskLine += maskStride;
+    outliersLine += outliersStride;
+  }
+
+  if ((numOutliers == 0) || (numOutliers > MAX_OUTLIER_FRACTION * maskPixels)) {
+    return surface;
+  }
+
+  status.throwIfCancelled();
+
+  outliers = dilateBrick(outliers, QSize(3, 3));
+  if (dbg) {
+    dbg->add(outliers, "residual_outliers");
+  }
+
+  rasterOp<RopSubtract<RopDst, RopSrc>>(mask, outliers);
+  if (dbg) {
+    dbg->add(mask, "refined_mask");
+  }
+
+  status.throwIfCancelled();
+  return PolynomialSurface(8, 5, background, mask);
+}
+
 imageproc::PolynomialSurface estimateBackground(const GrayImage& input,
                                                 const QPolygonF& areaToConsider,
                                                 const TaskStatus& status,
@@ -285,5 +364,5 @@ imageproc::PolynomialSurface estimateBackground(const GrayImage& input,
   }
 
   status.throwIfCancelled();
-  return PolynomialSurface(8, 5, background, mask);
+  return refineBackgroundFit(background, mask, status, dbg);
 }  // estimateBackground
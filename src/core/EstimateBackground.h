@@ -12,6 +12,7 @@ class QPolygonF;
 namespace imageproc {
 class PolynomialSurface;
 class GrayImage;
+class BinaryImage;
 }  // namespace imageproc
 
 /**
@@ -46,4 +47,26 @@ imageproc::PolynomialSurface estimateBackground(const imageproc::GrayImage& inpu
                                                 const TaskStatus& status,
                                                 DebugImages* dbg = nullptr);
 
+/**
+ * \brief The final step of estimateBackground().
+ *
+ * Fits a surface into the masked pixels of the downscaled background, then
+ * takes another look at the places where it fits badly.  Those are normally
+ * the remnants of pictures the mask failed to cover, so they are excluded
+ * from the mask, together with their immediate neighbourhood, and the surface
+ * is fitted once again.  The rest of the mask is not revisited.  If too much
+ * of the mask fits badly, it's the surface that is off rather than the mask,
+ * and the first fit is returned, with the mask left as it is.
+ *
+ * \param background The downscaled background.
+ * \param mask The pixels of \p background to fit the surface into.
+ *        Pixels found not to belong to the background are removed from it.
+ * \param status The status of a task.
+ * \param dbg The sink for intermediate images used for debugging purposes.
+ */
+imageproc::PolynomialSurface refineBackgroundFit(const imageproc::GrayImage& background,
+                                                 imageproc::BinaryImage& mask,
+                                                 const TaskStatus& status,
+                                                 DebugImages* dbg = nullptr);
+
 #endif
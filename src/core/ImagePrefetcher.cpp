@@ -0,0 +1,149 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#include "ImagePrefetcher.h"
+
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <algorithm>
+
+#include "BackgroundExecutor.h"
+#include "ImageLoader.h"
+#include "ImageViewBase.h"
+
+namespace {
+/**
+ * The amount of memory the cached images may occupy.  Enough for the pages
+ * on both sides of the current one at typical resolutions.  Images that
+ * don't fit on their own aren't kept at all.
+ */
+const size_t MAX_CACHED_BYTES = 128 * 1024 * 1024;
+
+size_t imageByteCount(const QImage& image) {
+  return static_cast<size_t>(image.bytesPerLine()) * image.height();
+}
+}  // namespace
+
+class ImagePrefetcher::LoadTask : public AbstractCommand<BackgroundExecutor::TaskResultPtr> {
+ public:
+  LoadTask(ImagePrefetcher& owner, const std::vector<ImageId>& imageIds, unsigned generation, unsigned epoch)
+      : m_owner(owner), m_imageIds(imageIds), m_generation(generation), m_epoch(epoch) {}
+
+  BackgroundExecutor::TaskResultPtr operator()() override {
+    for (const ImageId& imageId : m_imageIds) {
+      if (m_owner.m_generation.load() != m_generation) {
+        break;
+      }
+      if (m_owner.contains(imageId)) {
+        continue;
+      }
+
+      Entry entry(stampedEntry(imageId));
+      entry.image = ImageLoader::load(imageId);
+      if (!entry.image.isNull()) {
+        m_owner.store(entry, m_epoch);
+      }
+    }
+    return nullptr;
+  }
+
+ private:
+  ImagePrefetcher& m_owner;
+  std::vector<ImageId> m_imageIds;
+  unsigned m_generation;
+  unsigned m_epoch;
+};
+
+
+ImagePrefetcher::ImagePrefetcher() : m_byteCount(0), m_epoch(0), m_generation(0) {}
+
+ImagePrefetcher& ImagePrefetcher::instance() {
+  static ImagePrefetcher object;
+  return object;
+}
+
+void ImagePrefetcher::prefetch(const std::vector<ImageId>& imageIds) {
+  const unsigned generation = ++m_generation;
+  if (imageIds.empty()) {
+    return;
+  }
+
+  unsigned epoch;
+  {
+    const QMutexLocker locker(&m_mutex);
+    epoch = m_epoch;
+  }
+
+  auto task = std::make_shared<LoadTask>(*this, imageIds, generation, epoch);
+  ImageViewBase::backgroundExecutor().enqueueTask(task, BackgroundExecutor::PREFETCH_LANE, this);
+}
+
+QImage ImagePrefetcher::find(const ImageId& imageId) {
+  const QMutexLocker locker(&m_mutex);
+
+  const auto it = std::find_if(m_entries.begin(), m_entries.end(),
+                               [&imageId](const Entry& entry) { return entry.imageId == imageId; });
+  if (it == m_entries.end()) {
+    return QImage();
+  }
+  if (!isUpToDate(*it)) {
+    m_byteCount -= imageByteCount(it->image);
+    m_entries.erase(it);
+    return QImage();
+  }
+
+  m_entries.splice(m_entries.begin(), m_entries, it);
+  return it->image;
+}
+
+void ImagePrefetcher::clear() {
+  ++m_generation;
+
+  const QMutexLocker locker(&m_mutex);
+  ++m_epoch;
+  m_entries.clear();
+  m_byteCount = 0;
+}
+
+ImagePrefetcher::Entry ImagePrefetcher::stampedEntry(const ImageId& imageId) {
+  const QFileInfo fileInfo(imageId.filePath());
+  return Entry{imageId, fileInfo.lastModified(), fileInfo.size(), QImage()};
+}
+
+bool ImagePrefetcher::isUpToDate(const Entry& entry) {
+  const QFileInfo fileInfo(entry.imageId.filePath());
+  return fileInfo.exists() && (fileInfo.lastModified() == entry.lastModified) && (fileInfo.size() == entry.fileSize);
+}
+
+bool ImagePrefetcher::contains(const ImageId& imageId) {
+  const QMutexLocker locker(&m_mutex);
+  return std::any_of(m_entries.begin(), m_entries.end(),
+                     [&imageId](const Entry& entry) { return entry.imageId == imageId; });
+}
+
+void ImagePrefetcher::store(const Entry& entry, const unsigned epoch) {
+  const QMutexLocker locker(&m_mutex);
+  if (m_epoch != epoch) {
+    // Cleared while we were loading.
+    return;
+  }
+
+  const size_t byteCount = imageByteCount(entry.image);
+  if (byteCount > MAX_CACHED_BYTES) {
+    return;
+  }
+
+  for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+    if (it->imageId == entry.imageId) {
+      m_byteCount -= imageByteCount(it->image);
+      m_entries.erase(it);
+      break;
+    }
+  }
+  m_entries.push_front(entry);
+  m_byteCount += byteCount;
+  while (m_byteCount > MAX_CACHED_BYTES) {
+    m_byteCount -= imageByteCount(m_entries.back().image);
+    m_entries.pop_back();
+  }
+}
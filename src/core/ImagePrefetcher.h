@@ -0,0 +1,89 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#ifndef SCANTAILOR_CORE_IMAGEPREFETCHER_H_
+#define SCANTAILOR_CORE_IMAGEPREFETCHER_H_
+
+#include <QDateTime>
+#include <QImage>
+#include <QMutex>
+#include <atomic>
+#include <list>
+#include <vector>
+
+#include "ImageId.h"
+#include "NonCopyable.h"
+
+/**
+ * \brief Loads the images of pages the user is likely to visit next.
+ *
+ * When browsing through a project, a good part of the time it takes to
+ * display a page goes into loading and decoding its source image.  Once
+ * a page is displayed, the images of the adjacent pages are loaded in
+ * the background and kept in a cache limited by memory, which LoadFileTask
+ * consults before going to the disk.
+ *
+ * A cached image is discarded if its file was modified since it was loaded.
+ * All methods may be called from any thread.
+ */
+class ImagePrefetcher {
+  DECLARE_NON_COPYABLE(ImagePrefetcher)
+
+ public:
+  static ImagePrefetcher& instance();
+
+  /**
+   * \brief Schedules loading of the given images at a low priority.
+   *
+   * Images requested by a previous call but not loaded yet are
+   * no longer going to be loaded.
+   */
+  void prefetch(const std::vector<ImageId>& imageIds);
+
+  /**
+   * \brief Returns a prefetched image, or a null image if it's not cached.
+   */
+  QImage find(const ImageId& imageId);
+
+  /**
+   * \brief Discards the cached images and the pending prefetch requests.
+   */
+  void clear();
+
+ private:
+  class LoadTask;
+
+  struct Entry {
+    ImageId imageId;
+    QDateTime lastModified;
+    qint64 fileSize;
+    QImage image;
+  };
+
+  ImagePrefetcher();
+
+  static Entry stampedEntry(const ImageId& imageId);
+
+  static bool isUpToDate(const Entry& entry);
+
+  bool contains(const ImageId& imageId);
+
+  void store(const Entry& entry, unsigned epoch);
+
+  QMutex m_mutex;
+
+  /** The most recently used entries are at the front. */
+  std::list<Entry> m_entries;
+
+  /** The memory occupied by the cached images.  Protected by m_mutex. */
+  size_t m_byteCount;
+
+  /** Incremented by clear().  Protected by m_mutex. */
+  unsigned m_epoch;
+
+  /** Incremented whenever pending requests become obsolete. */
+  std::atomic<unsigned> m_generation;
+};
+
+
+#endif  // ifndef SCANTAILOR_CORE_IMAGEPREFETCHER_H_
@@ -0,0 +1,88 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#include "ImagePyramid.h"
+
+#include <Transform.h>
+
+#include <algorithm>
+#include <cassert>
+
+#include "Dpm.h"
+
+using namespace imageproc;
+
+namespace {
+/**
+ * Levels whose larger side would be below that are not generated.
+ */
+const int MIN_LEVEL_SIZE = 512;
+
+QImage downscale(const QImage& image, const int dstWidth, const int dstHeight) {
+  QTransform xform;
+  xform.scale((double) dstWidth / image.width(), (double) dstHeight / image.height());
+  return transform(image, xform, QRect(0, 0, dstWidth, dstHeight), OutsidePixels::assumeColor(Qt::white));
+}
+
+QImage createFirstLevel(const QImage& image) {
+  // Original and downscaled DPM.
+  const Dpm oDpm(image);
+  const Dpm dDpm(Dpi(200, 200));
+
+  const int oW = image.width();
+  const int oH = image.height();
+
+  int dW = oW * dDpm.horizontal() / oDpm.horizontal();
+  int dH = oH * dDpm.vertical() / oDpm.vertical();
+  dW = qBound(1, dW, oW);
+  dH = qBound(1, dH, oH);
+
+  if ((dW * 1.2 > oW) || (dH * 1.2 > oH)) {
+    // Sizes are close - no point in downscaling.
+    return image;
+  }
+  return downscale(image, dW, dH);
+}
+}  // namespace
+
+ImagePyramid::ImagePyramid(const QImage& image) : m_sourceSize(image.size()), m_byteCount(0) {
+  assert(!image.isNull());
+
+  m_levels.push_back(createFirstLevel(image));
+  while (true) {
+    const QImage& prev = m_levels.back();
+    const int dW = prev.width() / 2;
+    const int dH = prev.height() / 2;
+    if (std::max(dW, dH) < MIN_LEVEL_SIZE || std::min(dW, dH) < 1) {
+      break;
+    }
+    m_levels.push_back(downscale(prev, dW, dH));
+  }
+
+  for (const QImage& level : m_levels) {
+    m_byteCount += static_cast<size_t>(level.bytesPerLine()) * level.height();
+  }
+}
+
+QImage ImagePyramid::levelForScale(const double scale, QTransform& imageToLevel) const {
+  const QImage* chosen = nullptr;
+  for (const QImage& level : m_levels) {
+    if (level.size() == m_sourceSize) {
+      continue;  // Not a downscaled version.
+    }
+    const double levelScale = std::min((double) level.width() / m_sourceSize.width(),
+                                       (double) level.height() / m_sourceSize.height());
+    if (levelScale < scale) {
+      break;
+    }
+    chosen = &level;
+  }
+
+  if (!chosen) {
+    return QImage();
+  }
+
+  imageToLevel = QTransform().scale((double) chosen->width() / m_sourceSize.width(),
+                                    (double) chosen->height() / m_sourceSize.height());
+  return *chosen;
+}
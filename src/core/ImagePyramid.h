@@ -0,0 +1,62 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#ifndef SCANTAILOR_CORE_IMAGEPYRAMID_H_
+#define SCANTAILOR_CORE_IMAGEPYRAMID_H_
+
+#include <QImage>
+#include <QSize>
+#include <QTransform>
+#include <cstddef>
+#include <vector>
+
+#include "NonCopyable.h"
+
+/**
+ * \brief A sequence of progressively downscaled versions of an image.
+ *
+ * The first level is the one displayed by image views in real time
+ * (see ImageViewBase::createDownscaledImage()), each of the next ones
+ * is half the size of the previous one.  The levels preserve the kind
+ * of the source image: grayscale images produce grayscale levels,
+ * while color ones produce color levels.
+ */
+class ImagePyramid {
+  DECLARE_NON_COPYABLE(ImagePyramid)
+
+ public:
+  /**
+   * \param image The source image, not null, and with DPI set correctly.
+   */
+  explicit ImagePyramid(const QImage& image);
+
+  /**
+   * \brief The first level.  May be the source image itself,
+   *        if it's small enough already.
+   */
+  const QImage& downscaledImage() const { return m_levels.front(); }
+
+  /**
+   * \brief Picks the smallest level that still has enough resolution to be
+   *        displayed at the given scale.
+   *
+   * \param scale The ratio of the displayed size to the size of the source image.
+   * \param[out] imageToLevel Set to the transformation from source image coordinates
+   *             to the coordinates of the returned level.
+   * \return The chosen level or a null image, if none of the levels is detailed enough.
+   */
+  QImage levelForScale(double scale, QTransform& imageToLevel) const;
+
+  /**
+   * \brief The amount of memory occupied by all levels.
+   */
+  size_t byteCount() const { return m_byteCount; }
+
+ private:
+  QSize m_sourceSize;
+  std::vector<QImage> m_levels;
+  size_t m_byteCount;
+};
+
+
+#endif  // ifndef SCANTAILOR_CORE_IMAGEPYRAMID_H_
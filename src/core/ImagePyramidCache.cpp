@@ -0,0 +1,148 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#include "ImagePyramidCache.h"
+
+#include <QMutexLocker>
+#include <algorithm>
+
+namespace {
+/**
+ * The amount of memory the cache tries not to exceed.
+ * Pyramids that are still in use by image views are not accounted for.
+ */
+const size_t MAX_CACHED_BYTES = 128 * 1024 * 1024;
+
+/**
+ * The number of evenly spaced lines to take into account when fingerprinting an image.
+ */
+const int FINGERPRINT_LINES = 64;
+
+/**
+ * The number of QImage::cacheKey() values to remember per entry.
+ */
+const size_t MAX_CACHE_KEYS = 8;
+}  // namespace
+
+ImagePyramidCache::ImagePyramidCache() : m_byteCount(0) {}
+
+ImagePyramidCache& ImagePyramidCache::instance() {
+  static ImagePyramidCache object;
+  return object;
+}
+
+std::shared_ptr<const ImagePyramid> ImagePyramidCache::pyramidFor(const QImage& image, const ImageId& sourceId) {
+  const SourceKey sourceKey = sourceId.isNull() ? SourceKey() : SourceKey(sourceId, image);
+  {
+    const QMutexLocker locker(&m_mutex);
+
+    auto it = findByCacheKey(image.cacheKey());
+    if ((it == m_entries.end()) && !sourceKey.isNull()) {
+      it = findBySource(sourceKey);
+    }
+    if (it != m_entries.end()) {
+      touch(it, image.cacheKey());
+      Entry& entry = m_entries.front();
+      if (entry.sourceKey.isNull()) {
+        // The pyramid was built for the same QImage before its source was known.
+        entry.sourceKey = sourceKey;
+      }
+      return entry.pyramid;
+    }
+  }
+
+  // Building a pyramid takes a while, so we do it without holding the lock.
+  // Should another thread build the same pyramid concurrently, one of them is just discarded.
+  auto pyramid = std::make_shared<const ImagePyramid>(image);
+
+  const QMutexLocker locker(&m_mutex);
+
+  m_entries.push_front(Entry{sourceKey, {image.cacheKey()}, pyramid});
+  m_byteCount += pyramid->byteCount();
+  removeExcessEntries();
+  return pyramid;
+}
+
+std::shared_ptr<const ImagePyramid> ImagePyramidCache::find(const QImage& image) {
+  const QMutexLocker locker(&m_mutex);
+
+  const auto it = findByCacheKey(image.cacheKey());
+  if (it == m_entries.end()) {
+    return nullptr;
+  }
+  touch(it, image.cacheKey());
+  return m_entries.front().pyramid;
+}
+
+/**
+ * A cheap check that a reloaded image still has the same content.
+ * It protects against the image file being replaced on disk.
+ */
+uint64_t ImagePyramidCache::fingerprint(const QImage& image) {
+  // FNV-1a
+  uint64_t hash = 14695981039346656037ULL;
+  const auto feed = [&hash](const uchar* data, const int len) {
+    for (int i = 0; i < len; ++i) {
+      hash = (hash ^ data[i]) * 1099511628211ULL;
+    }
+  };
+
+  const int height = image.height();
+  const int lineBytes = (image.width() * image.depth() + 7) / 8;
+  const int step = std::max(1, height / FINGERPRINT_LINES);
+  for (int y = 0; y < height; y += step) {
+    feed(image.constScanLine(y), lineBytes);
+  }
+
+  const int dpm[] = {image.dotsPerMeterX(), image.dotsPerMeterY()};
+  feed(reinterpret_cast<const uchar*>(dpm), sizeof(dpm));
+  return hash;
+}
+
+std::list<ImagePyramidCache::Entry>::iterator ImagePyramidCache::findBySource(const SourceKey& sourceKey) {
+  return std::find_if(m_entries.begin(), m_entries.end(),
+                      [&sourceKey](const Entry& entry) { return entry.sourceKey == sourceKey; });
+}
+
+std::list<ImagePyramidCache::Entry>::iterator ImagePyramidCache::findByCacheKey(const qint64 cacheKey) {
+  return std::find_if(m_entries.begin(), m_entries.end(), [cacheKey](const Entry& entry) {
+    return std::find(entry.cacheKeys.begin(), entry.cacheKeys.end(), cacheKey) != entry.cacheKeys.end();
+  });
+}
+
+/**
+ * Moves the entry to the front of the list and associates it with
+ * the given QImage::cacheKey().
+ */
+void ImagePyramidCache::touch(const std::list<Entry>::iterator it, const qint64 cacheKey) {
+  m_entries.splice(m_entries.begin(), m_entries, it);
+
+  std::vector<qint64>& cacheKeys = m_entries.front().cacheKeys;
+  if (std::find(cacheKeys.begin(), cacheKeys.end(), cacheKey) == cacheKeys.end()) {
+    if (cacheKeys.size() >= MAX_CACHE_KEYS) {
+      cacheKeys.erase(cacheKeys.begin());
+    }
+    cacheKeys.push_back(cacheKey);
+  }
+}
+
+void ImagePyramidCache::removeExcessEntries() {
+  // The most recently used entry is always kept.
+  while (m_byteCount > MAX_CACHED_BYTES && m_entries.size() > 1) {
+    m_byteCount -= m_entries.back().pyramid->byteCount();
+    m_entries.pop_back();
+  }
+}
+
+/*========================= ImagePyramidCache::SourceKey =======================*/
+
+ImagePyramidCache::SourceKey::SourceKey(const ImageId& sourceId, const QImage& image)
+    : sourceId(sourceId),
+      size(image.size()),
+      format(image.format()),
+      fingerprint(ImagePyramidCache::fingerprint(image)) {}
+
+bool ImagePyramidCache::SourceKey::operator==(const SourceKey& other) const {
+  return !isNull() && sourceId == other.sourceId && size == other.size && format == other.format
+         && fingerprint == other.fingerprint;
+}
@@ -0,0 +1,104 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#ifndef SCANTAILOR_CORE_IMAGEPYRAMIDCACHE_H_
+#define SCANTAILOR_CORE_IMAGEPYRAMIDCACHE_H_
+
+#include <QImage>
+#include <QMutex>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <vector>
+
+#include "ImageId.h"
+#include "ImagePyramid.h"
+#include "NonCopyable.h"
+
+/**
+ * \brief A process-wide, memory bounded cache of image pyramids.
+ *
+ * Pyramids of source images are identified by the ImageId of the file they
+ * were loaded from along with the properties and the fingerprint of the loaded
+ * image, so they survive reloading the image, for example when switching
+ * between stages.
+ * Other images are only identified by QImage::cacheKey(), which allows
+ * sharing a pyramid between several views of the same image.
+ *
+ * All methods may be called from any thread.
+ */
+class ImagePyramidCache {
+  DECLARE_NON_COPYABLE(ImagePyramidCache)
+
+ public:
+  static ImagePyramidCache& instance();
+
+  /**
+   * \brief Returns the pyramid of the given image, building it if necessary.
+   *
+   * \param image The image, not null, and with DPI set correctly.
+   * \param sourceId The image file \p image was loaded from, if any.
+   */
+  std::shared_ptr<const ImagePyramid> pyramidFor(const QImage& image, const ImageId& sourceId = ImageId());
+
+  /**
+   * \brief Returns the pyramid previously returned by pyramidFor() for
+   *        the same QImage (or a copy of it), or null if there is none.
+   */
+  std::shared_ptr<const ImagePyramid> find(const QImage& image);
+
+  /**
+   * \brief A cheap hash of a sample of the image lines, along with the image DPI.
+   *
+   * Telling apart the images of the same source file is all it is good for,
+   * so it's never compared without the ImageId of that file.
+   */
+  static uint64_t fingerprint(const QImage& image);
+
+ private:
+  /**
+   * \brief Identifies an image loaded from a file.
+   *
+   * A null one, as used for images not loaded from a file, matches nothing.
+   */
+  struct SourceKey {
+    SourceKey() : format(QImage::Format_Invalid), fingerprint(0) {}
+
+    SourceKey(const ImageId& sourceId, const QImage& image);
+
+    bool isNull() const { return sourceId.isNull(); }
+
+    bool operator==(const SourceKey& other) const;
+
+    ImageId sourceId;
+    QSize size;
+    QImage::Format format;
+    uint64_t fingerprint;
+  };
+
+  struct Entry {
+    SourceKey sourceKey;
+    std::vector<qint64> cacheKeys;
+    std::shared_ptr<const ImagePyramid> pyramid;
+  };
+
+  ImagePyramidCache();
+
+  std::list<Entry>::iterator findBySource(const SourceKey& sourceKey);
+
+  std::list<Entry>::iterator findByCacheKey(qint64 cacheKey);
+
+  void touch(std::list<Entry>::iterator it, qint64 cacheKey);
+
+  void removeExcessEntries();
+
+  QMutex m_mutex;
+
+  /** The most recently used entries are at the front. */
+  std::list<Entry> m_entries;
+  size_t m_byteCount;
+};
+
+
+#endif  // ifndef SCANTAILOR_CORE_IMAGEPYRAMIDCACHE_H_
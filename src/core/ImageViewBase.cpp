@@ -3,6 +3,7 @@
 
 #include "ImageViewBase.h"
 
+#include <GrayImage.h>
 #include <PolygonUtils.h>
 #include <Transform.h>
 
@@ -16,6 +17,8 @@
 #endif
 
 #include <QMouseEvent>
+#include <QMutex>
+#include <QMutexLocker>
 #include <QPaintEngine>
 #include <QPainter>
 #include <QPainterPath>
@@ -23,12 +26,16 @@
 #include <QScrollBar>
 #include <QtWidgets/QMainWindow>
 #include <QtWidgets/QStatusBar>
+#include <algorithm>
+#include <cmath>
 
 #include "ApplicationSettings.h"
 #include "BackgroundExecutor.h"
 #include "ColorSchemeManager.h"
 #include "Dpm.h"
 #include "ImagePresentation.h"
+#include "ImagePyramid.h"
+#include "ImagePyramidCache.h"
 #include "OpenGLSupport.h"
 #include "PixmapRenderer.h"
 #include "ScopedIncDec.h"
@@ -38,22 +45,111 @@
 using namespace core;
 using namespace imageproc;
 
+namespace {
+/**
+ * The size of a side of a high quality tile, in widget pixels.
+ */
+const int HQ_TILE_SIZE = 256;
+
+/**
+ * The number of zoom levels to keep high quality tiles for.
+ */
+const size_t MAX_HQ_TILE_SETS = 3;
+
+/**
+ * The number of high quality tiles we try not to exceed across all zoom levels.
+ * The tiles covering the viewport are kept regardless.
+ */
+const size_t MAX_HQ_TILES = 256;
+
+int floorDiv(const int dividend, const int divisor) {
+  const int quotient = dividend / divisor;
+  return (dividend % divisor < 0) ? quotient - 1 : quotient;
+}
+
+/**
+ * Converts the image to a format imageproc::transform() would convert it to anyway.
+ */
+QImage toHqSourceFormat(const QImage& image) {
+  switch (image.format()) {
+    case QImage::Format_Indexed8:
+    case QImage::Format_Mono:
+    case QImage::Format_MonoLSB:
+      if (image.allGray()) {
+        return GrayImage(image).toQImage();
+      }
+      break;
+    default:
+      break;
+  }
+  return image.convertToFormat(image.hasAlphaChannel() ? QImage::Format_ARGB32 : QImage::Format_RGB32);
+}
+}  // namespace
+
+/**
+ * \brief An image the high quality tiles are rendered from.
+ *
+ * It's converted by toHqSourceFormat() in the background, by the first tile
+ * that needs it.  Should the next tile need it before that's done, it waits
+ * for the conversion rather than doing it once again.
+ */
+class ImageViewBase::HqSource {
+  DECLARE_NON_COPYABLE(HqSource)
+
+ public:
+  explicit HqSource(const QImage& image) : m_image(image) {}
+
+  QImage converted() {
+    const QMutexLocker locker(&m_mutex);
+    if (m_converted.isNull()) {
+      m_converted = toHqSourceFormat(m_image);
+      m_image = QImage();
+    }
+    return m_converted;
+  }
+
+ private:
+  QMutex m_mutex;
+  QImage m_image;
+  QImage m_converted;
+};
+
+
+/**
+ * \brief Renders a single high quality tile.
+ */
 class ImageViewBase::HqTransformTask : public AbstractCommand<std::shared_ptr<AbstractCommand<void>>>, public QObject {
   DECLARE_NON_COPYABLE(HqTransformTask)
 
  public:
-  HqTransformTask(ImageViewBase* imageView, const QImage& image, const QTransform& xform, const QSize& targetSize);
+  /**
+   * \param imageView The view to deliver the tile to.
+   * \param source The image to render from, shared with the other tiles.
+   * \param sourceToTile Transformation from \p source coordinates to tile space.
+   * \param tileXform Transformation from the view's image coordinates to tile space.
+   *        It identifies the zoom level the tile belongs to.
+   * \param tileIdx The (column, row) of the tile.
+   * \param tileRect The area of tile space to render.
+   */
+  HqTransformTask(ImageViewBase* imageView,
+                  std::shared_ptr<HqSource> source,
+                  const QTransform& sourceToTile,
+                  const QTransform& tileXform,
+                  const std::pair<int, int>& tileIdx,
+                  const QRect& tileRect);
 
   void cancel() { m_result->cancel(); }
 
   bool isCancelled() const { return m_result->isCancelled(); }
 
+  const QTransform& tileXform() const { return m_tileXform; }
+
   std::shared_ptr<AbstractCommand<void>> operator()() override;
 
  private:
   class Result : public AbstractCommand<void> {
    public:
-    explicit Result(ImageViewBase* imageView);
+    Result(ImageViewBase* imageView, const QTransform& tileXform, const std::pair<int, int>& tileIdx);
 
     void setData(const QPoint& origin, const QImage& hqImage);
 
@@ -65,16 +161,51 @@ class ImageViewBase::HqTransformTask : public AbstractCommand<std::shared_ptr<Ab
 
    private:
     QPointer<ImageViewBase> m_imageView;
+    QTransform m_tileXform;
+    std::pair<int, int> m_tileIdx;
     QPoint m_origin;
     QImage m_hqImage;
     mutable QAtomicInt m_cancelFlag;
   };
 
 
+  std::shared_ptr<Result> m_result;
+  std::shared_ptr<HqSource> m_source;
+  QTransform m_sourceToTile;
+  QTransform m_tileXform;
+  QRect m_tileRect;
+};
+
+
+/**
+ * \brief Builds the pyramid of a view's image and hands it to the view.
+ */
+class ImageViewBase::PyramidTask : public AbstractCommand<std::shared_ptr<AbstractCommand<void>>> {
+  DECLARE_NON_COPYABLE(PyramidTask)
+
+ public:
+  PyramidTask(ImageViewBase* imageView, const QImage& image)
+      : m_result(std::make_shared<Result>(imageView)), m_image(image) {}
+
+  std::shared_ptr<AbstractCommand<void>> operator()() override;
+
+ private:
+  class Result : public AbstractCommand<void> {
+   public:
+    explicit Result(ImageViewBase* imageView) : m_imageView(imageView) {}
+
+    void setPyramid(std::shared_ptr<const ImagePyramid> pyramid) { m_pyramid = std::move(pyramid); }
+
+    void operator()() override;
+
+   private:
+    QPointer<ImageViewBase> m_imageView;
+    std::shared_ptr<const ImagePyramid> m_pyramid;
+  };
+
+
   std::shared_ptr<Result> m_result;
   QImage m_image;
-  QTransform m_xform;
-  QSize m_targetSize;
 };
 
 
@@ -163,16 +294,20 @@ ImageViewBase::ImageViewBase(const QImage& image,
   setFrameShape(QFrame::NoFrame);
   viewport()->setFocusPolicy(Qt::WheelFocus);
 
-  if (downscaledVersion.isNull()) {
-    m_pixmap = QPixmap::fromImage(createDownscaledImage(image));
-  } else if (downscaledVersion.pixmap().isNull()) {
-    m_pixmap = QPixmap::fromImage(downscaledVersion.image());
+  m_pyramid = ImagePyramidCache::instance().find(image);
+  if (!downscaledVersion.isNull()) {
+    setPixmap(downscaledVersion.pixmap().isNull() ? QPixmap::fromImage(downscaledVersion.image())
+                                                  : downscaledVersion.pixmap());
+  } else if (m_pyramid) {
+    setPixmap(QPixmap::fromImage(m_pyramid->downscaledImage()));
   } else {
-    m_pixmap = downscaledVersion.pixmap();
+    // Building the pyramid of a large image takes a while, so we don't do it on the GUI thread.
+    setPixmap(QPixmap::fromImage(image));
+    backgroundExecutor().enqueueTask(std::make_shared<PyramidTask>(this, image),
+                                     BackgroundExecutor::VIEW_RENDERING_LANE, nullptr,
+                                     BackgroundExecutor::VISIBLE_PRIORITY);
   }
 
-  m_pixmapToImage.scale((double) m_image.width() / m_pixmap.width(), (double) m_image.height() / m_pixmap.height());
-
   m_widgetFocalPoint = centeredWidgetFocalPoint();
   m_pixmapFocalPoint = m_virtualToImage.map(virtualDisplayRect().center());
 
@@ -214,8 +349,9 @@ void ImageViewBase::hqTransformSetEnabled(const bool enabled) {
       m_hqTransformTask->cancel();
       m_hqTransformTask.reset();
     }
-    if (!m_hqPixmap.isNull()) {
-      m_hqPixmap = QPixmap();
+    m_hqSources.clear();
+    if (!m_hqTileSets.empty()) {
+      m_hqTileSets.clear();
       update();
     }
   } else if (enabled && !m_hqTransformEnabled) {
@@ -225,29 +361,9 @@ void ImageViewBase::hqTransformSetEnabled(const bool enabled) {
   }
 }
 
-QImage ImageViewBase::createDownscaledImage(const QImage& image) {
+QImage ImageViewBase::createDownscaledImage(const QImage& image, const ImageId& sourceId) {
   assert(!image.isNull());
-
-  // Original and downscaled DPM.
-  const Dpm oDpm(image);
-  const Dpm dDpm(Dpi(200, 200));
-
-  const int oW = image.width();
-  const int oH = image.height();
-
-  int dW = oW * dDpm.horizontal() / oDpm.horizontal();
-  int dH = oH * dDpm.vertical() / oDpm.vertical();
-  dW = qBound(1, dW, oW);
-  dH = qBound(1, dH, oH);
-
-  if ((dW * 1.2 > oW) || (dH * 1.2 > oH)) {
-    // Sizes are close - no point in downscaling.
-    return image;
-  }
-
-  QTransform xform;
-  xform.scale((double) dW / oW, (double) dH / oH);
-  return transform(image, xform, QRect(0, 0, dW, dH), OutsidePixels::assumeColor(Qt::white));
+  return ImagePyramidCache::instance().pyramidFor(image, sourceId)->downscaledImage();
 }
 
 QRectF ImageViewBase::maxViewportRect() const {
@@ -408,17 +524,17 @@ void ImageViewBase::paintEvent(QPaintEvent* event) {
   // Disable antialiasing for large zoom levels.
   painter.setRenderHint(QPainter::SmoothPixmapTransform, pixelWidth < 0.5);
 
-  if (validateHqPixmap()) {
-    // HQ pixmap maps one to one to screen pixels, so antialiasing is not necessary.
-    painter.setRenderHint(QPainter::SmoothPixmapTransform, false);
+  QPoint hqOffset;
+  const QTransform tileXform(hqTileXform(hqOffset));
+  const HqTileSet* const tileSet = m_hqTransformEnabled ? findHqTileSet(tileXform) : nullptr;
 
-    QPainterPath clipPath;
-    clipPath.addPolygon(m_virtualToWidget.map(m_virtualImageCropArea));
-    painter.setClipPath(clipPath);
+  if (!tileSet || !missingHqTiles(*tileSet, hqOffset, false).empty()) {
+    if (m_hqTransformEnabled) {
+      scheduleHqVersionRebuild();
+    }
 
-    painter.drawPixmap(m_hqPixmapPos, m_hqPixmap);
-  } else {
-    scheduleHqVersionRebuild();
+    // Tiles that aren't ready yet are substituted by the low quality version.
+    painter.save();
 
     const QTransform pixmapToVirtual(m_pixmapToImage * m_imageToVirtual);
     painter.setWorldTransform(pixmapToVirtual * m_virtualToWidget);
@@ -428,6 +544,26 @@ void ImageViewBase::paintEvent(QPaintEvent* event) {
     painter.setClipPath(clipPath);
 
     PixmapRenderer::drawPixmap(painter, m_pixmap);
+
+    painter.restore();
+  }
+
+  if (tileSet) {
+    // HQ tiles map one to one to screen pixels, so antialiasing is not necessary.
+    painter.setRenderHint(QPainter::SmoothPixmapTransform, false);
+
+    QPainterPath clipPath;
+    clipPath.addPolygon(m_virtualToWidget.map(m_virtualImageCropArea));
+    painter.setClipPath(clipPath);
+
+    const QRect exposedRect(event->rect());
+    for (const auto& idxAndTile : tileSet->tiles) {
+      const HqTile& tile = idxAndTile.second;
+      const QRect tileWidgetRect(tile.origin + hqOffset, tile.pixmap.size());
+      if (tileWidgetRect.intersects(exposedRect)) {
+        painter.drawPixmap(tileWidgetRect.topLeft(), tile.pixmap);
+      }
+    }
   }
 
   painter.restore();
@@ -576,6 +712,14 @@ void ImageViewBase::showEvent(QShowEvent* event) {
 
 void ImageViewBase::hideEvent(QHideEvent* event) {
   infoProvider().removeAllListeners();
+  // A hidden view doesn't need to render tiles.  The missing ones
+  // will be scheduled on the next paint event after the view is shown again.
+  if (m_hqTransformTask) {
+    m_hqTransformTask->cancel();
+    m_hqTransformTask.reset();
+  }
+  m_timer.stop();
+  m_hqSources.clear();
   QWidget::hideEvent(event);
 }
 
@@ -891,74 +1035,278 @@ void ImageViewBase::setWidgetFocalPointWithoutMoving(const QPointF newWidgetFp)
 }
 
 /**
- * Returns true if m_hqPixmap is valid and up to date.
+ * Splits the image to widget transformation into a transformation to tile space
+ * and an integer offset from tile space to widget coordinates.
+ * The fractional part of the translation is quantized, so that panning
+ * by whole pixels yields the same tile space transformation.
  */
-bool ImageViewBase::validateHqPixmap() const {
-  if (!m_hqTransformEnabled) {
-    return false;
-  }
+QTransform ImageViewBase::hqTileXform(QPoint& widgetOffset) const {
+  const QTransform xform(m_imageToVirtual * m_virtualToWidget);
+  const double dx = std::floor(xform.dx());
+  const double dy = std::floor(xform.dy());
+  widgetOffset = QPoint(static_cast<int>(dx), static_cast<int>(dy));
+
+  const double fracDx = std::round((xform.dx() - dx) * 64.0) / 64.0;
+  const double fracDy = std::round((xform.dy() - dy) * 64.0) / 64.0;
+  return QTransform(xform.m11(), xform.m12(), xform.m21(), xform.m22(), fracDx, fracDy);
+}
 
-  if (m_hqPixmap.isNull()) {
-    return false;
+/**
+ * Returns the range of (column, row) tile indexes intersecting the viewport
+ * extended by \p margin tiles in each direction and limited to the image area.
+ */
+QRect ImageViewBase::hqTileRange(const QTransform& tileXform, const QPoint& widgetOffset, const int margin) const {
+  const QRect imageRect(tileXform.mapRect(QRectF(m_image.rect())).toAlignedRect());
+  const QRect viewportRect(viewport()->rect().translated(-widgetOffset));
+  const QRect area(imageRect.intersected(viewportRect.adjusted(-margin * HQ_TILE_SIZE, -margin * HQ_TILE_SIZE,
+                                                               margin * HQ_TILE_SIZE, margin * HQ_TILE_SIZE)));
+  if (area.isEmpty()) {
+    return QRect();
   }
+  return QRect(QPoint(floorDiv(area.left(), HQ_TILE_SIZE), floorDiv(area.top(), HQ_TILE_SIZE)),
+               QPoint(floorDiv(area.right(), HQ_TILE_SIZE), floorDiv(area.bottom(), HQ_TILE_SIZE)));
+}
+
+QRect ImageViewBase::hqTileRect(const QTransform& tileXform, const int column, const int row) const {
+  const QRect imageRect(tileXform.mapRect(QRectF(m_image.rect())).toAlignedRect());
+  return QRect(column * HQ_TILE_SIZE, row * HQ_TILE_SIZE, HQ_TILE_SIZE, HQ_TILE_SIZE).intersected(imageRect);
+}
 
-  if (m_hqSourceId != m_image.cacheKey()) {
-    return false;
+/**
+ * Returns the tiles of the viewport (and, if \p prefetch is set, of a ring
+ * of tiles around it) that are not yet in \p tileSet, ordered by the distance
+ * from the center of the viewport.
+ */
+std::vector<std::pair<int, int>> ImageViewBase::missingHqTiles(const HqTileSet& tileSet,
+                                                               const QPoint& widgetOffset,
+                                                               const bool prefetch) const {
+  QRect range(hqTileRange(tileSet.tileXform, widgetOffset, 0));
+  if (prefetch) {
+    const QRect extendedRange(hqTileRange(tileSet.tileXform, widgetOffset, 1));
+    if (static_cast<size_t>(extendedRange.width() * extendedRange.height()) <= MAX_HQ_TILES) {
+      range = extendedRange;
+    }
   }
 
-  if (m_hqXform != m_imageToVirtual * m_virtualToWidget) {
-    return false;
+  std::vector<std::pair<int, int>> missing;
+  for (int row = range.top(); row <= range.bottom(); ++row) {
+    for (int column = range.left(); column <= range.right(); ++column) {
+      if (tileSet.tiles.find(std::make_pair(column, row)) == tileSet.tiles.end()) {
+        missing.emplace_back(column, row);
+      }
+    }
   }
-  return true;
+
+  const QPointF center(QRectF(viewport()->rect()).center() - widgetOffset);
+  const auto distSq = [center](const std::pair<int, int>& idx) {
+    const double dx = (idx.first + 0.5) * HQ_TILE_SIZE - center.x();
+    const double dy = (idx.second + 0.5) * HQ_TILE_SIZE - center.y();
+    return dx * dx + dy * dy;
+  };
+  std::sort(missing.begin(), missing.end(),
+            [&distSq](const std::pair<int, int>& lhs, const std::pair<int, int>& rhs) {
+              return distSq(lhs) < distSq(rhs);
+            });
+  return missing;
 }
 
-void ImageViewBase::scheduleHqVersionRebuild() {
-  const QTransform xform(m_imageToVirtual * m_virtualToWidget);
+const ImageViewBase::HqTileSet* ImageViewBase::findHqTileSet(const QTransform& tileXform) const {
+  for (const HqTileSet& tileSet : m_hqTileSets) {
+    if (tileSet.tileXform == tileXform) {
+      return &tileSet;
+    }
+  }
+  return nullptr;
+}
 
-  if (!m_timer.isActive() || (m_potentialHqXform != xform)) {
-    if (m_hqTransformTask) {
-      m_hqTransformTask->cancel();
-      m_hqTransformTask.reset();
+/**
+ * Returns the tile set for the given zoom level, creating it if necessary.
+ * The tile set is moved to the front of m_hqTileSets, and the least recently
+ * used zoom levels beyond MAX_HQ_TILE_SETS are discarded.
+ */
+ImageViewBase::HqTileSet& ImageViewBase::obtainHqTileSet(const QTransform& tileXform) {
+  auto it = m_hqTileSets.begin();
+  for (; it != m_hqTileSets.end(); ++it) {
+    if (it->tileXform == tileXform) {
+      break;
     }
-    m_potentialHqXform = xform;
   }
-  m_timer.start();
+
+  if (it == m_hqTileSets.end()) {
+    m_hqTileSets.emplace_front();
+    m_hqTileSets.front().tileXform = tileXform;
+  } else if (it != m_hqTileSets.begin()) {
+    m_hqTileSets.splice(m_hqTileSets.begin(), m_hqTileSets, it);
+  }
+
+  while (m_hqTileSets.size() > MAX_HQ_TILE_SETS) {
+    m_hqTileSets.pop_back();
+  }
+  return m_hqTileSets.front();
 }
 
-void ImageViewBase::initiateBuildingHqVersion() {
-  if (validateHqPixmap()) {
+/**
+ * Discards tiles until we fit MAX_HQ_TILES, starting with the least recently
+ * used zoom levels and continuing with the tiles farthest from the viewport.
+ * The tiles that would be (pre)fetched for the current viewport are never discarded.
+ */
+void ImageViewBase::trimHqTileCache(const QPoint& widgetOffset) {
+  size_t numTiles = 0;
+  for (const HqTileSet& tileSet : m_hqTileSets) {
+    numTiles += tileSet.tiles.size();
+  }
+
+  while (numTiles > MAX_HQ_TILES && m_hqTileSets.size() > 1) {
+    numTiles -= m_hqTileSets.back().tiles.size();
+    m_hqTileSets.pop_back();
+  }
+  if (numTiles <= MAX_HQ_TILES || m_hqTileSets.empty()) {
     return;
   }
 
-  m_hqPixmap = QPixmap();
+  HqTileSet& tileSet = m_hqTileSets.front();
+  QRect keptRange(hqTileRange(tileSet.tileXform, widgetOffset, 1));
+  if (static_cast<size_t>(keptRange.width() * keptRange.height()) > MAX_HQ_TILES) {
+    keptRange = hqTileRange(tileSet.tileXform, widgetOffset, 0);
+  }
+
+  const QPoint center(keptRange.center());
+  std::vector<std::pair<int, int>> evictable;
+  for (const auto& idxAndTile : tileSet.tiles) {
+    if (!keptRange.contains(idxAndTile.first.first, idxAndTile.first.second)) {
+      evictable.push_back(idxAndTile.first);
+    }
+  }
+  const auto distSq = [center](const std::pair<int, int>& idx) {
+    const int dx = idx.first - center.x();
+    const int dy = idx.second - center.y();
+    return dx * dx + dy * dy;
+  };
+  std::sort(evictable.begin(), evictable.end(),
+            [&distSq](const std::pair<int, int>& lhs, const std::pair<int, int>& rhs) {
+              return distSq(lhs) > distSq(rhs);
+            });
+
+  for (const auto& idx : evictable) {
+    if (numTiles <= MAX_HQ_TILES) {
+      break;
+    }
+    tileSet.tiles.erase(idx);
+    --numTiles;
+  }
+}  // ImageViewBase::trimHqTileCache
+
+void ImageViewBase::scheduleHqVersionRebuild() {
+  QPoint widgetOffset;
+  const QTransform tileXform(hqTileXform(widgetOffset));
 
   if (m_hqTransformTask) {
+    if (m_hqTransformTask->tileXform() == tileXform) {
+      // A tile for this zoom level is being rendered.  Once it's done,
+      // rendering will continue with the tiles that are still missing.
+      return;
+    }
     m_hqTransformTask->cancel();
     m_hqTransformTask.reset();
   }
 
-  const QTransform xform(m_imageToVirtual * m_virtualToWidget);
-  const auto task = std::make_shared<HqTransformTask>(this, m_image, xform, viewport()->size());
+  // When panning, the tile space stays the same and we let the timer run out.
+  // When zooming, we keep postponing the rendering until zooming stops.
+  if (!m_timer.isActive() || (m_potentialHqXform != tileXform)) {
+    m_potentialHqXform = tileXform;
+    m_timer.start();
+  }
+}
+
+void ImageViewBase::initiateBuildingHqVersion() {
+  if (!m_hqTransformEnabled || m_hqTransformTask || !isVisible()) {
+    return;
+  }
+
+  QPoint widgetOffset;
+  const QTransform tileXform(hqTileXform(widgetOffset));
+  const HqTileSet& tileSet = obtainHqTileSet(tileXform);
+
+  const std::vector<std::pair<int, int>> missing(missingHqTiles(tileSet, widgetOffset, true));
+  if (missing.empty()) {
+    return;
+  }
+
+  QImage source(m_image);
+  QTransform sourceToTile(tileXform);
+  if (m_pyramid) {
+    // When zoomed out, render from the closest downscaled version instead.
+    const double scale = std::sqrt(std::abs(tileXform.determinant()));
+    QTransform imageToLevel;
+    const QImage level(m_pyramid->levelForScale(scale, imageToLevel));
+    if (!level.isNull()) {
+      source = level;
+      sourceToTile = imageToLevel.inverted() * tileXform;
+    }
+  }
 
-  backgroundExecutor().enqueueTask(task);
+  const std::pair<int, int>& tileIdx = missing.front();
+  const auto task = std::make_shared<HqTransformTask>(this, obtainHqSource(source), sourceToTile, tileXform, tileIdx,
+                                                      hqTileRect(tileXform, tileIdx.first, tileIdx.second));
+
+  backgroundExecutor().enqueueTask(task, BackgroundExecutor::VIEW_RENDERING_LANE, this, backgroundTaskPriority());
 
   m_hqTransformTask = task;
-  m_hqXform = xform;
-  m_hqSourceId = m_image.cacheKey();
+}
+
+void ImageViewBase::setPixmap(const QPixmap& pixmap) {
+  m_pixmap = pixmap;
+  m_pixmapToImage.reset();
+  m_pixmapToImage.scale((double) m_image.width() / m_pixmap.width(), (double) m_image.height() / m_pixmap.height());
+}
+
+/**
+ * Gets called from PyramidTask::Result.
+ */
+void ImageViewBase::pyramidBuilt(const std::shared_ptr<const ImagePyramid>& pyramid) {
+  m_pyramid = pyramid;
+  setPixmap(QPixmap::fromImage(pyramid->downscaledImage()));
+  viewport()->update();
+}
+
+/**
+ * Returns the source for rendering tiles from \p image, which is either m_image
+ * or one of the pyramid levels, creating it if necessary.
+ */
+std::shared_ptr<ImageViewBase::HqSource> ImageViewBase::obtainHqSource(const QImage& image) {
+  std::shared_ptr<HqSource>& source = m_hqSources[image.cacheKey()];
+  if (!source) {
+    source = std::make_shared<HqSource>(image);
+  }
+  return source;
 }
 
 /**
  * Gets called from HqTransformationTask::Result.
  */
-void ImageViewBase::hqVersionBuilt(const QPoint& origin, const QImage& image) {
+void ImageViewBase::hqTileBuilt(const QTransform& tileXform,
+                                const std::pair<int, int>& tileIdx,
+                                const QPoint& origin,
+                                const QImage& image) {
+  m_hqTransformTask.reset();
   if (!m_hqTransformEnabled) {
     return;
   }
 
-  m_hqPixmap = QPixmap::fromImage(image);
-  m_hqPixmapPos = origin;
-  m_hqTransformTask.reset();
-  update();
+  QPoint widgetOffset;
+  if (hqTileXform(widgetOffset) != tileXform) {
+    // Zoom level changed while the tile was being rendered.
+    return;
+  }
+
+  HqTileSet& tileSet = obtainHqTileSet(tileXform);
+  tileSet.tiles[tileIdx] = HqTile{origin, QPixmap::fromImage(image)};
+  trimHqTileCache(widgetOffset);
+
+  viewport()->update(QRect(origin + widgetOffset, image.size()));
+
+  // Proceed with the next tile.
+  initiateBuildingHqVersion();
 }
 
 void ImageViewBase::updateStatusTipAndCursor() {
@@ -986,6 +1334,10 @@ BackgroundExecutor& ImageViewBase::backgroundExecutor() {
   return executor;
 }
 
+BackgroundExecutor::Priority ImageViewBase::backgroundTaskPriority() const {
+  return isVisible() ? BackgroundExecutor::VISIBLE_PRIORITY : BackgroundExecutor::NORMAL_PRIORITY;
+}
+
 void ImageViewBase::updateCursorPos(const QPointF& pos) {
   if (pos != m_cursorPos) {
     m_cursorPos = pos;
@@ -1007,20 +1359,30 @@ ImageViewInfoProvider& ImageViewBase::infoProvider() {
 /*==================== ImageViewBase::HqTransformTask ======================*/
 
 ImageViewBase::HqTransformTask::HqTransformTask(ImageViewBase* imageView,
-                                                const QImage& image,
-                                                const QTransform& xform,
-                                                const QSize& targetSize)
-    : m_result(std::make_shared<Result>(imageView)), m_image(image), m_xform(xform), m_targetSize(targetSize) {}
+                                                std::shared_ptr<HqSource> source,
+                                                const QTransform& sourceToTile,
+                                                const QTransform& tileXform,
+                                                const std::pair<int, int>& tileIdx,
+                                                const QRect& tileRect)
+    : m_result(std::make_shared<Result>(imageView, tileXform, tileIdx)),
+      m_source(std::move(source)),
+      m_sourceToTile(sourceToTile),
+      m_tileXform(tileXform),
+      m_tileRect(tileRect) {}
 
 std::shared_ptr<AbstractCommand<void>> ImageViewBase::HqTransformTask::operator()() {
   if (isCancelled()) {
     return nullptr;
   }
 
-  const QRect targetRect(
-      m_xform.map(QRectF(m_image.rect())).boundingRect().toRect().intersected(QRect(QPoint(0, 0), m_targetSize)));
+  const QImage source(m_source->converted());
 
-  QImage hqImage(transform(m_image, m_xform, targetRect, OutsidePixels::assumeWeakColor(Qt::white), QSizeF(0.0, 0.0)));
+  if (isCancelled()) {
+    return nullptr;
+  }
+
+  QImage hqImage(
+      transform(source, m_sourceToTile, m_tileRect, OutsidePixels::assumeWeakColor(Qt::white), QSizeF(0.0, 0.0)));
 
   // In many cases m_image and therefore hqImage are grayscale with
   // a palette, but given that hqImage will be converted to a QPixmap
@@ -1029,13 +1391,16 @@ std::shared_ptr<AbstractCommand<void>> ImageViewBase::HqTransformTask::operator(
   hqImage
       = hqImage.convertToFormat(hqImage.hasAlphaChannel() ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32);
 
-  m_result->setData(targetRect.topLeft(), hqImage);
+  m_result->setData(m_tileRect.topLeft(), hqImage);
   return m_result;
 }
 
 /*================ ImageViewBase::HqTransformTask::Result ================*/
 
-ImageViewBase::HqTransformTask::Result::Result(ImageViewBase* imageView) : m_imageView(imageView) {}
+ImageViewBase::HqTransformTask::Result::Result(ImageViewBase* imageView,
+                                               const QTransform& tileXform,
+                                               const std::pair<int, int>& tileIdx)
+    : m_imageView(imageView), m_tileXform(tileXform), m_tileIdx(tileIdx) {}
 
 void ImageViewBase::HqTransformTask::Result::setData(const QPoint& origin, const QImage& hqImage) {
   m_hqImage = hqImage;
@@ -1044,7 +1409,20 @@ void ImageViewBase::HqTransformTask::Result::setData(const QPoint& origin, const
 
 void ImageViewBase::HqTransformTask::Result::operator()() {
   if (m_imageView && !isCancelled()) {
-    m_imageView->hqVersionBuilt(m_origin, m_hqImage);
+    m_imageView->hqTileBuilt(m_tileXform, m_tileIdx, m_origin, m_hqImage);
+  }
+}
+
+/*======================== ImageViewBase::PyramidTask ========================*/
+
+std::shared_ptr<AbstractCommand<void>> ImageViewBase::PyramidTask::operator()() {
+  m_result->setPyramid(ImagePyramidCache::instance().pyramidFor(m_image));
+  return m_result;
+}
+
+void ImageViewBase::PyramidTask::Result::operator()() {
+  if (m_imageView) {
+    m_imageView->pyramidBuilt(m_pyramid);
   }
 }
 
@@ -16,8 +16,14 @@
 #include <QTransform>
 #include <QWidget>
 #include <Qt>
+#include <list>
+#include <map>
 #include <memory>
+#include <utility>
+#include <vector>
 
+#include "BackgroundExecutor.h"
+#include "ImageId.h"
 #include "ImagePixmapUnion.h"
 #include "ImageViewInfoProvider.h"
 #include "InteractionHandler.h"
@@ -25,8 +31,8 @@
 #include "Margins.h"
 
 class QPainter;
-class BackgroundExecutor;
 class ImagePresentation;
+class ImagePyramid;
 
 /**
  * \brief The base class for widgets that display and manipulate images.
@@ -54,7 +60,8 @@ class ImageViewBase : public QAbstractScrollArea {
    *
    * \param image The image to display.
    * \param downscaledVersion The downscaled version of \p image.
-   *        If it's null, it will be created automatically.
+   *        If it's null, it will be created in the background,
+   *        with \p image itself being displayed until then.
    *        The exact scale doesn't matter.
    *        The whole idea of having a downscaled version is
    *        to speed up real-time rendering of high-resolution
@@ -94,10 +101,16 @@ class ImageViewBase : public QAbstractScrollArea {
    * be called from a background thread, while the constructor
    * can't.
    *
+   * The downscaled image is taken from the shared ImagePyramidCache,
+   * so views of the same image don't downscale it again.
+   *
    * \param image The input image, not null, and with DPI set correctly.
+   * \param sourceId The image file \p image was loaded from, if any.
+   *        Allows reusing the downscaled version after the image
+   *        got reloaded, for example in another stage.
    * \return The image downscaled by an unspecified degree.
    */
-  static QImage createDownscaledImage(const QImage& image);
+  static QImage createDownscaledImage(const QImage& image, const ImageId& sourceId = ImageId());
 
   InteractionHandler& rootInteractionHandler() { return m_rootInteractionHandler; }
 
@@ -217,6 +230,14 @@ class ImageViewBase : public QAbstractScrollArea {
 
   static BackgroundExecutor& backgroundExecutor();
 
+  /**
+   * \brief The priority to submit background tasks of this view with.
+   *
+   * Tasks of a view that is currently visible on screen take precedence
+   * over those of hidden ones (like inactive tabs).
+   */
+  BackgroundExecutor::Priority backgroundTaskPriority() const;
+
   ImageViewInfoProvider& infoProvider();
 
  protected:
@@ -270,9 +291,35 @@ class ImageViewBase : public QAbstractScrollArea {
   void reactToScrollBars();
 
  private:
+  class HqSource;
   class HqTransformTask;
+  class PyramidTask;
   class TempFocalPointAdjuster;
 
+  /**
+   * A piece of the high quality version of the image.
+   */
+  struct HqTile {
+    /** The position of the tile in tile space. */
+    QPoint origin;
+    QPixmap pixmap;
+  };
+
+  /**
+   * High quality tiles rendered for a single zoom level.
+   */
+  struct HqTileSet {
+    /**
+     * Transformation from image coordinates to tile space.
+     * It differs from the image to widget transformation only by
+     * an integer translation, which is why panning doesn't invalidate tiles.
+     */
+    QTransform tileXform;
+
+    /** Tiles, keyed by their (column, row) in the tile grid. */
+    std::map<std::pair<int, int>, HqTile> tiles;
+  };
+
   class TransformChangeWatcher;
 
   QRectF dynamicViewportRect() const;
@@ -291,11 +338,34 @@ class ImageViewBase : public QAbstractScrollArea {
 
   QPointF centeredWidgetFocalPoint() const;
 
-  bool validateHqPixmap() const;
+  QTransform hqTileXform(QPoint& widgetOffset) const;
+
+  QRect hqTileRange(const QTransform& tileXform, const QPoint& widgetOffset, int margin) const;
+
+  QRect hqTileRect(const QTransform& tileXform, int column, int row) const;
+
+  std::vector<std::pair<int, int>> missingHqTiles(const HqTileSet& tileSet,
+                                                  const QPoint& widgetOffset,
+                                                  bool prefetch) const;
+
+  const HqTileSet* findHqTileSet(const QTransform& tileXform) const;
+
+  HqTileSet& obtainHqTileSet(const QTransform& tileXform);
+
+  void trimHqTileCache(const QPoint& widgetOffset);
 
   void scheduleHqVersionRebuild();
 
-  void hqVersionBuilt(const QPoint& origin, const QImage& image);
+  void setPixmap(const QPixmap& pixmap);
+
+  void pyramidBuilt(const std::shared_ptr<const ImagePyramid>& pyramid);
+
+  std::shared_ptr<HqSource> obtainHqSource(const QImage& image);
+
+  void hqTileBuilt(const QTransform& tileXform,
+                   const std::pair<int, int>& tileIdx,
+                   const QPoint& origin,
+                   const QImage& image);
 
   void updateStatusTipAndCursor();
 
@@ -328,33 +398,29 @@ class ImageViewBase : public QAbstractScrollArea {
   QPixmap m_pixmap;
 
   /**
-   * The high quality, pre-transformed version of m_pixmap.
+   * Downscaled versions of m_image the high quality tiles are rendered from
+   * when zoomed out.  May be null, in particular while it's being built.
    */
-  QPixmap m_hqPixmap;
+  std::shared_ptr<const ImagePyramid> m_pyramid;
 
   /**
-   * The position, in widget coordinates, where m_hqPixmap is to be drawn.
+   * The high quality, pre-transformed tiles of m_image, with the most
+   * recently used zoom level at the front.
    */
-  QPoint m_hqPixmapPos;
+  std::list<HqTileSet> m_hqTileSets;
 
   /**
-   * The transformation used to build m_hqPixmap.
-   * It's used to detect if m_hqPixmap needs to be rebuild.
+   * m_image and the pyramid levels high quality tiles were rendered from,
+   * keyed by QImage::cacheKey().  Each of them is converted to the format
+   * the high quality transform operates on only once, for all of the tiles.
    */
-  QTransform m_hqXform;
+  std::map<qint64, std::shared_ptr<HqSource>> m_hqSources;
 
   /**
-   * Used to check if we need to extend the delay before building m_hqPixmap.
+   * Used to check if we need to extend the delay before building HQ tiles.
    */
   QTransform m_potentialHqXform;
 
-  /**
-   * The ID (QImage::cacheKey()) of the image that was used
-   * to build m_hqPixmap.  It's used to detect if m_hqPixmap
-   * needs to be rebuilt.
-   */
-  qint64 m_hqSourceId;
-
   /**
    * The pending (if any) high quality transformation task.
    */
@@ -11,12 +11,14 @@
 #include <QTextDocument>
 
 #include "AbstractFilter.h"
+#include "CancellationPoint.h"
 #include "Dpm.h"
 #include "ErrorWidget.h"
 #include "FilterData.h"
 #include "FilterOptionsWidget.h"
 #include "FilterUiInterface.h"
 #include "ImageLoader.h"
+#include "ImagePrefetcher.h"
 #include "ProjectPages.h"
 #include "ThumbnailPixmapCache.h"
 #include "filters/fix_orientation/Task.h"
@@ -55,9 +57,14 @@ LoadFileTask::LoadFileTask(Type type,
 LoadFileTask::~LoadFileTask() = default;
 
 FilterResultPtr LoadFileTask::operator()() {
-  QImage image = ImageLoader::load(m_imageId);
+  QImage image = ImagePrefetcher::instance().find(m_imageId);
+  if (image.isNull()) {
+    image = ImageLoader::load(m_imageId);
+  }
 
   try {
+    // Lets the image processing kernels bail out early on cancellation.
+    const CancellationPoint::Scope cancellationScope(*this);
     throwIfCancelled();
 
     if (image.isNull()) {
@@ -4,9 +4,11 @@
 #include "WorkerThreadPool.h"
 
 #include <QCoreApplication>
+#include <QThread>
 #include <QThreadPool>
 #include <utility>
 
+#include "ApplicationSettings.h"
 #include "OutOfMemoryHandler.h"
 
 class WorkerThreadPool::TaskResultEvent : public QEvent {
@@ -24,55 +26,115 @@ class WorkerThreadPool::TaskResultEvent : public QEvent {
 };
 
 
-WorkerThreadPool::WorkerThreadPool(QObject* parent) : QObject(parent), m_pool(new QThreadPool(this)) {
+WorkerThreadPool::WorkerThreadPool(QObject* parent)
+    : QObject(parent),
+      m_interactivePool(new QThreadPool(this)),
+      m_batchPool(new QThreadPool(this)),
+      m_batchPoolLowPriority(ApplicationSettings().isLowBatchPriorityEnabled()),
+      m_numRunningInteractiveTasks(0),
+      m_numRunningBatchTasks(0),
+      m_numBatchThreads(1) {
+  // Interactive tasks are debounced, so only one of them runs at a time.
+  m_interactivePool->setMaxThreadCount(1);
   updateNumberOfThreads();
 }
 
 WorkerThreadPool::~WorkerThreadPool() = default;
 
 void WorkerThreadPool::shutdown() {
-  m_pool->waitForDone();
+  m_pendingInteractiveTask.reset();
+  m_interactivePool->waitForDone();
+  m_batchPool->waitForDone();
 }
 
 bool WorkerThreadPool::hasSpareCapacity() const {
-  return m_pool->activeThreadCount() < m_pool->maxThreadCount();
+  return m_numRunningBatchTasks < m_numBatchThreads;
 }
 
 void WorkerThreadPool::submitTask(const BackgroundTaskPtr& task) {
+  if (task->type() == BackgroundTask::INTERACTIVE) {
+    if (m_numRunningInteractiveTasks > 0) {
+      m_pendingInteractiveTask = task;
+      return;
+    }
+    m_pendingInteractiveTask.reset();
+    ++m_numRunningInteractiveTasks;
+  } else {
+    if (m_numRunningBatchTasks == 0) {
+      updateBatchPriority();
+    }
+    ++m_numRunningBatchTasks;
+  }
+  startTask(task);
+}
+
+void WorkerThreadPool::startTask(const BackgroundTaskPtr& task) {
   class Runnable : public QRunnable {
    public:
-    Runnable(WorkerThreadPool& owner, BackgroundTaskPtr task) : m_owner(owner), m_task(std::move(task)) {
+    Runnable(WorkerThreadPool& owner, BackgroundTaskPtr task, const QThread::Priority threadPriority)
+        : m_owner(owner), m_task(std::move(task)), m_threadPriority(threadPriority) {
       setAutoDelete(true);
     }
 
     void run() override {
-      if (m_task->isCancelled()) {
-        return;
+      // Pool threads are created lazily, so we can't set it any earlier.
+      if (QThread::currentThread()->priority() != m_threadPriority) {
+        QThread::currentThread()->setPriority(m_threadPriority);
       }
 
-      try {
-        const FilterResultPtr result((*m_task)());
-        if (result) {
-          QCoreApplication::postEvent(&m_owner, new TaskResultEvent(m_task, result));
+      FilterResultPtr result;
+      if (!m_task->isCancelled()) {
+        try {
+          result = (*m_task)();
+        } catch (const std::bad_alloc&) {
+          OutOfMemoryHandler::instance().handleOutOfMemorySituation();
         }
-      } catch (const std::bad_alloc&) {
-        OutOfMemoryHandler::instance().handleOutOfMemorySituation();
       }
+      // Posted even without a result, to let the pool know the task is done.
+      QCoreApplication::postEvent(&m_owner, new TaskResultEvent(m_task, result));
     }
 
    private:
     WorkerThreadPool& m_owner;
     BackgroundTaskPtr m_task;
+    const QThread::Priority m_threadPriority;
   };
 
 
   updateNumberOfThreads();
-  m_pool->start(new Runnable(*this, task));
-}  // WorkerThreadPool::submitTask
+
+  if (task->type() == BackgroundTask::INTERACTIVE) {
+    m_interactivePool->start(new Runnable(*this, task, QThread::NormalPriority));
+  } else {
+    // LowPriority is a no-op for SCHED_OTHER threads on Linux, while IdlePriority
+    // maps to SCHED_IDLE there.  Qt can't bring a thread back from SCHED_IDLE,
+    // which is why batch tasks get threads of their own.
+    const QThread::Priority threadPriority = m_batchPoolLowPriority ? QThread::IdlePriority : QThread::NormalPriority;
+    m_batchPool->start(new Runnable(*this, task, threadPriority));
+  }
+}  // WorkerThreadPool::startTask
 
 void WorkerThreadPool::customEvent(QEvent* event) {
   if (auto* evt = dynamic_cast<TaskResultEvent*>(event)) {
-    emit taskResult(evt->task(), evt->result());
+    const bool interactive = (evt->task()->type() == BackgroundTask::INTERACTIVE);
+    if (interactive) {
+      --m_numRunningInteractiveTasks;
+    } else {
+      --m_numRunningBatchTasks;
+    }
+
+    if (evt->result()) {
+      emit taskResult(evt->task(), evt->result());
+    }
+
+    if (interactive && (m_numRunningInteractiveTasks == 0) && m_pendingInteractiveTask) {
+      BackgroundTaskPtr task;
+      task.swap(m_pendingInteractiveTask);
+      if (!task->isCancelled()) {
+        ++m_numRunningInteractiveTasks;
+        startTask(task);
+      }
+    }
   }
 }
 
@@ -86,5 +148,20 @@ void WorkerThreadPool::updateNumberOfThreads() {
 
   int numThreads = m_settings.value("settings/batch_processing_threads", maxThreads).toInt();
   numThreads = std::min(numThreads, maxThreads);
-  m_pool->setMaxThreadCount(numThreads);
+  m_numBatchThreads = numThreads;
+  m_batchPool->setMaxThreadCount(numThreads);
+}
+
+void WorkerThreadPool::updateBatchPriority() {
+  const bool lowPriority = ApplicationSettings().isLowBatchPriorityEnabled();
+  if (lowPriority == m_batchPoolLowPriority) {
+    return;
+  }
+  // The old threads may be at idle priority for good, so we start over with new ones.
+  // The last task may still be returning from its run() here.
+  m_batchPool->waitForDone();
+  delete m_batchPool;
+  m_batchPool = new QThreadPool(this);
+  m_batchPoolLowPriority = lowPriority;
+  updateNumberOfThreads();
 }
@@ -28,8 +28,28 @@ class WorkerThreadPool : public QObject {
    */
   void shutdown();
 
+  /**
+   * \brief Returns whether another batch task would be started right away.
+   *
+   * Interactive tasks have a thread of their own, so interactive work
+   * never has to wait for batch tasks to finish.
+   */
   bool hasSpareCapacity() const;
 
+  /**
+   * \brief Schedules a task for execution.
+   *
+   * Interactive and batch tasks run in separate pools, so interactive ones
+   * never wait for a thread.  Batch threads run at idle OS priority
+   * if ApplicationSettings say so.
+   *
+   * Batch tasks are started right away.  Interactive tasks are debounced.
+   * While a previous interactive task is still running, typically winding
+   * down after being cancelled, the new one is held back.  It replaces any
+   * interactive task held back before it, and gets started once the running
+   * ones finish.  That way rapid UI changes don't stack up several full page
+   * computations in the pool.
+   */
   void submitTask(const BackgroundTaskPtr& task);
 
  signals:
@@ -41,10 +61,24 @@ class WorkerThreadPool : public QObject {
 
   void customEvent(QEvent* event) override;
 
+  void startTask(const BackgroundTaskPtr& task);
+
   void updateNumberOfThreads();
 
-  QThreadPool* m_pool;
+  /**
+   * Replaces the batch pool if its threads run at a priority other than
+   * the one currently configured.  Must only be called with no batch tasks running.
+   */
+  void updateBatchPriority();
+
+  QThreadPool* m_interactivePool;
+  QThreadPool* m_batchPool;
+  bool m_batchPoolLowPriority;
   QSettings m_settings;
+  BackgroundTaskPtr m_pendingInteractiveTask;
+  int m_numRunningInteractiveTasks;
+  int m_numRunningBatchTasks;
+  int m_numBatchThreads;
 };
 
 
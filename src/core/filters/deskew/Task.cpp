@@ -237,7 +237,7 @@ Task::UiUpdater::UiUpdater(std::shared_ptr<Filter> filter,
     : m_filter(std::move(filter)),
       m_dbg(std::move(dbgImg)),
       m_image(image),
-      m_downscaledImage(ImageView::createDownscaledImage(image)),
+      m_downscaledImage(ImageView::createDownscaledImage(image, pageId.imageId())),
       m_pageId(pageId),
       m_xform(xform),
       m_uiData(uiData),
@@ -93,7 +93,7 @@ Task::UiUpdater::UiUpdater(std::shared_ptr<Filter> filter,
                            const bool batchProcessing)
     : m_filter(std::move(filter)),
       m_image(image),
-      m_downscaledImage(ImageView::createDownscaledImage(image)),
+      m_downscaledImage(ImageView::createDownscaledImage(image, imageId)),
       m_imageId(imageId),
       m_xform(xform),
       m_batchProcessing(batchProcessing) {}
@@ -0,0 +1,24 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#include "BackgroundSurfaceKey.h"
+
+namespace output {
+BackgroundSurfaceKey::BackgroundSurfaceKey(const QTransform& xform,
+                                           const QRect& targetRect,
+                                           const QPolygonF& areaToConsider,
+                                           const uint64_t imageFingerprint)
+    : m_xform(xform),
+      m_targetRect(targetRect),
+      m_areaToConsider(areaToConsider),
+      m_imageFingerprint(imageFingerprint) {}
+
+bool BackgroundSurfaceKey::operator==(const BackgroundSurfaceKey& other) const {
+  return (m_xform == other.m_xform) && (m_targetRect == other.m_targetRect)
+         && (m_areaToConsider == other.m_areaToConsider) && (m_imageFingerprint == other.m_imageFingerprint);
+}
+
+bool BackgroundSurfaceKey::operator!=(const BackgroundSurfaceKey& other) const {
+  return !(*this == other);
+}
+}  // namespace output
@@ -0,0 +1,44 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#ifndef SCANTAILOR_OUTPUT_BACKGROUNDSURFACEKEY_H_
+#define SCANTAILOR_OUTPUT_BACKGROUNDSURFACEKEY_H_
+
+#include <QPolygonF>
+#include <QRect>
+#include <QTransform>
+#include <cstdint>
+
+namespace output {
+/**
+ * \brief Everything the background surface estimated for illumination
+ *        normalization depends on.
+ *
+ * Colour, binarization and despeckling settings of a page don't affect it,
+ * so changing those doesn't make us estimate the background again.
+ */
+class BackgroundSurfaceKey {
+ public:
+  /**
+   * \param xform The transformation from the input image to the output one.
+   * \param targetRect The area of the output image the background is estimated in.
+   * \param areaToConsider The area of the input image to consider.
+   * \param imageFingerprint The fingerprint of the input image.
+   */
+  BackgroundSurfaceKey(const QTransform& xform,
+                       const QRect& targetRect,
+                       const QPolygonF& areaToConsider,
+                       uint64_t imageFingerprint);
+
+  bool operator==(const BackgroundSurfaceKey& other) const;
+
+  bool operator!=(const BackgroundSurfaceKey& other) const;
+
+ private:
+  QTransform m_xform;
+  QRect m_targetRect;
+  QPolygonF m_areaToConsider;
+  uint64_t m_imageFingerprint;
+};
+}  // namespace output
+#endif  // ifndef SCANTAILOR_OUTPUT_BACKGROUNDSURFACEKEY_H_
@@ -26,6 +26,14 @@ DespeckleVisualization DespeckleState::visualize() const {
   return DespeckleVisualization(m_everythingMixed, m_speckles, m_dpi);
 }
 
+DespeckleVisualization DespeckleState::visualize(const DespeckleState& prevState,
+                                                 const DespeckleVisualization& prevVisualization) const {
+  if (prevState.m_everythingMixed.cacheKey() != m_everythingMixed.cacheKey()) {
+    return visualize();
+  }
+  return DespeckleVisualization(prevVisualization, prevState.m_speckles, m_everythingMixed, m_speckles, m_dpi);
+}
+
 DespeckleState DespeckleState::redespeckle(const double level, const TaskStatus& status, DebugImages* dbg) const {
   DespeckleState newState(*this);
 
@@ -41,7 +49,10 @@ DespeckleState DespeckleState::redespeckle(const double level, const TaskStatus&
     return newState;
   }
 
-  newState.m_speckles = Despeckle::despeckle(m_everythingBW, m_dpi, level, status, dbg);
+  if (!newState.m_analysis) {
+    newState.m_analysis = Despeckle::analyze(m_everythingBW, m_dpi, status, dbg);
+  }
+  newState.m_speckles = Despeckle::despeckle(*newState.m_analysis, level, status, dbg);
 
   status.throwIfCancelled();
 
@@ -8,7 +8,9 @@
 #include <BinaryImage.h>
 
 #include <QImage>
+#include <memory>
 
+#include "Despeckle.h"
 #include "DespeckleLevel.h"
 #include "Dpi.h"
 
@@ -31,6 +33,14 @@ class DespeckleState {
 
   DespeckleVisualization visualize() const;
 
+  /**
+   * \brief Same as visualize(), but reuses the visualization of another state.
+   *
+   * Only the areas where speckles of the two states differ are visualized anew.
+   * If \p prevState was derived from a different image, this falls back to visualize().
+   */
+  DespeckleVisualization visualize(const DespeckleState& prevState, const DespeckleVisualization& prevVisualization) const;
+
   DespeckleState redespeckle(double level, const TaskStatus& status, DebugImages* dbg = nullptr) const;
 
  private:
@@ -67,6 +77,12 @@ class DespeckleState {
    * m_everythingBW.
    */
   double m_despeckleLevel;
+
+  /**
+   * The level-independent part of despeckling m_everythingBW.
+   * Built by the first redespeckle() and shared by the states derived from it.
+   */
+  std::shared_ptr<const Despeckle::Analysis> m_analysis;
 };
 
 
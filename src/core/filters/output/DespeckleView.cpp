@@ -5,6 +5,7 @@
 
 #include <QDebug>
 #include <QPointer>
+#include <algorithm>
 #include <utility>
 
 #include "AbstractCommand.h"
@@ -22,6 +23,14 @@
 using namespace imageproc;
 
 namespace output {
+namespace {
+/**
+ * Speckle images are 1 bit per pixel, and the expensive level-independent
+ * data is shared between the states, so keeping a few of them is cheap.
+ */
+const size_t MAX_CACHED_STATES = 8;
+}  // namespace
+
 class DespeckleView::TaskCancelException : public std::exception {
  public:
   const char* what() const noexcept override { return "Task cancelled"; }
@@ -43,8 +52,15 @@ class DespeckleView::TaskCancelHandle : public TaskStatus {
 
 class DespeckleView::DespeckleTask : public AbstractCommand<BackgroundExecutor::TaskResultPtr> {
  public:
+  /**
+   * \param despeckleState The state to redespeckle.
+   * \param prevState The state currently displayed.
+   * \param prevVisualization The visualization of \p prevState, possibly null.
+   */
   DespeckleTask(DespeckleView* owner,
                 const DespeckleState& despeckleState,
+                const DespeckleState& prevState,
+                const DespeckleVisualization& prevVisualization,
                 std::shared_ptr<TaskCancelHandle> cancelHandle,
                 double level,
                 bool debug);
@@ -54,6 +70,8 @@ class DespeckleView::DespeckleTask : public AbstractCommand<BackgroundExecutor::
  private:
   QPointer<DespeckleView> m_owner;
   DespeckleState m_despeckleState;
+  DespeckleState m_prevState;
+  DespeckleVisualization m_prevVisualization;
   std::shared_ptr<TaskCancelHandle> m_cancelHandle;
   std::unique_ptr<DebugImages> m_dbg;
   double m_despeckleLevel;
@@ -86,10 +104,12 @@ DespeckleView::DespeckleView(const DespeckleState& despeckleState,
                              const DespeckleVisualization& visualization,
                              bool debug)
     : m_despeckleState(despeckleState),
+      m_visualization(visualization),
       m_processingIndicator(new ProcessingIndicationWidget(this)),
       m_despeckleLevel(despeckleState.level()),
       m_debug(debug) {
   addWidget(m_processingIndicator);
+  cacheState(despeckleState);
 
   if (!visualization.isNull()) {
     // Create the image view.
@@ -146,11 +166,15 @@ void DespeckleView::initiateDespeckling(const AnimationAction animAction) {
   cancelBackgroundTask();
   m_cancelHandle.reset(new TaskCancelHandle);
 
-  // Note that we are getting rid of m_initialSpeckles,
-  // as we wouldn't need it any more.
-
-  const auto task = std::make_shared<DespeckleTask>(this, m_despeckleState, m_cancelHandle, m_despeckleLevel, m_debug);
-  ImageViewBase::backgroundExecutor().enqueueTask(task);
+  // Redespeckling a cached state at its own level is a no-op,
+  // so only the visualization has to be updated then.
+  const DespeckleState* cachedState = findCachedState(m_despeckleLevel);
+  const auto task = std::make_shared<DespeckleTask>(this, cachedState ? *cachedState : m_despeckleState,
+                                                    m_despeckleState, m_visualization, m_cancelHandle,
+                                                    m_despeckleLevel, m_debug);
+  ImageViewBase::backgroundExecutor().enqueueTask(
+      task, BackgroundExecutor::DESPECKLE_PREVIEW_LANE, this,
+      isVisible() ? BackgroundExecutor::VISIBLE_PRIORITY : BackgroundExecutor::NORMAL_PRIORITY);
 }
 
 void DespeckleView::despeckleDone(const DespeckleState& despeckleState,
@@ -159,6 +183,8 @@ void DespeckleView::despeckleDone(const DespeckleState& despeckleState,
   assert(!visualization.isNull());
 
   m_despeckleState = despeckleState;
+  m_visualization = visualization;
+  cacheState(despeckleState);
 
   removeImageViewWidget();
 
@@ -197,15 +223,39 @@ void DespeckleView::removeImageViewWidget() {
   }
 }
 
+void DespeckleView::cacheState(const DespeckleState& despeckleState) {
+  const double level = despeckleState.level();
+  m_cachedStates.erase(std::remove_if(m_cachedStates.begin(), m_cachedStates.end(),
+                                      [level](const DespeckleState& state) { return state.level() == level; }),
+                       m_cachedStates.end());
+  m_cachedStates.push_back(despeckleState);
+  if (m_cachedStates.size() > MAX_CACHED_STATES) {
+    m_cachedStates.pop_front();
+  }
+}
+
+const DespeckleState* DespeckleView::findCachedState(const double level) const {
+  for (const DespeckleState& state : m_cachedStates) {
+    if (state.level() == level) {
+      return &state;
+    }
+  }
+  return nullptr;
+}
+
 /*============================= DespeckleTask ==========================*/
 
 DespeckleView::DespeckleTask::DespeckleTask(DespeckleView* owner,
                                             const DespeckleState& despeckleState,
+                                            const DespeckleState& prevState,
+                                            const DespeckleVisualization& prevVisualization,
                                             std::shared_ptr<TaskCancelHandle> cancelHandle,
                                             const double level,
                                             const bool debug)
     : m_owner(owner),
       m_despeckleState(despeckleState),
+      m_prevState(prevState),
+      m_prevVisualization(prevVisualization),
       m_cancelHandle(std::move(cancelHandle)),
       m_despeckleLevel(level) {
   if (debug) {
@@ -221,7 +271,9 @@ BackgroundExecutor::TaskResultPtr DespeckleView::DespeckleTask::operator()() {
 
     m_cancelHandle->throwIfCancelled();
 
-    DespeckleVisualization visualization(m_despeckleState.visualize());
+    DespeckleVisualization visualization(m_despeckleState.visualize(m_prevState, m_prevVisualization));
+    // Don't keep the previous image alive longer than necessary.
+    m_prevVisualization = DespeckleVisualization();
 
     m_cancelHandle->throwIfCancelled();
     return std::make_shared<DespeckleResult>(m_owner, m_cancelHandle, m_despeckleState, visualization,
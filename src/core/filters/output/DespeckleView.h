@@ -9,10 +9,12 @@
 
 #include <QImage>
 #include <QStackedWidget>
+#include <deque>
 #include <memory>
 
 #include "DespeckleLevel.h"
 #include "DespeckleState.h"
+#include "DespeckleVisualization.h"
 #include "Dpi.h"
 
 class DebugImages;
@@ -20,8 +22,6 @@ class ProcessingIndicationWidget;
 class ImageViewBase;
 
 namespace output {
-class DespeckleVisualization;
-
 class DespeckleView : public QStackedWidget {
   Q_OBJECT
  public:
@@ -67,7 +67,18 @@ class DespeckleView : public QStackedWidget {
 
   void removeImageViewWidget();
 
+  void cacheState(const DespeckleState& despeckleState);
+
+  const DespeckleState* findCachedState(double level) const;
+
   DespeckleState m_despeckleState;
+  DespeckleVisualization m_visualization;
+
+  /**
+   * Recently computed states, so that returning to a level doesn't
+   * involve despeckling again.  The most recent ones come last.
+   */
+  std::deque<DespeckleState> m_cachedStates;
   std::shared_ptr<TaskCancelHandle> m_cancelHandle;
   ProcessingIndicationWidget* m_processingIndicator;
   double m_despeckleLevel;
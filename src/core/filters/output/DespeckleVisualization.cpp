@@ -4,9 +4,12 @@
 #include "DespeckleVisualization.h"
 
 #include <BinaryImage.h>
+#include <RasterOp.h>
 #include <SEDM.h>
 
 #include <QPainter>
+#include <cmath>
+#include <vector>
 
 #include "Dpi.h"
 #include "ImageViewBase.h"
@@ -14,6 +17,144 @@
 using namespace imageproc;
 
 namespace output {
+namespace {
+/**
+ * Incremental updates are done in square tiles of this size.
+ * Must be a multiple of 32, so that a word of a BinaryImage line
+ * never spans two tiles.
+ */
+const int TILE_SIZE = 256;
+
+float overlayRadius(const Dpi& dpi) {
+  return static_cast<float>(45.0 * std::max(dpi.horizontal(), dpi.vertical()) / 600);
+}
+
+bool haveSpeckles(const BinaryImage& speckles) {
+  return !speckles.isNull() && (speckles.countBlackPixels() != 0);
+}
+
+/**
+ * \param sqDist The squared distance from the pixel to the closest speckle.
+ * \param infDistAlpha The overlay alpha for pixels with no speckles around.
+ */
+inline void colorizePixel(uint32_t& pixel, const uint32_t sqDist, const float sqRadius, const float infDistAlpha) {
+  if (sqDist == 0) {
+    // Speckle pixel.
+    pixel = 0xffff0000;  // opaque red
+    return;
+  } else if ((pixel & 0x00ffffff) == 0x0) {
+    // Non-speckle black pixel.
+    return;
+  }
+
+  const float alphaUpperBound = 0.7f;
+  const float scale = alphaUpperBound / sqRadius;
+  const float alpha = (sqDist == SEDM::INF_DIST) ? infDistAlpha : alphaUpperBound - scale * sqDist;
+  if (alpha > 0) {
+    const float alpha2 = 1.0f - alpha;
+    const float overlayR = 255;
+    const float overlayG = 0;
+    const float overlayB = 0;
+    const float r = overlayR * alpha + qRed(pixel) * alpha2;
+    const float g = overlayG * alpha + qGreen(pixel) * alpha2;
+    const float b = overlayB * alpha + qBlue(pixel) * alpha2;
+    pixel = qRgb(int(r), int(g), int(b));
+  }
+}
+
+/**
+ * Finds the tiles where the two images differ, expanded by \p reach pixels
+ * in every direction.  The images must be of the same size.
+ */
+std::vector<QRect> findChangedTiles(const BinaryImage& img1, const BinaryImage& img2, const int reach) {
+  const int width = img1.width();
+  const int height = img1.height();
+  const int tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+  const int tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+  const int wordsPerTile = TILE_SIZE / 32;
+
+  std::vector<char> changed(tilesX * tilesY, 0);
+  const uint32_t* line1 = img1.data();
+  const uint32_t* line2 = img2.data();
+  const int wpl = img1.wordsPerLine();
+  for (int y = 0; y < height; ++y) {
+    char* changedRow = &changed[(y / TILE_SIZE) * tilesX];
+    for (int i = 0; i < wpl; ++i) {
+      if (line1[i] != line2[i]) {
+        changedRow[i / wordsPerTile] = 1;
+      }
+    }
+    line1 += wpl;
+    line2 += wpl;
+  }
+
+  const int tileReach = (reach + TILE_SIZE - 1) / TILE_SIZE;
+  std::vector<char> dirty(changed.size(), 0);
+  for (int ty = 0; ty < tilesY; ++ty) {
+    for (int tx = 0; tx < tilesX; ++tx) {
+      if (!changed[ty * tilesX + tx]) {
+        continue;
+      }
+      for (int dty = std::max(0, ty - tileReach); dty <= std::min(tilesY - 1, ty + tileReach); ++dty) {
+        for (int dtx = std::max(0, tx - tileReach); dtx <= std::min(tilesX - 1, tx + tileReach); ++dtx) {
+          dirty[dty * tilesX + dtx] = 1;
+        }
+      }
+    }
+  }
+
+  std::vector<QRect> tiles;
+  const QRect imageRect(img1.rect());
+  for (int ty = 0; ty < tilesY; ++ty) {
+    for (int tx = 0; tx < tilesX; ++tx) {
+      if (dirty[ty * tilesX + tx]) {
+        tiles.push_back(QRect(tx * TILE_SIZE, ty * TILE_SIZE, TILE_SIZE, TILE_SIZE).intersected(imageRect));
+      }
+    }
+  }
+  return tiles;
+}  // findChangedTiles
+
+/**
+ * Restores a tile of \p image from \p base and colorizes the speckles around it.
+ * Only the speckles within \p reach pixels from the tile are considered,
+ * which is enough as long as \p reach exceeds the overlay radius.
+ */
+void recolorizeTile(QImage& image,
+                    const QImage& base,
+                    const BinaryImage& speckles,
+                    const QRect& tile,
+                    const int reach,
+                    const float sqRadius) {
+  const QRect area(tile.adjusted(-reach, -reach, reach, reach).intersected(speckles.rect()));
+  BinaryImage areaSpeckles(area.width(), area.height());
+  rasterOp<RopSrc>(areaSpeckles, areaSpeckles.rect(), speckles, area.topLeft());
+
+  const SEDM sedm(areaSpeckles, SEDM::DIST_TO_BLACK, SEDM::DIST_TO_NO_BORDERS);
+  const int sedmStride = sedm.stride();
+  const uint32_t* sedmLine = sedm.data() + (tile.top() - area.top()) * sedmStride + (tile.left() - area.left());
+
+  const int imageStride = image.bytesPerLine() / 4;
+  auto* imageLine = (uint32_t*) image.bits() + tile.top() * imageStride + tile.left();
+  const int baseStride = base.bytesPerLine() / 4;
+  const auto* baseLine = (const uint32_t*) base.bits() + tile.top() * baseStride + tile.left();
+
+  const int w = tile.width();
+  const int h = tile.height();
+  for (int y = 0; y < h; ++y) {
+    for (int x = 0; x < w; ++x) {
+      imageLine[x] = baseLine[x];
+      // Speckles farther than the reach don't affect the colors,
+      // and that's what an infinite distance means here.
+      colorizePixel(imageLine[x], sedmLine[x], sqRadius, 0.0f);
+    }
+    sedmLine += sedmStride;
+    imageLine += imageStride;
+    baseLine += baseStride;
+  }
+}
+}  // namespace
+
 DespeckleVisualization::DespeckleVisualization(const QImage& output,
                                                const imageproc::BinaryImage& speckles,
                                                const Dpi& dpi) {
@@ -31,6 +172,37 @@ DespeckleVisualization::DespeckleVisualization(const QImage& output,
   m_downscaledImage = ImageViewBase::createDownscaledImage(m_image);
 }
 
+DespeckleVisualization::DespeckleVisualization(const DespeckleVisualization& prev,
+                                               const imageproc::BinaryImage& prevSpeckles,
+                                               const QImage& output,
+                                               const imageproc::BinaryImage& speckles,
+                                               const Dpi& dpi) {
+  // Having no speckles at all changes the whole overlay,
+  // so incremental updates are only possible between non-empty speckle sets.
+  if (prev.isNull() || output.isNull() || (prev.m_image.size() != output.size())
+      || (prevSpeckles.size() != speckles.size()) || !haveSpeckles(prevSpeckles) || !haveSpeckles(speckles)) {
+    *this = DespeckleVisualization(output, speckles, dpi);
+    return;
+  }
+
+  m_image = prev.m_image;
+  m_downscaledImage = prev.m_downscaledImage;
+
+  const float radius = overlayRadius(dpi);
+  const int reach = static_cast<int>(std::ceil(radius)) + 1;
+  const std::vector<QRect> tiles(findChangedTiles(prevSpeckles, speckles, reach));
+  if (tiles.empty()) {
+    return;
+  }
+
+  const QImage base(output.convertToFormat(QImage::Format_RGB32));
+  for (const QRect& tile : tiles) {
+    recolorizeTile(m_image, base, speckles, tile, reach, radius * radius);
+  }
+
+  m_downscaledImage = ImageViewBase::createDownscaledImage(m_image);
+}
+
 void DespeckleVisualization::colorizeSpeckles(QImage& image, const imageproc::BinaryImage& speckles, const Dpi& dpi) {
   const int w = image.width();
   const int h = image.height();
@@ -41,35 +213,13 @@ void DespeckleVisualization::colorizeSpeckles(QImage& image, const imageproc::Bi
   const uint32_t* sedmLine = sedm.data();
   const int sedmStride = sedm.stride();
 
-  const float radius = static_cast<float>(45.0 * std::max(dpi.horizontal(), dpi.vertical()) / 600);
+  const float radius = overlayRadius(dpi);
   const float sqRadius = radius * radius;
+  const float noSpecklesOverlayAlpha = 0.3f;
 
   for (int y = 0; y < h; ++y) {
     for (int x = 0; x < w; ++x) {
-      const uint32_t sqDist = sedmLine[x];
-      if (sqDist == 0) {
-        // Speckle pixel.
-        imageLine[x] = 0xffff0000;  // opaque red
-        continue;
-      } else if ((imageLine[x] & 0x00ffffff) == 0x0) {
-        // Non-speckle black pixel.
-        continue;
-      }
-
-      const float alphaUpperBound = 0.7f;
-      const float noSpecklesOverlayAlpha = 0.3f;
-      const float scale = alphaUpperBound / sqRadius;
-      const float alpha = (sqDist == SEDM::INF_DIST) ? noSpecklesOverlayAlpha : alphaUpperBound - scale * sqDist;
-      if (alpha > 0) {
-        const float alpha2 = 1.0f - alpha;
-        const float overlayR = 255;
-        const float overlayG = 0;
-        const float overlayB = 0;
-        const float r = overlayR * alpha + qRed(imageLine[x]) * alpha2;
-        const float g = overlayG * alpha + qGreen(imageLine[x]) * alpha2;
-        const float b = overlayB * alpha + qBlue(imageLine[x]) * alpha2;
-        imageLine[x] = qRgb(int(r), int(g), int(b));
-      }
+      colorizePixel(imageLine[x], sedmLine[x], sqRadius, noSpecklesOverlayAlpha);
     }
     sedmLine += sedmStride;
     imageLine += imageStride;
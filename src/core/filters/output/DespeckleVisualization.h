@@ -30,6 +30,21 @@ class DespeckleVisualization {
    */
   DespeckleVisualization(const QImage& output, const imageproc::BinaryImage& speckles, const Dpi& dpi);
 
+  /**
+   * \brief Updates a visualization of the same output for different speckles.
+   *
+   * Only the areas around the speckles that differ between \p prevSpeckles
+   * and \p speckles are colorized again.  The result is the same as
+   * DespeckleVisualization(output, speckles, dpi) would produce.
+   *
+   * \param prev The visualization of \p output with \p prevSpeckles.
+   */
+  DespeckleVisualization(const DespeckleVisualization& prev,
+                         const imageproc::BinaryImage& prevSpeckles,
+                         const QImage& output,
+                         const imageproc::BinaryImage& speckles,
+                         const Dpi& dpi);
+
   bool isNull() const;
 
   const QImage& image() const;
@@ -36,7 +36,10 @@ DewarpingView::DewarpingView(const QImage& image,
       m_topSpline(*this),
       m_bottomSpline(*this),
       m_dragHandler(*this),
-      m_zoomHandler(*this) {
+      m_zoomHandler(*this),
+      m_curveModified{false, false},
+      m_gridPreviewBuilt(false),
+      m_gridPreviewValid(false) {
   setMouseTracking(true);
 
   const QPolygonF sourceContentRect(virtualToImage().map(virtContentRect));
@@ -153,10 +156,13 @@ void DewarpingView::fitSpline(XSpline& spline, const std::vector<QPointF>& polyl
 
 void DewarpingView::depthPerceptionChanged(double val) {
   m_depthPerception.setValue(val);
+  invalidateGridPreview();
   update();
 }
 
 void DewarpingView::onPaint(QPainter& painter, const InteractionState& interaction) {
+  updateModelCurves();
+
   painter.setRenderHint(QPainter::Antialiasing);
 
   painter.setPen(Qt::NoPen);
@@ -174,41 +180,15 @@ void DewarpingView::onPaint(QPainter& painter, const InteractionState& interacti
   painter.setPen(gridPen);
   painter.setBrush(Qt::NoBrush);
 
-  const int numVertGridLines = 30;
-  const int numHorGridLines = 30;
-
-  bool validModel = m_distortionModel.isValid();
-
+  const bool validModel = ensureGridPreview();
   if (validModel) {
-    try {
-      std::vector<QVector<QPointF>> curves(numHorGridLines);
-
-      dewarping::CylindricalSurfaceDewarper dewarper(m_distortionModel.topCurve().polyline(),
-                                                     m_distortionModel.bottomCurve().polyline(),
-                                                     m_depthPerception.value());
-      dewarping::CylindricalSurfaceDewarper::State state;
-
-      for (int j = 0; j < numVertGridLines; ++j) {
-        const double x = j / (numVertGridLines - 1.0);
-        const dewarping::CylindricalSurfaceDewarper::Generatrix gtx(dewarper.mapGeneratrix(x, state));
-        const QPointF gtxP0(gtx.imgLine.pointAt(gtx.pln2img(0)));
-        const QPointF gtxP1(gtx.imgLine.pointAt(gtx.pln2img(1)));
-        painter.drawLine(gtxP0, gtxP1);
-        for (int i = 0; i < numHorGridLines; ++i) {
-          const double y = i / (numHorGridLines - 1.0);
-          curves[i].push_back(gtx.imgLine.pointAt(gtx.pln2img(y)));
-        }
-      }
-
-      for (const QVector<QPointF>& curve : curves) {
-        painter.drawPolyline(curve);
-      }
-    } catch (const std::runtime_error&) {
-      // Still probably a bad model, even though DistortionModel::isValid() was true.
-      validModel = false;
+    for (const QLineF& generatrix : m_gridPreview.generatrices) {
+      painter.drawLine(generatrix);
     }
-  }  // validModel
-  if (!validModel) {
+    for (const QVector<QPointF>& curve : m_gridPreview.curves) {
+      painter.drawPolyline(curve);
+    }
+  } else {
     // Just draw the frame.
     const dewarping::Curve& topCurve = m_distortionModel.topCurve();
     const dewarping::Curve& bottomCurve = m_distortionModel.bottomCurve();
@@ -221,13 +201,61 @@ void DewarpingView::onPaint(QPainter& painter, const InteractionState& interacti
     painter.drawPolyline(QVector<QPointF>(topCurve.polyline().begin(), topCurve.polyline().end()));
     painter.drawPolyline(QVector<QPointF>(bottomCurve.polyline().begin(), bottomCurve.polyline().end()));
 #endif
-
   }
 
   paintXSpline(painter, interaction, m_topSpline);
   paintXSpline(painter, interaction, m_bottomSpline);
 }  // DewarpingView::onPaint
 
+bool DewarpingView::ensureGridPreview() {
+  if (m_gridPreviewBuilt) {
+    return m_gridPreviewValid;
+  }
+  m_gridPreviewBuilt = true;
+  m_gridPreviewValid = false;
+  m_gridPreview = GridPreview();
+
+  if (!m_distortionModel.isValid()) {
+    return false;
+  }
+
+  const int numVertGridLines = 30;
+  const int numHorGridLines = 30;
+
+  try {
+    GridPreview grid;
+    grid.generatrices.reserve(numVertGridLines);
+    grid.curves.resize(numHorGridLines);
+
+    dewarping::CylindricalSurfaceDewarper dewarper(m_distortionModel.topCurve().polyline(),
+                                                   m_distortionModel.bottomCurve().polyline(),
+                                                   m_depthPerception.value());
+    dewarping::CylindricalSurfaceDewarper::State state;
+
+    for (int j = 0; j < numVertGridLines; ++j) {
+      const double x = j / (numVertGridLines - 1.0);
+      const dewarping::CylindricalSurfaceDewarper::Generatrix gtx(dewarper.mapGeneratrix(x, state));
+      const QPointF gtxP0(gtx.imgLine.pointAt(gtx.pln2img(0)));
+      const QPointF gtxP1(gtx.imgLine.pointAt(gtx.pln2img(1)));
+      grid.generatrices.emplace_back(gtxP0, gtxP1);
+      for (int i = 0; i < numHorGridLines; ++i) {
+        const double y = i / (numHorGridLines - 1.0);
+        grid.curves[i].push_back(gtx.imgLine.pointAt(gtx.pln2img(y)));
+      }
+    }
+
+    m_gridPreview = std::move(grid);
+    m_gridPreviewValid = true;
+  } catch (const std::runtime_error&) {
+    // Still probably a bad model, even though DistortionModel::isValid() was true.
+  }
+  return m_gridPreviewValid;
+}  // DewarpingView::ensureGridPreview
+
+void DewarpingView::invalidateGridPreview() {
+  m_gridPreviewBuilt = false;
+}
+
 void DewarpingView::paintXSpline(QPainter& painter,
                                  const InteractionState& interaction,
                                  const InteractiveXSpline& ispline) {
@@ -273,15 +301,27 @@ void DewarpingView::paintXSpline(QPainter& painter,
 }  // DewarpingView::paintXSpline
 
 void DewarpingView::curveModified(int curveIdx) {
-  if (curveIdx == 0) {
+  // Dragging produces more modifications than repaints, so the curve
+  // is only sampled once it's needed.
+  m_curveModified[curveIdx] = true;
+  invalidateGridPreview();
+  update();
+}
+
+void DewarpingView::updateModelCurves() {
+  if (m_curveModified[0]) {
     m_distortionModel.setTopCurve(dewarping::Curve(m_topSpline.spline()));
-  } else {
+    m_curveModified[0] = false;
+  }
+  if (m_curveModified[1]) {
     m_distortionModel.setBottomCurve(dewarping::Curve(m_bottomSpline.spline()));
+    m_curveModified[1] = false;
   }
-  update();
 }
 
 void DewarpingView::dragFinished() {
+  updateModelCurves();
+
   if ((m_dewarpingOptions.dewarpingMode() == AUTO) || (m_dewarpingOptions.dewarpingMode() == MARGINAL)) {
     m_dewarpingOptions.setDewarpingMode(MANUAL);
   }
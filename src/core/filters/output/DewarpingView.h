@@ -4,10 +4,12 @@
 #ifndef SCANTAILOR_OUTPUT_DEWARPINGVIEW_H_
 #define SCANTAILOR_OUTPUT_DEWARPINGVIEW_H_
 
+#include <QLineF>
 #include <QPointF>
 #include <QPolygonF>
 #include <QRectF>
 #include <QTransform>
+#include <QVector>
 #include <vector>
 
 #include "DepthPerception.h"
@@ -52,6 +54,14 @@ class DewarpingView : public ImageViewBase, protected InteractionHandler {
   void onPaint(QPainter& painter, const InteractionState& interaction) override;
 
  private:
+  /**
+   * The distortion grid drawn over the image, in source image coordinates.
+   */
+  struct GridPreview {
+    std::vector<QLineF> generatrices;
+    std::vector<QVector<QPointF>> curves;
+  };
+
   static void initNewSpline(XSpline& spline,
                             const QPointF& p1,
                             const QPointF& p2,
@@ -61,8 +71,25 @@ class DewarpingView : public ImageViewBase, protected InteractionHandler {
 
   void paintXSpline(QPainter& painter, const InteractionState& interaction, const InteractiveXSpline& ispline);
 
+  /**
+   * \brief Builds the distortion grid from m_distortionModel, unless it's already built.
+   *
+   * Repaints that don't follow a model change (like the ones caused by hovering over
+   * control points, zooming or panning) reuse the grid built before.
+   *
+   * \return Whether the grid could be built.  If not, the model is considered invalid.
+   */
+  bool ensureGridPreview();
+
+  void invalidateGridPreview();
+
   void curveModified(int curveIdx);
 
+  /**
+   * Brings the curves of m_distortionModel in sync with the splines being edited.
+   */
+  void updateModelCurves();
+
   void dragFinished();
 
   QPointF sourceToWidget(const QPointF& pt) const;
@@ -81,6 +108,10 @@ class DewarpingView : public ImageViewBase, protected InteractionHandler {
   DragHandler m_dragHandler;
   ZoomHandler m_zoomHandler;
   QShortcut* m_removeControlPointShortcut;
+  bool m_curveModified[2];
+  GridPreview m_gridPreview;
+  bool m_gridPreviewBuilt;
+  bool m_gridPreviewValid;
 };
 }  // namespace output
 #endif  // ifndef SCANTAILOR_OUTPUT_DEWARPINGVIEW_H_
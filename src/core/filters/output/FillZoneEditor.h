@@ -8,6 +8,7 @@
 #include <QColor>
 #include <QPoint>
 #include <QPointF>
+#include <QPolygonF>
 #include <boost/function.hpp>
 #include <memory>
 
@@ -33,8 +34,8 @@ class FillZoneEditor : public ZoneEditorBase {
  public:
   FillZoneEditor(const QImage& image,
                  const ImagePixmapUnion& downscaledVersion,
-                 const boost::function<QPointF(const QPointF&)>& origToImage,
-                 const boost::function<QPointF(const QPointF&)>& imageToOrig,
+                 const boost::function<QPolygonF(const QPolygonF&)>& origToImage,
+                 const boost::function<QPolygonF(const QPolygonF&)>& imageToOrig,
                  const PageId& pageId,
                  std::shared_ptr<Settings> settings);
 
@@ -76,8 +77,8 @@ class FillZoneEditor : public ZoneEditorBase {
   ColorAdapter m_colorAdapter;
   ColorPickupInteraction m_colorPickupInteraction;
 
-  boost::function<QPointF(const QPointF&)> m_origToImage;
-  boost::function<QPointF(const QPointF&)> m_imageToOrig;
+  boost::function<QPolygonF(const QPolygonF&)> m_origToImage;
+  boost::function<QPolygonF(const QPolygonF&)> m_imageToOrig;
   PageId m_pageId;
   std::shared_ptr<Settings> m_settings;
 };
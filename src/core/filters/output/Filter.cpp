@@ -10,6 +10,7 @@
 #include "CacheDrivenTask.h"
 #include "FilterUiInterface.h"
 #include "OptionsWidget.h"
+#include "ProjectPages.h"
 #include "ProjectReader.h"
 #include "ProjectWriter.h"
 #include "Settings.h"
@@ -18,8 +19,8 @@
 #include "Utils.h"
 
 namespace output {
-Filter::Filter(const PageSelectionAccessor& pageSelectionAccessor)
-    : m_settings(std::make_shared<Settings>()), m_selectedPageOrder(0) {
+Filter::Filter(std::shared_ptr<ProjectPages> pages, const PageSelectionAccessor& pageSelectionAccessor)
+    : m_pages(std::move(pages)), m_settings(std::make_shared<Settings>()), m_selectedPageOrder(0) {
   m_optionsWidget.reset(new OptionsWidget(m_settings, pageSelectionAccessor));
 
   const PageOrderOption::ProviderPtr defaultOrder;
@@ -49,6 +50,9 @@ void Filter::preUpdateUI(FilterUiInterface* ui, const PageInfo& pageInfo) {
 
 QDomElement Filter::saveSettings(const ProjectWriter& writer, QDomDocument& doc) const {
   QDomElement filterEl(doc.createElement("output"));
+  if (m_settings->isDewarpingWarmStartEnabled()) {
+    filterEl.setAttribute("dewarpingWarmStart", "1");
+  }
 
   writer.enumPages(
       [&](const PageId& pageId, int numericId) { this->writePageSettings(doc, filterEl, pageId, numericId); });
@@ -78,6 +82,7 @@ void Filter::loadSettings(const ProjectReader& reader, const QDomElement& filter
   m_settings->clear();
 
   const QDomElement filterEl(filtersEl.namedItem("output").toElement());
+  m_settings->setDewarpingWarmStartEnabled(filterEl.attribute("dewarpingWarmStart") == "1");
 
   const QString pageTagName("page");
   QDomNode node(filterEl.firstChild());
@@ -137,11 +142,31 @@ std::shared_ptr<Task> Filter::createTask(const PageId& pageId,
                                          const bool batch,
                                          const bool debug) {
   ImageViewTab lastTab(TAB_OUTPUT);
+  bool preview = false;
   if (m_optionsWidget.get() != nullptr) {
     lastTab = m_optionsWidget->lastTab();
+    preview = m_optionsWidget->takePreviewRequest() && !batch;
+  }
+  PageId warmStartPageId;
+  if (m_settings->isDewarpingWarmStartEnabled()) {
+    warmStartPageId = previousPageOnSameSide(pageId);
   }
   return std::make_shared<Task>(std::static_pointer_cast<Filter>(shared_from_this()), m_settings,
-                                std::move(thumbnailCache), pageId, outFileNameGen, lastTab, batch, debug);
+                                std::move(thumbnailCache), pageId, warmStartPageId, outFileNameGen, lastTab, batch,
+                                preview, debug);
+}
+
+PageId Filter::previousPageOnSameSide(const PageId& pageId) const {
+  PageId previous;
+  for (const PageInfo& page : m_pages->toPageSequence(getView())) {
+    if (page.id() == pageId) {
+      return previous;
+    }
+    if (page.id().subPage() == pageId.subPage()) {
+      previous = page.id();
+    }
+  }
+  return PageId();
 }
 
 std::shared_ptr<CacheDrivenTask> Filter::createCacheDrivenTask(const OutputFileNameGenerator& outFileNameGen) {
@@ -17,6 +17,7 @@
 #include "SafeDeletingQObjectPtr.h"
 
 class PageSelectionAccessor;
+class ProjectPages;
 class ThumbnailPixmapCache;
 class OutputFileNameGenerator;
 class QString;
@@ -32,7 +33,7 @@ class Filter : public AbstractFilter {
 
   Q_DECLARE_TR_FUNCTIONS(output::Filter)
  public:
-  explicit Filter(const PageSelectionAccessor& pageSelectionAccessor);
+  Filter(std::shared_ptr<ProjectPages> pages, const PageSelectionAccessor& pageSelectionAccessor);
 
   ~Filter() override;
 
@@ -69,6 +70,13 @@ class Filter : public AbstractFilter {
  private:
   void writePageSettings(QDomDocument& doc, QDomElement& filterEl, const PageId& pageId, int numericId) const;
 
+  /**
+   * \brief The closest page before \p pageId on the same side of the book,
+   *        or a null PageId if there is none.
+   */
+  PageId previousPageOnSameSide(const PageId& pageId) const;
+
+  std::shared_ptr<ProjectPages> m_pages;
   std::shared_ptr<Settings> m_settings;
   SafeDeletingQObjectPtr<OptionsWidget> m_optionsWidget;
   PictureZonePropFactory m_pictureZonePropFactory;
@@ -24,6 +24,7 @@ OptionsWidget::OptionsWidget(std::shared_ptr<Settings> settings, const PageSelec
       m_pageSelectionAccessor(pageSelectionAccessor),
       m_despeckleLevel(1.0),
       m_lastTab(TAB_OUTPUT),
+      m_previewRequested(false),
       m_connectionManager(std::bind(&OptionsWidget::setupUiConnections, this)) {
   setupUi(this);
 
@@ -133,6 +134,7 @@ void OptionsWidget::thresholdMethodChanged(int idx) {
   m_colorParams.setBlackWhiteOptions(blackWhiteOptions);
   m_settings->setColorParams(m_pageId, m_colorParams);
 
+  m_previewRequested = true;
   emit reloadRequested();
 }
 
@@ -216,6 +218,7 @@ void OptionsWidget::equalizeIlluminationColorToggled(const bool checked) {
 
 
 void OptionsWidget::binarizationSettingsChanged() {
+  m_previewRequested = true;
   emit reloadRequested();
   emit invalidateThumbnail(m_pageId);
 }
@@ -685,11 +688,18 @@ void OptionsWidget::updateDewarpingDisplay() {
     dewarpingStatusLabel->setText(dewarpingStatus);
   }
 
+  dewarpingWarmStartCB->setChecked(m_settings->isDewarpingWarmStartEnabled());
+
   depthPerceptionSlider->blockSignals(true);
   depthPerceptionSlider->setValue(qRound(m_depthPerception.value() * 10));
   depthPerceptionSlider->blockSignals(false);
 }
 
+void OptionsWidget::dewarpingWarmStartToggled(bool checked) {
+  // Only where the search starts changes, so the pages already processed stay as they are.
+  m_settings->setDewarpingWarmStartEnabled(checked);
+}
+
 void OptionsWidget::savitzkyGolaySmoothingToggled(bool checked) {
   BlackWhiteOptions opt(m_colorParams.blackWhiteOptions());
   opt.setSavitzkyGolaySmoothingEnabled(checked);
@@ -881,6 +891,18 @@ void OptionsWidget::sendReloadRequested() {
   emit reloadRequested();
 }
 
+bool OptionsWidget::takePreviewRequest() {
+  const bool requested = m_previewRequested;
+  m_previewRequested = false;
+  return requested;
+}
+
+void OptionsWidget::refineAfterPreview() {
+  // Not emitting reloadRequested() directly, as we are called
+  // while the preview result is still being delivered.
+  m_delayedReloadRequest.start(0);
+}
+
 #define CONNECT(...) m_connectionManager.addConnection(connect(__VA_ARGS__))
 
 void OptionsWidget::setupUiConnections() {
@@ -917,6 +939,7 @@ void OptionsWidget::setupUiConnections() {
   CONNECT(applySplittingButton, SIGNAL(clicked()), this, SLOT(applySplittingButtonClicked()));
 
   CONNECT(changeDewarpingButton, SIGNAL(clicked()), this, SLOT(changeDewarpingButtonClicked()));
+  CONNECT(dewarpingWarmStartCB, SIGNAL(clicked(bool)), this, SLOT(dewarpingWarmStartToggled(bool)));
 
   CONNECT(applyDepthPerceptionButton, SIGNAL(clicked()), this, SLOT(applyDepthPerceptionButtonClicked()));
 
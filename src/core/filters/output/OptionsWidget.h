@@ -50,6 +50,19 @@ class OptionsWidget : public FilterOptionsWidget, private Ui::OptionsWidget {
 
   const DepthPerception& depthPerception() const;
 
+  /**
+   * \brief Returns whether the pending reload may start with a low resolution preview.
+   *
+   * The request is reset by this call, so only the first task created
+   * after a parameter change renders a preview.
+   */
+  bool takePreviewRequest();
+
+  /**
+   * \brief Requests the full resolution reload following a displayed preview.
+   */
+  void refineAfterPreview();
+
  signals:
 
   void despeckleLevelChanged(double level, bool* handled);
@@ -148,6 +161,8 @@ class OptionsWidget : public FilterOptionsWidget, private Ui::OptionsWidget {
 
   void dewarpingChanged(const std::set<PageId>& pages, const DewarpingOptions& opt);
 
+  void dewarpingWarmStartToggled(bool checked);
+
   void applyDepthPerceptionButtonClicked();
 
   void applyDepthPerceptionConfirmed(const std::set<PageId>& pages);
@@ -187,6 +202,7 @@ class OptionsWidget : public FilterOptionsWidget, private Ui::OptionsWidget {
   double m_despeckleLevel;
   ImageViewTab m_lastTab;
   QTimer m_delayedReloadRequest;
+  bool m_previewRequested;
 
   ConnectionManager m_connectionManager;
 };
@@ -16,6 +16,7 @@
 #include <DrawOver.h>
 #include <GrayRasterOp.h>
 #include <Grayscale.h>
+#include <HitMissReplacer.h>
 #include <InfluenceMap.h>
 #include <Morphology.h>
 #include <OrthogonalRotation.h>
@@ -59,6 +60,7 @@
 #include "FillColorProperty.h"
 #include "FilterData.h"
 #include "ForegroundType.h"
+#include "ImagePyramidCache.h"
 #include "OutputImageBuilder.h"
 #include "OutputProcessingParams.h"
 #include "Params.h"
@@ -98,6 +100,7 @@ class OutputGenerator::Processor {
   Processor(const OutputGenerator& generator,
             const PageId& pageId,
             const std::shared_ptr<Settings>& settings,
+            const PageId& warmStartPageId,
             const FilterData& input,
             const TaskStatus& status,
             DebugImages* dbg);
@@ -211,6 +214,7 @@ class OutputGenerator::Processor {
 
   const PageId m_pageId;
   const std::shared_ptr<Settings> m_settings;
+  const PageId m_warmStartPageId;
 
   Dpi m_dpi;
   ColorParams m_colorParams;
@@ -257,14 +261,16 @@ std::unique_ptr<OutputImage> OutputGenerator::process(const TaskStatus& status,
                                                       BinaryImage* specklesImage,
                                                       DebugImages* dbg,
                                                       const PageId& pageId,
-                                                      const std::shared_ptr<Settings>& settings) const {
-  return Processor(*this, pageId, settings, input, status, dbg)
+                                                      const std::shared_ptr<Settings>& settings,
+                                                      const PageId& warmStartPageId) const {
+  return Processor(*this, pageId, settings, warmStartPageId, input, status, dbg)
       .process(pictureZones, fillZones, distortionModel, depthPerception, autoPictureMask, specklesImage);
 }
 
 OutputGenerator::Processor::Processor(const OutputGenerator& generator,
                                       const PageId& pageId,
                                       const std::shared_ptr<Settings>& settings,
+                                      const PageId& warmStartPageId,
                                       const FilterData& input,
                                       const TaskStatus& status,
                                       DebugImages* dbg)
@@ -273,6 +279,7 @@ OutputGenerator::Processor::Processor(const OutputGenerator& generator,
       m_contentRect(generator.m_contentRect),
       m_pageId(pageId),
       m_settings(settings),
+      m_warmStartPageId(warmStartPageId),
       m_despeckleLevel(0),
       m_blank(false),
       m_blackOnWhite(true),
@@ -616,7 +623,7 @@ Zone createPictureZoneFromPoly(const QPolygonF& polygon) {
 
 void applyFillZonesInPlace(QImage& img,
                            const ZoneSet& zones,
-                           const boost::function<QPointF(const QPointF&)>& origToOutput,
+                           const boost::function<QPolygonF(const QPolygonF&)>& origToOutput,
                            bool antialiasing = true) {
   if (zones.empty()) {
     return;
@@ -643,16 +650,16 @@ void applyFillZonesInPlace(QImage& img,
   }
 }
 
-using MapPointFunc = QPointF (QTransform::*)(const QPointF&) const;
+using MapPolygonFunc = QPolygonF (QTransform::*)(const QPolygonF&) const;
 
 void applyFillZonesInPlace(QImage& img, const ZoneSet& zones, const QTransform& transform, bool antialiasing = true) {
-  applyFillZonesInPlace(img, zones, boost::bind(static_cast<MapPointFunc>(&QTransform::map), transform, boost::placeholders::_1),
+  applyFillZonesInPlace(img, zones, boost::bind(static_cast<MapPolygonFunc>(&QTransform::map), transform, boost::placeholders::_1),
                         antialiasing);
 }
 
 void applyFillZonesInPlace(BinaryImage& img,
                            const ZoneSet& zones,
-                           const boost::function<QPointF(const QPointF&)>& origToOutput) {
+                           const boost::function<QPolygonF(const QPolygonF&)>& origToOutput) {
   if (zones.empty()) {
     return;
   }
@@ -666,12 +673,12 @@ void applyFillZonesInPlace(BinaryImage& img,
 }
 
 void applyFillZonesInPlace(BinaryImage& img, const ZoneSet& zones, const QTransform& transform) {
-  applyFillZonesInPlace(img, zones, boost::bind(static_cast<MapPointFunc>(&QTransform::map), transform, boost::placeholders::_1));
+  applyFillZonesInPlace(img, zones, boost::bind(static_cast<MapPolygonFunc>(&QTransform::map), transform, boost::placeholders::_1));
 }
 
 void applyFillZonesToMixedInPlace(QImage& img,
                                   const ZoneSet& zones,
-                                  const boost::function<QPointF(const QPointF&)>& origToOutput,
+                                  const boost::function<QPolygonF(const QPolygonF&)>& origToOutput,
                                   const BinaryImage& pictureMask,
                                   bool binaryMode) {
   if (binaryMode) {
@@ -693,13 +700,13 @@ void applyFillZonesToMixedInPlace(QImage& img,
                                   const QTransform& transform,
                                   const BinaryImage& pictureMask,
                                   bool binaryMode) {
-  applyFillZonesToMixedInPlace(img, zones, boost::bind(static_cast<MapPointFunc>(&QTransform::map), transform, boost::placeholders::_1),
+  applyFillZonesToMixedInPlace(img, zones, boost::bind(static_cast<MapPolygonFunc>(&QTransform::map), transform, boost::placeholders::_1),
                                pictureMask, binaryMode);
 }
 
 void applyFillZonesToMask(BinaryImage& mask,
                           const ZoneSet& zones,
-                          const boost::function<QPointF(const QPointF&)>& origToOutput,
+                          const boost::function<QPolygonF(const QPolygonF&)>& origToOutput,
                           const BWColor fillColor = BLACK) {
   if (zones.empty()) {
     return;
@@ -715,7 +722,7 @@ void applyFillZonesToMask(BinaryImage& mask,
                           const ZoneSet& zones,
                           const QTransform& transform,
                           const BWColor fillColor = BLACK) {
-  applyFillZonesToMask(mask, zones, boost::bind((MapPointFunc) &QTransform::map, transform,
+  applyFillZonesToMask(mask, zones, boost::bind((MapPolygonFunc) &QTransform::map, transform,
                                                 boost::placeholders::_1), fillColor);
 }
 
@@ -941,54 +948,6 @@ void applyAffineTransform(BinaryImage& image, const QTransform& xform, const BWC
   image = BinaryImage(converted);
 }
 
-void hitMissReplaceAllDirections(BinaryImage& img,
-                                 const char* const pattern,
-                                 const int patternWidth,
-                                 const int patternHeight) {
-  hitMissReplaceInPlace(img, WHITE, pattern, patternWidth, patternHeight);
-
-  std::vector<char> patternData(static_cast<unsigned long long int>(patternWidth * patternHeight), ' ');
-  char* const newPattern = &patternData[0];
-
-  // Rotate 90 degrees clockwise.
-  const char* p = pattern;
-  int newWidth = patternHeight;
-  int newHeight = patternWidth;
-  for (int y = 0; y < patternHeight; ++y) {
-    for (int x = 0; x < patternWidth; ++x, ++p) {
-      const int newX = patternHeight - 1 - y;
-      const int newY = x;
-      newPattern[newY * newWidth + newX] = *p;
-    }
-  }
-  hitMissReplaceInPlace(img, WHITE, newPattern, newWidth, newHeight);
-
-  // Rotate upside down.
-  p = pattern;
-  newWidth = patternWidth;
-  newHeight = patternHeight;
-  for (int y = 0; y < patternHeight; ++y) {
-    for (int x = 0; x < patternWidth; ++x, ++p) {
-      const int newX = patternWidth - 1 - x;
-      const int newY = patternHeight - 1 - y;
-      newPattern[newY * newWidth + newX] = *p;
-    }
-  }
-  hitMissReplaceInPlace(img, WHITE, newPattern, newWidth, newHeight);
-  // Rotate 90 degrees counter-clockwise.
-  p = pattern;
-  newWidth = patternHeight;
-  newHeight = patternWidth;
-  for (int y = 0; y < patternHeight; ++y) {
-    for (int x = 0; x < patternWidth; ++x, ++p) {
-      const int newX = y;
-      const int newY = patternWidth - 1 - x;
-      newPattern[newY * newWidth + newX] = *p;
-    }
-  }
-  hitMissReplaceInPlace(img, WHITE, newPattern, newWidth, newHeight);
-}
-
 QSize calcLocalWindowSize(const Dpi& dpi) {
   const QSizeF sizeMm(3, 30);
   const QSizeF sizeInch(sizeMm * constants::MM2INCH);
@@ -1593,8 +1552,10 @@ std::unique_ptr<OutputImage> OutputGenerator::Processor::processWithDewarping(Zo
 
   auto mapper = std::make_shared<DewarpingPointMapper>(distortionModel, depthPerception.value(), m_xform.transform(),
                                                        m_croppedContentRect, rotateXform);
-  const boost::function<QPointF(const QPointF&)> origToOutput(
-      boost::bind(&DewarpingPointMapper::mapToDewarpedSpace, mapper, boost::placeholders::_1));
+  using MapPolygonToDewarpedFunc = QPolygonF (DewarpingPointMapper::*)(const QPolygonF&) const;
+  const boost::function<QPolygonF(const QPolygonF&)> origToOutput(
+      boost::bind(static_cast<MapPolygonToDewarpedFunc>(&DewarpingPointMapper::mapToDewarpedSpace), mapper,
+                  boost::placeholders::_1));
 
   BinaryImage dewarpingContentAreaMask(m_inputGrayImage.size(), BLACK);
   {
@@ -1827,7 +1788,18 @@ GrayImage OutputGenerator::Processor::normalizeIlluminationGray(const QImage& in
   QPolygonF transformedConsiderationArea = xform.map(areaToConsider);
   transformedConsiderationArea.translate(-targetRect.topLeft());
 
-  const PolynomialSurface bgPs = estimateBackground(toBeNormalized, transformedConsiderationArea, m_status, m_dbg);
+  // The background only depends on the geometry, so changing colour or binarization
+  // settings doesn't make us estimate it again.  Debugging wants to see the estimation, though.
+  const BackgroundSurfaceKey bgKey(xform, targetRect, areaToConsider, ImagePyramidCache::fingerprint(input));
+  std::unique_ptr<PolynomialSurface> cachedBgPs;
+  if (!m_dbg) {
+    cachedBgPs = m_settings->getBackgroundSurface(m_pageId, bgKey);
+  }
+  const PolynomialSurface bgPs
+      = cachedBgPs ? *cachedBgPs : estimateBackground(toBeNormalized, transformedConsiderationArea, m_status, m_dbg);
+  if (!cachedBgPs) {
+    m_settings->setBackgroundSurface(m_pageId, bgKey, bgPs);
+  }
   m_status.throwIfCancelled();
 
   GrayImage bgImg(bgPs.render(toBeNormalized.size()));
@@ -2116,17 +2088,15 @@ BinaryThreshold OutputGenerator::Processor::calcBinarizationThreshold(const QIma
 
 void OutputGenerator::Processor::morphologicalSmoothInPlace(BinaryImage& binImg) const {
   // When removing black noise, remove small ones first.
-
+  HitMissReplacer replacer;
   {
     const char pattern[]
         = "XXX"
           " - "
           "   ";
-    hitMissReplaceAllDirections(binImg, pattern, 3, 3);
+    replacer.addAllDirections(pattern, 3, 3);
   }
 
-  m_status.throwIfCancelled();
-
   {
     const char pattern[]
         = "X ?"
@@ -2135,11 +2105,9 @@ void OutputGenerator::Processor::morphologicalSmoothInPlace(BinaryImage& binImg)
           "X- "
           "X  "
           "X ?";
-    hitMissReplaceAllDirections(binImg, pattern, 3, 6);
+    replacer.addAllDirections(pattern, 3, 6);
   }
 
-  m_status.throwIfCancelled();
-
   {
     const char pattern[]
         = "X ?"
@@ -2151,11 +2119,9 @@ void OutputGenerator::Processor::morphologicalSmoothInPlace(BinaryImage& binImg)
           "X  "
           "X ?"
           "X ?";
-    hitMissReplaceAllDirections(binImg, pattern, 3, 9);
+    replacer.addAllDirections(pattern, 3, 9);
   }
 
-  m_status.throwIfCancelled();
-
   {
     const char pattern[]
         = "XX?"
@@ -2167,11 +2133,9 @@ void OutputGenerator::Processor::morphologicalSmoothInPlace(BinaryImage& binImg)
           "XX "
           "XX?"
           "XX?";
-    hitMissReplaceAllDirections(binImg, pattern, 3, 9);
+    replacer.addAllDirections(pattern, 3, 9);
   }
 
-  m_status.throwIfCancelled();
-
   {
     const char pattern[]
         = "XX?"
@@ -2180,19 +2144,20 @@ void OutputGenerator::Processor::morphologicalSmoothInPlace(BinaryImage& binImg)
           "X+ "
           "XX "
           "XX?";
-    hitMissReplaceAllDirections(binImg, pattern, 3, 6);
+    replacer.addAllDirections(pattern, 3, 6);
   }
 
-  m_status.throwIfCancelled();
-
   {
     const char pattern[]
         = "   "
           "X+X"
           "XXX";
-    hitMissReplaceAllDirections(binImg, pattern, 3, 3);
+    replacer.addAllDirections(pattern, 3, 3);
   }
 
+  replacer.apply(binImg);
+  m_status.throwIfCancelled();
+
   if (m_dbg) {
     m_dbg->add(binImg, "edges_smoothed");
   }
@@ -2440,15 +2405,38 @@ QImage OutputGenerator::Processor::transformToWorkingCs(bool normalize) const {
 
 DistortionModel OutputGenerator::Processor::buildAutoDistortionModel(const GrayImage& warpedGrayOutput,
                                                                      const QTransform& toOriginal) const {
-  DistortionModelBuilder modelBuilder(Vec2d(0, 1));
+  // Tracing only depends on the geometry, so changing colour or binarization settings
+  // doesn't make us trace the page again.  Debugging wants to see the tracing, though.
+  const TracedCurvesKey tracedCurvesKey(m_xform.transform(), m_workingBoundingRect, m_contentRectInWorkingCs, m_dpi,
+                                        m_renderParams.normalizeIllumination(), m_preCropAreaInOriginalCs,
+                                        m_outsideBackgroundColor, ImagePyramidCache::fingerprint(m_inputGrayImage));
+  std::unique_ptr<DistortionModelBuilder> modelBuilder;
+  if (!m_dbg) {
+    modelBuilder = m_settings->getTracedCurves(m_pageId, tracedCurvesKey);
+  }
+  if (!modelBuilder) {
+    modelBuilder = std::make_unique<DistortionModelBuilder>(Vec2d(0, 1));
 
-  TextLineTracer::trace(warpedGrayOutput, m_dpi, m_contentRectInWorkingCs, modelBuilder, m_status, m_dbg);
-  modelBuilder.transform(toOriginal);
+    TextLineTracer::trace(warpedGrayOutput, m_dpi, m_contentRectInWorkingCs, *modelBuilder, m_status, m_dbg);
+    modelBuilder->transform(toOriginal);
 
-  TopBottomEdgeTracer::trace(m_inputGrayImage, modelBuilder.verticalBounds(), modelBuilder, m_status, m_dbg);
+    TopBottomEdgeTracer::trace(m_inputGrayImage, modelBuilder->verticalBounds(), *modelBuilder, m_status, m_dbg);
 
-  DistortionModel distortionModel = modelBuilder.tryBuildModel(m_dbg, &m_inputGrayImage.toQImage());
-  if (!distortionModel.isValid()) {
+    m_settings->setTracedCurves(m_pageId, tracedCurvesKey, *modelBuilder);
+  }
+
+  // Consecutive pages on the same side tend to be curved alike.
+  if (!m_warmStartPageId.isNull()) {
+    if (const std::unique_ptr<DistortionModelBuilder::WarmStart> warmStart
+        = m_settings->getDistortionModelWarmStart(m_warmStartPageId)) {
+      modelBuilder->setWarmStart(*warmStart);
+    }
+  }
+
+  DistortionModelBuilder::WarmStart builtModel;
+  DistortionModel distortionModel = modelBuilder->tryBuildModel(m_dbg, &m_inputGrayImage.toQImage(), &builtModel);
+  const bool modelBuilt = distortionModel.isValid();
+  if (!modelBuilt) {
     setupTrivialDistortionModel(distortionModel);
   }
 
@@ -2551,6 +2539,9 @@ DistortionModel OutputGenerator::Processor::buildAutoDistortionModel(const GrayI
       }
     }
   }
+
+  // The error lets the next page on this side decide whether the model fits it as well.
+  m_settings->setDistortionModel(m_pageId, distortionModel, modelBuilt ? builtModel.errorPerCurve : 0);
   return distortionModel;
 }
 
@@ -10,7 +10,7 @@
 using namespace foundation;
 
 namespace output {
-Params::Params() : m_dpi(600, 600), m_despeckleLevel(1.0), m_blackOnWhite(true) {}
+Params::Params() : m_dpi(600, 600), m_distortionModelError(0), m_despeckleLevel(1.0), m_blackOnWhite(true) {}
 
 Params::Params(const Dpi& dpi,
                const ColorParams& colorParams,
@@ -25,6 +25,7 @@ Params::Params(const Dpi& dpi,
       m_splittingOptions(splittingOptions),
       m_pictureShapeOptions(pictureShapeOptions),
       m_distortionModel(distortionModel),
+      m_distortionModelError(0),
       m_depthPerception(depthPerception),
       m_dewarpingOptions(dewarpingOptions),
       m_despeckleLevel(despeckleLevel),
@@ -36,6 +37,7 @@ Params::Params(const QDomElement& el)
       m_splittingOptions(el.namedItem("splitting").toElement()),
       m_pictureShapeOptions(el.namedItem("picture-shape-options").toElement()),
       m_distortionModel(el.namedItem("distortion-model").toElement()),
+      m_distortionModelError(el.attribute("distortionModelError").toDouble()),
       m_depthPerception(el.attribute("depthPerception")),
       m_dewarpingOptions(el.namedItem("dewarping-options").toElement()),
       m_despeckleLevel(el.attribute("despeckleLevel").toDouble()),
@@ -46,6 +48,9 @@ QDomElement Params::toXml(QDomDocument& doc, const QString& name) const {
 
   QDomElement el(doc.createElement(name));
   el.appendChild(m_distortionModel.toXml(doc, "distortion-model"));
+  if (m_distortionModelError > 0) {
+    el.setAttribute("distortionModelError", Utils::doubleToString(m_distortionModelError));
+  }
   el.appendChild(m_pictureShapeOptions.toXml(doc, "picture-shape-options"));
   el.setAttribute("depthPerception", m_depthPerception.toString());
   el.appendChild(m_dewarpingOptions.toXml(doc, "dewarping-options"));
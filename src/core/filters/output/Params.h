@@ -56,6 +56,14 @@ class Params {
 
   void setDistortionModel(const dewarping::DistortionModel& model);
 
+  /**
+   * The average text line error the next page on the same side is held to,
+   * if the distortion model was built automatically, or 0 otherwise.
+   */
+  double distortionModelError() const;
+
+  void setDistortionModelError(double error);
+
   const DepthPerception& depthPerception() const;
 
   void setDepthPerception(DepthPerception depthPerception);
@@ -76,6 +84,7 @@ class Params {
   SplittingOptions m_splittingOptions;
   PictureShapeOptions m_pictureShapeOptions;
   dewarping::DistortionModel m_distortionModel;
+  double m_distortionModelError;
   DepthPerception m_depthPerception;
   DewarpingOptions m_dewarpingOptions;
   double m_despeckleLevel;
@@ -131,6 +140,14 @@ inline void Params::setDistortionModel(const dewarping::DistortionModel& model)
   m_distortionModel = model;
 }
 
+inline double Params::distortionModelError() const {
+  return m_distortionModelError;
+}
+
+inline void Params::setDistortionModelError(const double error) {
+  m_distortionModelError = error;
+}
+
 inline const DepthPerception& Params::depthPerception() const {
   return m_depthPerception;
 }
@@ -188,7 +188,7 @@ void PictureZoneEditor::initiateBuildingScreenPictureMask() {
   const QTransform xform(virtualToWidget());
   const auto task = std::make_shared<MaskTransformTask>(this, m_origPictureMask, xform, viewport()->size());
 
-  backgroundExecutor().enqueueTask(task);
+  backgroundExecutor().enqueueTask(task, BackgroundExecutor::ZONE_MASK_LANE, this, backgroundTaskPriority());
 
   m_screenPictureMask = QPixmap();
   m_maskTransformTask = task;
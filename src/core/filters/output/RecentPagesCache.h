@@ -0,0 +1,83 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#ifndef SCANTAILOR_OUTPUT_RECENTPAGESCACHE_H_
+#define SCANTAILOR_OUTPUT_RECENTPAGESCACHE_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <list>
+#include <memory>
+
+#include "PageId.h"
+
+namespace output {
+/**
+ * \brief Intermediate results of processing the few most recently used pages.
+ *
+ * Each value is stored along with the key of everything it was computed from,
+ * and it's only given back for the same key.  Pages that weren't used for a while
+ * are forgotten, so the memory stays bounded however many pages a project has.
+ *
+ * The class is not thread-safe.
+ */
+template <typename Key, typename Value>
+class RecentPagesCache {
+ public:
+  explicit RecentPagesCache(size_t maxPages) : m_maxPages(std::max<size_t>(maxPages, 1)) {}
+
+  /**
+   * \brief Returns a copy of the value stored for \p pageId,
+   *        or null unless it was stored with the same \p key.
+   */
+  std::unique_ptr<Value> find(const PageId& pageId, const Key& key);
+
+  /**
+   * \brief Stores the value of \p pageId, replacing the previous one.
+   */
+  void store(const PageId& pageId, const Key& key, const Value& value);
+
+  void clear() { m_entries.clear(); }
+
+ private:
+  struct Entry {
+    PageId pageId;
+    Key key;
+    Value value;
+  };
+
+  typename std::list<Entry>::iterator findPage(const PageId& pageId) {
+    return std::find_if(m_entries.begin(), m_entries.end(),
+                        [&pageId](const Entry& entry) { return entry.pageId == pageId; });
+  }
+
+  size_t m_maxPages;
+
+  /** The most recently used entries are at the front. */
+  std::list<Entry> m_entries;
+};
+
+
+template <typename Key, typename Value>
+std::unique_ptr<Value> RecentPagesCache<Key, Value>::find(const PageId& pageId, const Key& key) {
+  const auto it = findPage(pageId);
+  if ((it == m_entries.end()) || !(it->key == key)) {
+    return nullptr;
+  }
+  m_entries.splice(m_entries.begin(), m_entries, it);
+  return std::make_unique<Value>(m_entries.front().value);
+}
+
+template <typename Key, typename Value>
+void RecentPagesCache<Key, Value>::store(const PageId& pageId, const Key& key, const Value& value) {
+  const auto it = findPage(pageId);
+  if (it != m_entries.end()) {
+    m_entries.erase(it);
+  }
+  m_entries.push_front(Entry{pageId, key, value});
+  while (m_entries.size() > m_maxPages) {
+    m_entries.pop_back();
+  }
+}
+}  // namespace output
+#endif  // ifndef SCANTAILOR_OUTPUT_RECENTPAGESCACHE_H_
@@ -12,8 +12,21 @@
 using namespace core;
 
 namespace output {
+namespace {
+/**
+ * The number of pages to keep the traced curves and background surfaces of.
+ * Those are reused when reprocessing a page with other settings, which is done
+ * to the page at hand, so a few pages are enough to go back and forth.
+ */
+const size_t MAX_RECENT_PAGES = 8;
+}  // namespace
+
 Settings::Settings()
-    : m_defaultPictureZoneProps(initialPictureZoneProps()), m_defaultFillZoneProps(initialFillZoneProps()) {}
+    : m_defaultPictureZoneProps(initialPictureZoneProps()),
+      m_defaultFillZoneProps(initialFillZoneProps()),
+      m_dewarpingWarmStartEnabled(false),
+      m_recentTracedCurves(MAX_RECENT_PAGES),
+      m_recentBackgroundSurfaces(MAX_RECENT_PAGES) {}
 
 Settings::~Settings() = default;
 
@@ -27,6 +40,9 @@ void Settings::clear() {
   m_perPagePictureZones.clear();
   m_perPageFillZones.clear();
   m_perPageOutputProcessingParams.clear();
+  m_dewarpingWarmStartEnabled = false;
+  m_recentTracedCurves.clear();
+  m_recentBackgroundSurfaces.clear();
 }
 
 void Settings::performRelinking(const AbstractRelinker& relinker) {
@@ -78,6 +94,8 @@ void Settings::performRelinking(const AbstractRelinker& relinker) {
   m_perPagePictureZones.swap(newPictureZones);
   m_perPageFillZones.swap(newFillZones);
   m_perPageOutputProcessingParams.swap(newOutputProcessingParams);
+  m_recentTracedCurves.clear();
+  m_recentBackgroundSurfaces.clear();
 }  // Settings::performRelinking
 
 Params Settings::getParams(const PageId& pageId) const {
@@ -161,16 +179,18 @@ void Settings::setSplittingOptions(const PageId& pageId, const SplittingOptions&
   }
 }
 
-void Settings::setDistortionModel(const PageId& pageId, const dewarping::DistortionModel& model) {
+void Settings::setDistortionModel(const PageId& pageId, const dewarping::DistortionModel& model, const double error) {
   const QMutexLocker locker(&m_mutex);
 
   const auto it(m_perPageParams.find(pageId));
   if (it == m_perPageParams.end()) {
     Params params;
     params.setDistortionModel(model);
+    params.setDistortionModelError(error);
     m_perPageParams.insert(it, PerPageParams::value_type(pageId, params));
   } else {
     it->second.setDistortionModel(model);
+    it->second.setDistortionModelError(error);
   }
 }
 
@@ -318,4 +338,56 @@ void Settings::setBlackOnWhite(const PageId& pageId, const bool blackOnWhite) {
     it->second.setBlackOnWhite(blackOnWhite);
   }
 }
-}  // namespace output
\ No newline at end of file
+
+std::unique_ptr<dewarping::DistortionModelBuilder::WarmStart> Settings::getDistortionModelWarmStart(
+    const PageId& pageId) const {
+  const QMutexLocker locker(&m_mutex);
+
+  const auto it(m_perPageParams.find(pageId));
+  if ((it == m_perPageParams.end()) || (it->second.dewarpingOptions().dewarpingMode() != AUTO)
+      || !it->second.distortionModel().isValid() || !(it->second.distortionModelError() > 0)) {
+    return nullptr;
+  }
+
+  auto warmStart = std::make_unique<dewarping::DistortionModelBuilder::WarmStart>();
+  warmStart->model = it->second.distortionModel();
+  warmStart->errorPerCurve = it->second.distortionModelError();
+  return warmStart;
+}
+
+bool Settings::isDewarpingWarmStartEnabled() const {
+  const QMutexLocker locker(&m_mutex);
+  return m_dewarpingWarmStartEnabled;
+}
+
+void Settings::setDewarpingWarmStartEnabled(const bool enabled) {
+  const QMutexLocker locker(&m_mutex);
+  m_dewarpingWarmStartEnabled = enabled;
+}
+
+std::unique_ptr<dewarping::DistortionModelBuilder> Settings::getTracedCurves(const PageId& pageId,
+                                                                             const TracedCurvesKey& key) const {
+  const QMutexLocker locker(&m_mutex);
+  return m_recentTracedCurves.find(pageId, key);
+}
+
+void Settings::setTracedCurves(const PageId& pageId,
+                               const TracedCurvesKey& key,
+                               const dewarping::DistortionModelBuilder& tracedCurves) {
+  const QMutexLocker locker(&m_mutex);
+  m_recentTracedCurves.store(pageId, key, tracedCurves);
+}
+
+std::unique_ptr<imageproc::PolynomialSurface> Settings::getBackgroundSurface(const PageId& pageId,
+                                                                             const BackgroundSurfaceKey& key) const {
+  const QMutexLocker locker(&m_mutex);
+  return m_recentBackgroundSurfaces.find(pageId, key);
+}
+
+void Settings::setBackgroundSurface(const PageId& pageId,
+                                    const BackgroundSurfaceKey& key,
+                                    const imageproc::PolynomialSurface& surface) {
+  const QMutexLocker locker(&m_mutex);
+  m_recentBackgroundSurfaces.store(pageId, key, surface);
+}
+}  // namespace output
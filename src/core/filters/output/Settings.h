@@ -5,11 +5,14 @@
 #define SCANTAILOR_OUTPUT_SETTINGS_H_
 
 #include <DistortionModel.h>
+#include <DistortionModelBuilder.h>
+#include <PolynomialSurface.h>
 
 #include <QMutex>
 #include <memory>
 #include <unordered_map>
 
+#include "BackgroundSurfaceKey.h"
 #include "ColorParams.h"
 #include "DespeckleLevel.h"
 #include "DewarpingOptions.h"
@@ -20,6 +23,8 @@
 #include "PageId.h"
 #include "Params.h"
 #include "PropertySet.h"
+#include "RecentPagesCache.h"
+#include "TracedCurvesKey.h"
 #include "ZoneSet.h"
 
 class AbstractRelinker;
@@ -55,7 +60,10 @@ class Settings {
 
   void setSplittingOptions(const PageId& pageId, const SplittingOptions& opt);
 
-  void setDistortionModel(const PageId& pageId, const dewarping::DistortionModel& model);
+  /**
+   * \param error The average text line error of an automatically built \p model, or 0.
+   */
+  void setDistortionModel(const PageId& pageId, const dewarping::DistortionModel& model, double error = 0);
 
   void setDepthPerception(const PageId& pageId, const DepthPerception& depthPerception);
 
@@ -93,11 +101,52 @@ class Settings {
 
   void setBlackOnWhite(const PageId& pageId, bool blackOnWhite);
 
+  /**
+   * The distortion model automatically built for \p pageId, along with its error,
+   * to be used as a warm start for the next page on the same side.  Null unless
+   * that page is dewarped automatically and its model error is known.
+   */
+  std::unique_ptr<dewarping::DistortionModelBuilder::WarmStart> getDistortionModelWarmStart(
+      const PageId& pageId) const;
+
+  /**
+   * Whether automatic dewarping starts from the model of the previous page on the same side.
+   * This is a project-wide setting, off by default, as the result then depends on that page.
+   */
+  bool isDewarpingWarmStartEnabled() const;
+
+  void setDewarpingWarmStartEnabled(bool enabled);
+
+  /**
+   * The text lines and content bounds traced on a page for automatic dewarping,
+   * or null unless they were traced with the same \p key.  Those are only kept in memory,
+   * and only for a few recently processed pages.
+   */
+  std::unique_ptr<dewarping::DistortionModelBuilder> getTracedCurves(const PageId& pageId,
+                                                                     const TracedCurvesKey& key) const;
+
+  void setTracedCurves(const PageId& pageId,
+                       const TracedCurvesKey& key,
+                       const dewarping::DistortionModelBuilder& tracedCurves);
+
+  /**
+   * The background surface estimated on a page for illumination normalization,
+   * or null unless it was estimated with the same \p key.  Those are kept like traced curves.
+   */
+  std::unique_ptr<imageproc::PolynomialSurface> getBackgroundSurface(const PageId& pageId,
+                                                                     const BackgroundSurfaceKey& key) const;
+
+  void setBackgroundSurface(const PageId& pageId,
+                            const BackgroundSurfaceKey& key,
+                            const imageproc::PolynomialSurface& surface);
+
  private:
   using PerPageParams = std::unordered_map<PageId, Params>;
   using PerPageOutputParams = std::unordered_map<PageId, OutputParams>;
   using PerPageZones = std::unordered_map<PageId, ZoneSet>;
   using PerPageOutputProcessingParams = std::unordered_map<PageId, OutputProcessingParams>;
+  using RecentTracedCurves = RecentPagesCache<TracedCurvesKey, dewarping::DistortionModelBuilder>;
+  using RecentBackgroundSurfaces = RecentPagesCache<BackgroundSurfaceKey, imageproc::PolynomialSurface>;
 
   static PropertySet initialPictureZoneProps();
 
@@ -111,6 +160,9 @@ class Settings {
   PropertySet m_defaultPictureZoneProps;
   PropertySet m_defaultFillZoneProps;
   PerPageOutputProcessingParams m_perPageOutputProcessingParams;
+  bool m_dewarpingWarmStartEnabled;
+  mutable RecentTracedCurves m_recentTracedCurves;
+  mutable RecentBackgroundSurfaces m_recentBackgroundSurfaces;
 };
 }  // namespace output
 #endif  // ifndef SCANTAILOR_OUTPUT_SETTINGS_H_
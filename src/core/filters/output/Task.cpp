@@ -9,6 +9,7 @@
 #include <core/TiffWriter.h>
 
 #include <QDir>
+#include <algorithm>
 #include <boost/bind/bind.hpp>
 #include <utility>
 
@@ -60,6 +61,7 @@ class Task::UiUpdater : public FilterResult {
             const DespeckleState& despeckleState,
             const DespeckleVisualization& despeckleVisualization,
             bool batch,
+            bool preview,
             bool debug);
 
   void updateUI(FilterUiInterface* ui) override;
@@ -82,25 +84,38 @@ class Task::UiUpdater : public FilterResult {
   DespeckleState m_despeckleState;
   DespeckleVisualization m_despeckleVisualization;
   bool m_batchProcessing;
+  bool m_preview;
   bool m_debug;
 };
 
+namespace {
+/**
+ * The resolution interactive previews are rendered at.  That's about
+ * what one gets on screen with the whole page fitting the view.
+ */
+const int PREVIEW_DPI = 150;
+}  // namespace
+
 
 Task::Task(std::shared_ptr<Filter> filter,
            std::shared_ptr<Settings> settings,
            std::shared_ptr<ThumbnailPixmapCache> thumbnailCache,
            const PageId& pageId,
+           const PageId& warmStartPageId,
            const OutputFileNameGenerator& outFileNameGen,
            const ImageViewTab lastTab,
            const bool batch,
+           const bool preview,
            const bool debug)
     : m_filter(std::move(filter)),
       m_settings(std::move(settings)),
       m_thumbnailCache(std::move(thumbnailCache)),
       m_pageId(pageId),
+      m_warmStartPageId(warmStartPageId),
       m_outFileNameGen(outFileNameGen),
       m_lastTab(lastTab),
       m_batchProcessing(batch),
+      m_preview(preview),
       m_debug(debug) {
   if (debug) {
     m_dbg = std::make_unique<DebugImagesImpl>();
@@ -297,6 +312,13 @@ FilterResultPtr Task::process(const TaskStatus& status, const FilterData& data,
     }
   }
 
+  if (needReprocess && m_preview) {
+    if (FilterResultPtr previewResult
+        = processPreview(status, data, contentRectPhys, params, newPictureZones, newFillZones)) {
+      return previewResult;
+    }
+  }
+
   if (needReprocess) {
     // Even in batch processing mode we should still write automask, because it
     // will be needed when we view the results back in interactive mode.
@@ -321,7 +343,7 @@ FilterResultPtr Task::process(const TaskStatus& status, const FilterData& data,
       std::unique_ptr<OutputImage> outputImage
           = generator.process(status, data, newPictureZones, newFillZones, distortionModel, params.depthPerception(),
                               writeAutomask ? &automaskImg : nullptr, writeSpecklesFile ? &specklesImg : nullptr,
-                              m_dbg.get(), m_pageId, m_settings);
+                              m_dbg.get(), m_pageId, m_settings, m_warmStartPageId);
 
       params = m_settings->getParams(m_pageId);
 
@@ -436,9 +458,91 @@ FilterResultPtr Task::process(const TaskStatus& status, const FilterData& data,
   }
   return std::make_shared<UiUpdater>(m_filter, m_settings, std::move(m_dbg), params, newXform,
                                      generator.outputContentRect(), m_pageId, data.origImage(), outImg, automaskImg,
-                                     despeckleState, despeckleVisualization, m_batchProcessing, m_debug);
+                                     despeckleState, despeckleVisualization, m_batchProcessing, false, m_debug);
 }  // Task::process
 
+FilterResultPtr Task::processPreview(const TaskStatus& status,
+                                     const FilterData& data,
+                                     const QPolygonF& contentRectPhys,
+                                     const Params& params,
+                                     const ZoneSet& pictureZones,
+                                     const ZoneSet& fillZones) {
+  const Dpi& outputDpi = params.outputDpi();
+  if (std::min(outputDpi.horizontal(), outputDpi.vertical()) * 5 <= PREVIEW_DPI * 6) {
+    // The preview wouldn't be noticeably faster than the real thing.
+    return nullptr;
+  }
+
+  DewarpingOptions dewarpingOptions(params.dewarpingOptions());
+  DistortionModel distortionModel;
+  if (dewarpingOptions.dewarpingMode() != OFF) {
+    if (!params.distortionModel().isValid()) {
+      // Building a distortion model takes long and has to be done
+      // on the full resolution image anyway.
+      return nullptr;
+    }
+    // Reuse the model built previously, even in auto modes.
+    dewarpingOptions.setDewarpingMode(MANUAL);
+    distortionModel = params.distortionModel();
+  }
+
+  const double scale = double(PREVIEW_DPI) / outputDpi.vertical();
+  const Dpi previewDpi(qRound(outputDpi.horizontal() * scale), PREVIEW_DPI);
+
+  // Local binarization windows are measured in pixels,
+  // so they have to shrink along with the image.
+  ColorParams colorParams(params.colorParams());
+  BlackWhiteOptions blackWhiteOptions(colorParams.blackWhiteOptions());
+  blackWhiteOptions.setWindowSize(std::max(3, qRound(blackWhiteOptions.getWindowSize() * scale)));
+  colorParams.setBlackWhiteOptions(blackWhiteOptions);
+
+  Params previewParams(params);
+  previewParams.setOutputDpi(previewDpi);
+  previewParams.setColorParams(colorParams);
+  previewParams.setDewarpingOptions(dewarpingOptions);
+
+  // OutputGenerator writes its findings back to the settings,
+  // which must not happen for a preview, so it gets a scratch copy.
+  auto previewSettings = std::make_shared<Settings>();
+  previewSettings->setParams(m_pageId, previewParams);
+  previewSettings->setOutputProcessingParams(m_pageId, m_settings->getOutputProcessingParams(m_pageId));
+  previewSettings->setPictureZones(m_pageId, pictureZones);
+  previewSettings->setFillZones(m_pageId, fillZones);
+  previewSettings->setDefaultPictureZoneProperties(m_settings->defaultPictureZoneProperties());
+  previewSettings->setDefaultFillZoneProperties(m_settings->defaultFillZoneProperties());
+
+  ImageTransformation previewXform(data.xform());
+  previewXform.postScaleToDpi(previewDpi);
+
+  const RenderParams renderParams(colorParams, params.splittingOptions());
+  const bool needAutomask = renderParams.mixedOutput();
+  const bool needSpecklesImage = ((params.despeckleLevel() != .0) && renderParams.needBinarization());
+
+  BinaryImage automaskImg;
+  BinaryImage specklesImg;
+
+  const OutputGenerator generator(previewXform, contentRectPhys);
+  const std::unique_ptr<OutputImage> outputImage
+      = generator.process(status, data, pictureZones, fillZones, distortionModel, params.depthPerception(),
+                          needAutomask ? &automaskImg : nullptr, needSpecklesImage ? &specklesImg : nullptr, nullptr,
+                          m_pageId, previewSettings);
+  const QImage outImg(*outputImage);
+
+  if (needSpecklesImage && specklesImg.isNull()) {
+    BinaryImage(outImg.size(), WHITE).swap(specklesImg);
+  }
+
+  const DespeckleState despeckleState(outImg, specklesImg, params.despeckleLevel(), previewDpi);
+
+  DespeckleVisualization despeckleVisualization;
+  if (m_lastTab == TAB_DESPECKLING) {
+    despeckleVisualization = despeckleState.visualize();
+  }
+  return std::make_shared<UiUpdater>(m_filter, m_settings, std::move(m_dbg), params, previewXform,
+                                     generator.outputContentRect(), m_pageId, data.origImage(), outImg, automaskImg,
+                                     despeckleState, despeckleVisualization, m_batchProcessing, true, m_debug);
+}  // Task::processPreview
+
 /**
  * Delete output files mutually exclusive to m_pageId.
  */
@@ -470,6 +574,7 @@ Task::UiUpdater::UiUpdater(std::shared_ptr<Filter> filter,
                            const DespeckleState& despeckleState,
                            const DespeckleVisualization& despeckleVisualization,
                            const bool batch,
+                           const bool preview,
                            const bool debug)
     : m_filter(std::move(filter)),
       m_settings(std::move(settings)),
@@ -479,18 +584,22 @@ Task::UiUpdater::UiUpdater(std::shared_ptr<Filter> filter,
       m_virtContentRect(virtContentRect),
       m_pageId(pageId),
       m_origImage(origImage),
-      m_downscaledOrigImage(ImageView::createDownscaledImage(origImage)),
+      m_downscaledOrigImage(ImageView::createDownscaledImage(origImage, pageId.imageId())),
       m_outputImage(outputImage),
       m_downscaledOutputImage(ImageView::createDownscaledImage(outputImage)),
       m_pictureMask(pictureMask),
       m_despeckleState(despeckleState),
       m_despeckleVisualization(despeckleVisualization),
       m_batchProcessing(batch),
+      m_preview(preview),
       m_debug(debug) {}
 
 void Task::UiUpdater::updateUI(FilterUiInterface* ui) {
   // This function is executed from the GUI thread.
-  ui->invalidateThumbnail(m_pageId);
+  if (!m_preview) {
+    // Nothing was written while making a preview.
+    ui->invalidateThumbnail(m_pageId);
+  }
 
   if (m_batchProcessing) {
     return;
@@ -538,19 +647,22 @@ void Task::UiUpdater::updateUI(FilterUiInterface* ui) {
   // In OptionsWidget::dewarpingChanged() we make sure to reload
   // if we are on the "Fill Zones" tab, and if not, it will be reloaded
   // anyway when another tab is selected.
-  boost::function<QPointF(const QPointF&)> origToOutput;
-  boost::function<QPointF(const QPointF&)> outputToOrig;
+  boost::function<QPolygonF(const QPolygonF&)> origToOutput;
+  boost::function<QPolygonF(const QPolygonF&)> outputToOrig;
   if ((m_params.dewarpingOptions().dewarpingMode() != OFF) && m_params.distortionModel().isValid()) {
     const QTransform rotateXform
         = Utils::rotate(m_params.dewarpingOptions().getPostDeskewAngle(), m_xform.resultingRect().toRect());
     auto mapper = std::make_shared<DewarpingPointMapper>(m_params.distortionModel(), m_params.depthPerception().value(),
                                                          m_xform.transform(), m_virtContentRect, rotateXform);
-    origToOutput = boost::bind(&DewarpingPointMapper::mapToDewarpedSpace, mapper, boost::placeholders::_1);
-    outputToOrig = boost::bind(&DewarpingPointMapper::mapToWarpedSpace, mapper, boost::placeholders::_1);
+    using MapPolygonFunc = QPolygonF (DewarpingPointMapper::*)(const QPolygonF&) const;
+    origToOutput = boost::bind((MapPolygonFunc) &DewarpingPointMapper::mapToDewarpedSpace, mapper,
+                               boost::placeholders::_1);
+    outputToOrig = boost::bind((MapPolygonFunc) &DewarpingPointMapper::mapToWarpedSpace, mapper,
+                               boost::placeholders::_1);
   } else {
-    using MapPointFunc = QPointF (QTransform::*)(const QPointF&) const;
-    origToOutput = boost::bind((MapPointFunc) &QTransform::map, m_xform.transform(), boost::placeholders::_1);
-    outputToOrig = boost::bind((MapPointFunc) &QTransform::map, m_xform.transformBack(), boost::placeholders::_1);
+    using MapPolygonFunc = QPolygonF (QTransform::*)(const QPolygonF&) const;
+    origToOutput = boost::bind((MapPolygonFunc) &QTransform::map, m_xform.transform(), boost::placeholders::_1);
+    outputToOrig = boost::bind((MapPolygonFunc) &QTransform::map, m_xform.transformBack(), boost::placeholders::_1);
   }
 
   auto fillZoneEditor = std::make_unique<FillZoneEditor>(m_outputImage, downscaledOutputPixmap, origToOutput,
@@ -583,5 +695,10 @@ void Task::UiUpdater::updateUI(FilterUiInterface* ui) {
   QObject::connect(tabWidget.get(), SIGNAL(tabChanged(ImageViewTab)), optWidget, SLOT(tabChanged(ImageViewTab)));
 
   ui->setImageWidget(tabWidget.release(), ui->TRANSFER_OWNERSHIP, m_dbg.get());
+
+  if (m_preview) {
+    // Now that the preview is on screen, do the real thing.
+    optWidget->refineAfterPreview();
+  }
 }  // Task::UiUpdater::updateUI
 }  // namespace output
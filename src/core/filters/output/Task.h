@@ -23,6 +23,7 @@ class QPolygonF;
 class QSize;
 class QImage;
 class Dpi;
+class ZoneSet;
 
 namespace imageproc {
 class BinaryImage;
@@ -31,6 +32,7 @@ class BinaryImage;
 namespace output {
 class Filter;
 class Settings;
+class Params;
 
 class Task {
   DECLARE_NON_COPYABLE(Task)
@@ -40,9 +42,11 @@ class Task {
        std::shared_ptr<Settings> settings,
        std::shared_ptr<ThumbnailPixmapCache> thumbnailCache,
        const PageId& pageId,
+       const PageId& warmStartPageId,
        const OutputFileNameGenerator& outFileNameGen,
        ImageViewTab lastTab,
        bool batch,
+       bool preview,
        bool debug);
 
   virtual ~Task();
@@ -52,6 +56,19 @@ class Task {
  private:
   class UiUpdater;
 
+  /**
+   * \brief Renders the page at a reduced resolution without saving anything.
+   *
+   * \return The preview result, or null if a preview isn't worth it
+   *         or isn't possible, in which case the full processing should be done.
+   */
+  FilterResultPtr processPreview(const TaskStatus& status,
+                                 const FilterData& data,
+                                 const QPolygonF& contentRectPhys,
+                                 const Params& params,
+                                 const ZoneSet& pictureZones,
+                                 const ZoneSet& fillZones);
+
   void deleteMutuallyExclusiveOutputFiles();
 
   std::shared_ptr<Filter> m_filter;
@@ -59,9 +76,11 @@ class Task {
   std::shared_ptr<ThumbnailPixmapCache> m_thumbnailCache;
   std::unique_ptr<DebugImages> m_dbg;
   PageId m_pageId;
+  PageId m_warmStartPageId;
   OutputFileNameGenerator m_outFileNameGen;
   ImageViewTab m_lastTab;
   bool m_batchProcessing;
+  bool m_preview;
   bool m_debug;
 };
 }  // namespace output
@@ -0,0 +1,34 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#include "TracedCurvesKey.h"
+
+namespace output {
+TracedCurvesKey::TracedCurvesKey(const QTransform& xform,
+                                 const QRect& workingBoundingRect,
+                                 const QRect& contentRect,
+                                 const Dpi& dpi,
+                                 const bool normalizeIllumination,
+                                 const QPolygonF& preCropArea,
+                                 const QColor& outsideColor,
+                                 const uint64_t imageFingerprint)
+    : m_xform(xform),
+      m_workingBoundingRect(workingBoundingRect),
+      m_contentRect(contentRect),
+      m_dpi(dpi),
+      m_normalizeIllumination(normalizeIllumination),
+      m_preCropArea(normalizeIllumination ? preCropArea : QPolygonF()),
+      m_outsideColor(normalizeIllumination ? QColor() : outsideColor),
+      m_imageFingerprint(imageFingerprint) {}
+
+bool TracedCurvesKey::operator==(const TracedCurvesKey& other) const {
+  return (m_xform == other.m_xform) && (m_workingBoundingRect == other.m_workingBoundingRect)
+         && (m_contentRect == other.m_contentRect) && (m_dpi == other.m_dpi)
+         && (m_normalizeIllumination == other.m_normalizeIllumination) && (m_preCropArea == other.m_preCropArea)
+         && (m_outsideColor == other.m_outsideColor) && (m_imageFingerprint == other.m_imageFingerprint);
+}
+
+bool TracedCurvesKey::operator!=(const TracedCurvesKey& other) const {
+  return !(*this == other);
+}
+}  // namespace output
@@ -0,0 +1,60 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#ifndef SCANTAILOR_OUTPUT_TRACEDCURVESKEY_H_
+#define SCANTAILOR_OUTPUT_TRACEDCURVESKEY_H_
+
+#include <QColor>
+#include <QPolygonF>
+#include <QRect>
+#include <QTransform>
+#include <cstdint>
+
+#include "Dpi.h"
+
+namespace output {
+/**
+ * \brief Everything the text lines and content bounds traced for automatic
+ *        dewarping depend on.
+ *
+ * As long as this stays the same, so does the outcome of tracing, which is the
+ * case when only colour, binarization or despeckling settings of a page change.
+ */
+class TracedCurvesKey {
+ public:
+  /**
+   * \param xform The transformation from the input image to the output one.
+   * \param workingBoundingRect The area of the output image that is traced.
+   * \param contentRect The content rectangle within \p workingBoundingRect.
+   * \param dpi The output DPI.
+   * \param normalizeIllumination Whether illumination is normalized before tracing.
+   * \param preCropArea The area illumination is normalized over, if it is.
+   * \param outsideColor The color assumed for the pixels outside of the input image,
+   *        unless illumination is normalized.
+   * \param imageFingerprint The fingerprint of the input image.
+   */
+  TracedCurvesKey(const QTransform& xform,
+                  const QRect& workingBoundingRect,
+                  const QRect& contentRect,
+                  const Dpi& dpi,
+                  bool normalizeIllumination,
+                  const QPolygonF& preCropArea,
+                  const QColor& outsideColor,
+                  uint64_t imageFingerprint);
+
+  bool operator==(const TracedCurvesKey& other) const;
+
+  bool operator!=(const TracedCurvesKey& other) const;
+
+ private:
+  QTransform m_xform;
+  QRect m_workingBoundingRect;
+  QRect m_contentRect;
+  Dpi m_dpi;
+  bool m_normalizeIllumination;
+  QPolygonF m_preCropArea;
+  QColor m_outsideColor;
+  uint64_t m_imageFingerprint;
+};
+}  // namespace output
+#endif  // ifndef SCANTAILOR_OUTPUT_TRACEDCURVESKEY_H_
@@ -113,7 +113,7 @@ Task::UiUpdater::UiUpdater(std::shared_ptr<Filter> filter,
       m_settings(std::move(settings)),
       m_pageId(pageId),
       m_image(image),
-      m_downscaledImage(ImageView::createDownscaledImage(image)),
+      m_downscaledImage(ImageView::createDownscaledImage(image, pageId.imageId())),
       m_contentMask(contentMask),
       m_xform(xform),
       m_adaptedContentRect(adaptedContentRect),
@@ -188,7 +188,7 @@ Task::UiUpdater::UiUpdater(std::shared_ptr<Filter> filter,
       m_pages(std::move(pages)),
       m_dbg(std::move(dbgImg)),
       m_image(image),
-      m_downscaledImage(ImageView::createDownscaledImage(image)),
+      m_downscaledImage(ImageView::createDownscaledImage(image, pageInfo.imageId())),
       m_pageInfo(pageInfo),
       m_xform(xform),
       m_uiData(uiData),
@@ -165,7 +165,7 @@ Task::UiUpdater::UiUpdater(std::shared_ptr<Filter> filter,
       m_pageId(pageId),
       m_dbg(std::move(dbg)),
       m_image(image),
-      m_downscaledImage(ImageView::createDownscaledImage(image)),
+      m_downscaledImage(ImageView::createDownscaledImage(image, pageId.imageId())),
       m_contentMask(contentMask),
       m_xform(xform),
       m_uiData(uiData),
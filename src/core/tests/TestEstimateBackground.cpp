@@ -0,0 +1,98 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#include <BinaryImage.h>
+#include <EstimateBackground.h>
+#include <GrayImage.h>
+#include <NullTaskStatus.h>
+#include <PolynomialSurface.h>
+
+#include <QSize>
+#include <algorithm>
+#include <boost/test/unit_test.hpp>
+#include <cstdlib>
+
+namespace Tests {
+using namespace imageproc;
+
+BOOST_AUTO_TEST_SUITE(EstimateBackgroundTestSuite)
+
+namespace {
+const QSize BACKGROUND_SIZE(160, 120);
+
+/**
+ * A smooth paper background.  Both x and y are in [0, 1].
+ */
+double backgroundAt(const double x, const double y) {
+  return 190.0 + 30.0 * x - 20.0 * x * x + 25.0 * y * y + 10.0 * x * y;
+}
+
+GrayImage renderBackground() {
+  GrayImage image(BACKGROUND_SIZE);
+  for (int y = 0; y < image.height(); ++y) {
+    for (int x = 0; x < image.width(); ++x) {
+      const double value = backgroundAt(double(x) / (image.width() - 1), double(y) / (image.height() - 1));
+      image.data()[y * image.stride() + x] = static_cast<uint8_t>(value + 0.5);
+    }
+  }
+  return image;
+}
+
+int maxDifference(const GrayImage& image, const GrayImage& control) {
+  int maxDiff = 0;
+  for (int y = 0; y < image.height(); ++y) {
+    for (int x = 0; x < image.width(); ++x) {
+      const int diff = image.data()[y * image.stride() + x] - control.data()[y * control.stride() + x];
+      maxDiff = std::max(maxDiff, std::abs(diff));
+    }
+  }
+  return maxDiff;
+}
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(test_refit_recovers_background_under_text) {
+  // Dark blobs of text the mask failed to cover, about 6% of it.
+  const GrayImage truth(renderBackground());
+  GrayImage background(truth);
+  for (int y = 0; y < background.height(); ++y) {
+    for (int x = 0; x < background.width(); ++x) {
+      if ((x % 16 >= 6) && (x % 16 < 10) && (y % 16 >= 6) && (y % 16 < 10)) {
+        background.data()[y * background.stride() + x] = 30;
+      }
+    }
+  }
+  BinaryImage mask(BACKGROUND_SIZE, BLACK);
+
+  // The text pulls the plain fit down.
+  const PolynomialSurface plainFit(8, 5, background, mask);
+  BOOST_REQUIRE_GT(maxDifference(plainFit.render(BACKGROUND_SIZE), truth), 10);
+
+  const PolynomialSurface refinedFit(refineBackgroundFit(background, mask, NullTaskStatus()));
+  BOOST_CHECK_LE(maxDifference(refinedFit.render(BACKGROUND_SIZE), truth), 2);
+  BOOST_CHECK(mask.getPixel(8, 8) == WHITE);
+  BOOST_CHECK(mask.getPixel(0, 0) == BLACK);
+}
+
+BOOST_AUTO_TEST_CASE(test_refit_keeps_background_the_surface_cant_follow) {
+  // Shadows along both edges of the page are real background, though the surface can't follow them.
+  // More than 10% of the mask fits badly then, so it's left as it is.
+  GrayImage background(renderBackground());
+  for (int y = 0; y < background.height(); ++y) {
+    for (int x = 0; x < background.width(); ++x) {
+      if ((x < 16) || (x >= background.width() - 16)) {
+        background.data()[y * background.stride() + x] = 60;
+      }
+    }
+  }
+  BinaryImage mask(BACKGROUND_SIZE, BLACK);
+
+  const PolynomialSurface plainFit(8, 5, background, mask);
+  BOOST_REQUIRE_GT(maxDifference(plainFit.render(BACKGROUND_SIZE), background), 40);
+
+  const PolynomialSurface refinedFit(refineBackgroundFit(background, mask, NullTaskStatus()));
+  BOOST_CHECK_EQUAL(mask.countBlackPixels(), BACKGROUND_SIZE.width() * BACKGROUND_SIZE.height());
+  BOOST_CHECK_EQUAL(maxDifference(refinedFit.render(BACKGROUND_SIZE), plainFit.render(BACKGROUND_SIZE)), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+}  // namespace Tests
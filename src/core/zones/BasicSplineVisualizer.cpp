@@ -14,7 +14,7 @@ BasicSplineVisualizer::BasicSplineVisualizer()
 }
 
 void BasicSplineVisualizer::drawSplines(QPainter& painter, const QTransform& toScreen, const EditableZoneSet& zones) {
-  for (const EditableZoneSet::Zone& zone : zones) {
+  for (const EditableZoneSet::Zone& zone : visibleZones(painter, toScreen, zones)) {
     drawSpline(painter, toScreen, zone.spline());
   }
 }
@@ -39,3 +39,17 @@ void BasicSplineVisualizer::prepareForSpline(QPainter& painter, const EditableSp
   painter.setPen(m_pen);
   painter.setBrush(Qt::NoBrush);
 }
+
+std::vector<EditableZoneSet::Zone> BasicSplineVisualizer::visibleZones(const QPainter& painter,
+                                                                       const QTransform& toScreen,
+                                                                       const EditableZoneSet& zones) {
+  bool invertible = false;
+  const QTransform fromScreen(toScreen.inverted(&invertible));
+  if (!invertible) {
+    return std::vector<EditableZoneSet::Zone>(zones.begin(), zones.end());
+  }
+
+  // Leave some room for the pen width and the vertex markers.
+  const QRectF screenRect(QRectF(painter.viewport()).adjusted(-4, -4, 4, 4));
+  return zones.zonesIntersecting(fromScreen.mapRect(screenRect));
+}
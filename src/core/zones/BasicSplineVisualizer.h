@@ -6,10 +6,11 @@
 
 #include <QColor>
 #include <QPen>
+#include <vector>
 
 #include "EditableSpline.h"
+#include "EditableZoneSet.h"
 
-class EditableZoneSet;
 class QPainter;
 class QTransform;
 
@@ -31,6 +32,15 @@ class BasicSplineVisualizer {
 
   virtual void prepareForSpline(QPainter& painter, const EditableSpline::Ptr& spline);
 
+  /**
+   * \brief Returns the zones that may be visible on the painter's viewport, in paint order.
+   *
+   * \param toScreen The transformation from zone coordinates to the painter's device coordinates.
+   */
+  static std::vector<EditableZoneSet::Zone> visibleZones(const QPainter& painter,
+                                                          const QTransform& toScreen,
+                                                          const EditableZoneSet& zones);
+
  protected:
   QRgb m_solidColor;
   QRgb m_highlightBrightColor;
@@ -48,6 +48,13 @@ class EditableSpline {
 
   QPolygonF toPolygon() const;
 
+  /**
+   * \brief Changes each time a vertex is added, removed or moved.
+   *
+   * Allows caching data derived from the spline's geometry.
+   */
+  unsigned revision() const { return m_sentinel->revision(); }
+
  private:
   std::shared_ptr<SentinelSplineVertex> m_sentinel = std::make_shared<SentinelSplineVertex>();
 };
@@ -3,6 +3,8 @@
 
 #include "EditableZoneSet.h"
 
+#include <QRectF>
+
 EditableZoneSet::EditableZoneSet() : m_zoneItems(), m_zoneItemsInOrder(m_zoneItems.get<ZoneItemOrderedTag>()) {}
 
 void EditableZoneSet::setDefaultProperties(const PropertySet& props) {
@@ -10,23 +12,37 @@ void EditableZoneSet::setDefaultProperties(const PropertySet& props) {
 }
 
 void EditableZoneSet::addZone(const EditableSpline::Ptr& spline) {
-  auto newProps = std::make_shared<PropertySet>(m_defaultProps);
-  m_zoneItems.insert(ZoneItem(spline, newProps));
+  addZone(spline, m_defaultProps);
 }
 
 void EditableZoneSet::addZone(const EditableSpline::Ptr& spline, const PropertySet& props) {
   auto newProps = std::make_shared<PropertySet>(props);
-  m_zoneItems.insert(ZoneItem(spline, newProps));
+  if (m_zoneItems.insert(ZoneItem(spline, newProps)).second) {
+    m_index.insert(spline);
+  }
 }
 
 void EditableZoneSet::removeZone(const EditableSpline::Ptr& spline) {
-  m_zoneItems.erase(spline);
+  if (m_zoneItems.erase(spline) != 0) {
+    m_index.remove(spline);
+  }
 }
 
 void EditableZoneSet::commit() {
   emit committed();
 }
 
+std::vector<EditableZoneSet::Zone> EditableZoneSet::zonesIntersecting(const QRectF& rect) const {
+  std::vector<Zone> zones;
+  for (const EditableSpline::Ptr& spline : m_index.query(rect)) {
+    auto it(m_zoneItems.find(spline));
+    if (it != m_zoneItems.end()) {
+      zones.push_back(Zone(m_zoneItems.project<ZoneItemOrderedTag>(it)));
+    }
+  }
+  return zones;
+}
+
 std::shared_ptr<PropertySet> EditableZoneSet::propertiesFor(const EditableSpline::Ptr& spline) {
   auto it(m_zoneItems.find(spline));
   if (it != m_zoneItems.end()) {
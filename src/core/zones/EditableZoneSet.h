@@ -13,9 +13,13 @@
 #include <boost/multi_index/sequenced_index.hpp>
 #include <boost/multi_index_container.hpp>
 #include <memory>
+#include <vector>
 
 #include "EditableSpline.h"
 #include "PropertySet.h"
+#include "ZoneSpatialIndex.h"
+
+class QRectF;
 
 class EditableZoneSet : public QObject {
   Q_OBJECT
@@ -37,6 +41,7 @@ class EditableZoneSet : public QObject {
   class const_iterator;
 
   class Zone {
+    friend class EditableZoneSet;
     friend class EditableZoneSet::const_iterator;
 
    public:
@@ -93,6 +98,15 @@ class EditableZoneSet : public QObject {
 
   void commit();
 
+  /**
+   * \brief Finds the zones that may intersect the given rectangle.
+   *
+   * Zones are selected by their bounding boxes, so this is suitable for culling
+   * rather than for exact hit-testing.  The zones are returned in the same order
+   * the iteration over the set would visit them.
+   */
+  std::vector<Zone> zonesIntersecting(const QRectF& rect) const;
+
   std::shared_ptr<PropertySet> propertiesFor(const EditableSpline::Ptr& spline);
 
   std::shared_ptr<const PropertySet> propertiesFor(const EditableSpline::Ptr& spline) const;
@@ -105,6 +119,7 @@ class EditableZoneSet : public QObject {
   ZoneItems m_zoneItems;
   ZoneItemsInOrder& m_zoneItemsInOrder;
   PropertySet m_defaultProps;
+  ZoneSpatialIndex m_index;
 };
 
 #endif  // ifndef SCANTAILOR_ZONES_EDITABLEZONESET_H_
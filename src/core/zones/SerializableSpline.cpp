@@ -67,3 +67,9 @@ SerializableSpline SerializableSpline::transformed(const boost::function<QPointF
   }
   return transformed;
 }
+
+SerializableSpline SerializableSpline::transformed(const boost::function<QPolygonF(const QPolygonF&)>& xform) const {
+  SerializableSpline transformed(*this);
+  transformed.m_points = xform(QPolygonF(m_points));
+  return transformed;
+}
@@ -29,6 +29,12 @@ class SerializableSpline {
 
   SerializableSpline transformed(const boost::function<QPointF(const QPointF&)>& xform) const;
 
+  /**
+   * Transforms all the points in a single call, which lets expensive
+   * mappings, like the dewarping ones, share work between the points.
+   */
+  SerializableSpline transformed(const boost::function<QPolygonF(const QPolygonF&)>& xform) const;
+
   QPolygonF toPolygon() const { return QPolygonF(m_points); }
 
  private:
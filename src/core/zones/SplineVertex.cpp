@@ -9,11 +9,17 @@
 
 /*============================= SplineVertex ============================*/
 
-SplineVertex::SplineVertex() : m_prev(nullptr), m_next(nullptr) {}
+SplineVertex::SplineVertex() : m_prev(nullptr), m_next(nullptr), m_sentinel(nullptr) {}
 
-SplineVertex::SplineVertex(SplineVertex* prev, SplineVertex* next) : m_prev(prev), m_next(next->shared_from_this()) {}
+SplineVertex::SplineVertex(SplineVertex* prev, SplineVertex* next)
+    : m_prev(prev), m_next(next->shared_from_this()), m_sentinel(prev->m_sentinel) {
+  markModified();
+}
 
 void SplineVertex::remove() {
+  markModified();
+  m_sentinel = nullptr;
+
   // Be very careful here - don't let this object
   // be destroyed before we've finished working with it.
   if (m_next)
@@ -60,6 +66,12 @@ SplineVertex::Ptr SplineVertex::insertAfter(const QPointF& pt) {
   return newVertex;
 }
 
+void SplineVertex::markModified() {
+  if (m_sentinel) {
+    m_sentinel->incrementRevision();
+  }
+}
+
 void SplineVertex::unlinkWithPrevious() {
   m_prev->m_next.reset();
   m_prev = nullptr;
@@ -67,7 +79,9 @@ void SplineVertex::unlinkWithPrevious() {
 
 /*========================= SentinelSplineVertex =======================*/
 
-SentinelSplineVertex::SentinelSplineVertex() : m_bridged(false) {}
+SentinelSplineVertex::SentinelSplineVertex() : m_bridged(false), m_revision(0) {
+  m_sentinel = this;
+}
 
 SentinelSplineVertex::~SentinelSplineVertex() {
   // Just releasing m_next is not enough, because in case some external
@@ -107,6 +121,14 @@ void SentinelSplineVertex::remove() {
   throw std::logic_error("Illegal call to SentinelSplineVertex::remove()");
 }
 
+void SentinelSplineVertex::setBridged(const bool bridged) {
+  if (bridged != m_bridged) {
+    m_bridged = bridged;
+    // Bridging adds or removes the segment between the last and the first vertex.
+    ++m_revision;
+  }
+}
+
 SplineVertex::Ptr SentinelSplineVertex::firstVertex() const {
   if (m_next.get() == this) {
     return nullptr;
@@ -153,4 +175,5 @@ const QPointF& RealSplineVertex::point() const {
 
 void RealSplineVertex::setPoint(const QPointF& pt) {
   m_point = pt;
+  markModified();
 }
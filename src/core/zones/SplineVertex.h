@@ -9,6 +9,8 @@
 
 #include "NonCopyable.h"
 
+class SentinelSplineVertex;
+
 class SplineVertex : public std::enable_shared_from_this<SplineVertex> {
  public:
   enum Loop { LOOP, NO_LOOP, LOOP_IF_BRIDGED };
@@ -54,6 +56,11 @@ class SplineVertex : public std::enable_shared_from_this<SplineVertex> {
   SplineVertex::Ptr insertAfter(const QPointF& pt);
 
  protected:
+  /**
+   * Lets the spline this vertex belongs to know its geometry has changed.
+   */
+  void markModified();
+
   /**
    * Usually we have circular dependency of m_next pointers here
    * so we unlink a vertex from the previous one to have
@@ -67,6 +74,12 @@ class SplineVertex : public std::enable_shared_from_this<SplineVertex> {
    */
   SplineVertex* m_prev;
   SplineVertex::Ptr m_next;
+
+  /**
+   * The sentinel of the spline this vertex belongs to,
+   * or null if this vertex was removed from its spline.
+   */
+  SentinelSplineVertex* m_sentinel;
 };
 
 
@@ -107,10 +120,19 @@ class SentinelSplineVertex : public SplineVertex {
 
   bool bridged() const { return m_bridged; }
 
-  void setBridged(bool bridged) { m_bridged = bridged; }
+  void setBridged(bool bridged);
+
+  /**
+   * Incremented each time a vertex of this spline is added,
+   * removed or moved.
+   */
+  unsigned revision() const { return m_revision; }
+
+  void incrementRevision() { ++m_revision; }
 
  private:
   bool m_bridged;
+  unsigned m_revision;
 };
 
 
@@ -8,6 +8,7 @@
 #include <QMessageBox>
 #include <QPainter>
 #include <QPainterPath>
+#include <QRectF>
 #include <boost/bind/bind.hpp>
 
 #include "ImageViewBase.h"
@@ -50,7 +51,7 @@ std::vector<ZoneContextMenuInteraction::Zone> ZoneContextMenuInteraction::zonesU
 
   // Find zones containing the mouse position.
   std::vector<Zone> selectableZones;
-  for (const EditableZoneSet::Zone& zone : context.zones()) {
+  for (const EditableZoneSet::Zone& zone : context.zones().zonesIntersecting(QRectF(imageMousePos, QSizeF(0, 0)))) {
     QPainterPath path;
     path.setFillRule(Qt::WindingFill);
     path.addPolygon(zone.spline()->toPolygon());
@@ -44,7 +44,7 @@ void ZoneDefaultInteraction::onPaint(QPainter& painter, const InteractionState&
 
   const QTransform toScreen(m_context.imageView().imageToWidget());
 
-  for (const EditableZoneSet::Zone& zone : m_context.zones()) {
+  for (const EditableZoneSet::Zone& zone : BasicSplineVisualizer::visibleZones(painter, toScreen, m_context.zones())) {
     const EditableSpline::Ptr& spline = zone.spline();
     m_visualizer.prepareForSpline(painter, spline);
     QPolygonF points;
@@ -112,6 +112,42 @@ void ZoneDefaultInteraction::onPaint(QPainter& painter, const InteractionState&
 void ZoneDefaultInteraction::onProximityUpdate(const QPointF& mousePos, InteractionState& interaction) {
   m_screenMousePos = mousePos;
 
+  Proximity bestVertexProximity;
+  Proximity bestSegmentProximity;
+
+  // Only the zones around the mouse are able to get a proximity within the threshold.
+  const double threshold = interaction.proximityThreshold().dist();
+  findNearestElements(m_context.zones().zonesIntersecting(imageRectAround(mousePos, threshold)), mousePos,
+                      bestVertexProximity, bestSegmentProximity);
+
+  if (m_splineUnderMouse) {
+    // The zone area proximity is the distance to the nearest vertex or segment
+    // of any zone, so consider all the zones that may be that close.
+    const double dist = std::min(bestVertexProximity, bestSegmentProximity).dist();
+    if (dist > threshold) {
+      findNearestElements(m_context.zones().zonesIntersecting(imageRectAround(mousePos, dist)), mousePos,
+                          bestVertexProximity, bestSegmentProximity);
+    }
+  }
+
+  interaction.updateProximity(m_vertexProximity, bestVertexProximity, 2);
+  interaction.updateProximity(m_segmentProximity, bestSegmentProximity, 1);
+
+  if (m_splineUnderMouse) {
+    const Proximity zoneAreaProximity(std::min(bestVertexProximity, bestSegmentProximity));
+    interaction.updateProximity(m_zoneAreaProximity, zoneAreaProximity, -1, zoneAreaProximity);
+    if (m_activeKeyboardModifiers == Qt::ShiftModifier) {
+      interaction.updateProximity(m_zoneAreaDragProximity, Proximity::fromSqDist(0), 0);
+    } else if (m_activeKeyboardModifiers == (Qt::ShiftModifier | Qt::ControlModifier)) {
+      interaction.updateProximity(m_zoneAreaDragCopyProximity, Proximity::fromSqDist(0), 0);
+    }
+  }
+}  // ZoneDefaultInteraction::onProximityUpdate
+
+void ZoneDefaultInteraction::findNearestElements(const std::vector<EditableZoneSet::Zone>& zones,
+                                                 const QPointF& mousePos,
+                                                 Proximity& bestVertexProximity,
+                                                 Proximity& bestSegmentProximity) {
   const QTransform toScreen(m_context.imageView().imageToWidget());
   const QTransform fromScreen(m_context.imageView().widgetToImage());
   const QPointF imageMousePos(fromScreen.map(mousePos));
@@ -122,10 +158,10 @@ void ZoneDefaultInteraction::onProximityUpdate(const QPointF& mousePos, Interact
   m_nearestSegmentSpline.reset();
   m_splineUnderMouse.reset();
 
-  Proximity bestVertexProximity;
-  Proximity bestSegmentProximity;
+  bestVertexProximity = Proximity();
+  bestSegmentProximity = Proximity();
 
-  for (const EditableZoneSet::Zone& zone : m_context.zones()) {
+  for (const EditableZoneSet::Zone& zone : zones) {
     const EditableSpline::Ptr& spline = zone.spline();
 
     if (spline->toPolygon().containsPoint(imageMousePos, Qt::WindingFill)) {
@@ -155,20 +191,13 @@ void ZoneDefaultInteraction::onProximityUpdate(const QPointF& mousePos, Interact
       }
     }
   }
+}  // ZoneDefaultInteraction::findNearestElements
 
-  interaction.updateProximity(m_vertexProximity, bestVertexProximity, 2);
-  interaction.updateProximity(m_segmentProximity, bestSegmentProximity, 1);
-
-  if (m_splineUnderMouse) {
-    const Proximity zoneAreaProximity(std::min(bestVertexProximity, bestSegmentProximity));
-    interaction.updateProximity(m_zoneAreaProximity, zoneAreaProximity, -1, zoneAreaProximity);
-    if (m_activeKeyboardModifiers == Qt::ShiftModifier) {
-      interaction.updateProximity(m_zoneAreaDragProximity, Proximity::fromSqDist(0), 0);
-    } else if (m_activeKeyboardModifiers == (Qt::ShiftModifier | Qt::ControlModifier)) {
-      interaction.updateProximity(m_zoneAreaDragCopyProximity, Proximity::fromSqDist(0), 0);
-    }
-  }
-}  // ZoneDefaultInteraction::onProximityUpdate
+QRectF ZoneDefaultInteraction::imageRectAround(const QPointF& screenPos, const double screenRadius) const {
+  QRectF screenRect(0, 0, 2 * screenRadius, 2 * screenRadius);
+  screenRect.moveCenter(screenPos);
+  return m_context.imageView().widgetToImage().mapRect(screenRect);
+}
 
 void ZoneDefaultInteraction::onMousePressEvent(QMouseEvent* event, InteractionState& interaction) {
   if (interaction.captured()) {
@@ -6,13 +6,17 @@
 
 #include <QCoreApplication>
 #include <QPointF>
+#include <QRectF>
+#include <vector>
 
 #include "BasicSplineVisualizer.h"
 #include "DragHandler.h"
 #include "DragWatcher.h"
 #include "EditableSpline.h"
+#include "EditableZoneSet.h"
 #include "InteractionHandler.h"
 #include "InteractionState.h"
+#include "Proximity.h"
 #include "SplineSegment.h"
 #include "SplineVertex.h"
 
@@ -44,6 +48,21 @@ class ZoneDefaultInteraction : public InteractionHandler {
   void onContextMenuEvent(QContextMenuEvent* event, InteractionState& interaction) override;
 
  private:
+  /**
+   * Finds the vertex and the segment nearest to the mouse among \p zones,
+   * as well as the topmost of them containing the mouse.
+   */
+  void findNearestElements(const std::vector<EditableZoneSet::Zone>& zones,
+                           const QPointF& mousePos,
+                           Proximity& bestVertexProximity,
+                           Proximity& bestSegmentProximity);
+
+  /**
+   * \return The bounding rectangle, in image coordinates, of the screen area
+   *         within \p screenRadius pixels from \p screenPos.
+   */
+  QRectF imageRectAround(const QPointF& screenPos, double screenRadius) const;
+
   void removeZoneUnderMouse();
 
   void removeVertexUnderMouse();
@@ -29,7 +29,7 @@ void ZoneDragInteraction::onPaint(QPainter& painter, const InteractionState& int
 
   const QTransform toScreen(m_context.imageView().imageToWidget());
 
-  for (const EditableZoneSet::Zone& zone : m_context.zones()) {
+  for (const EditableZoneSet::Zone& zone : BasicSplineVisualizer::visibleZones(painter, toScreen, m_context.zones())) {
     const EditableSpline::Ptr& spline = zone.spline();
 
     if (spline != m_spline) {
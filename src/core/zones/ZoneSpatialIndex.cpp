@@ -0,0 +1,146 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#include "ZoneSpatialIndex.h"
+
+#include <algorithm>
+#include <boost/geometry.hpp>
+#include <boost/geometry/index/rtree.hpp>
+#include <cstdint>
+#include <iterator>
+#include <unordered_map>
+#include <utility>
+
+namespace bg = boost::geometry;
+namespace bgi = boost::geometry::index;
+
+class ZoneSpatialIndex::Impl {
+ public:
+  Impl() : m_nextSerial(0) {}
+
+  void insert(const EditableSpline::Ptr& spline);
+
+  void remove(const EditableSpline::Ptr& spline);
+
+  std::vector<EditableSpline::Ptr> query(const QRectF& rect);
+
+ private:
+  using Point = bg::model::point<double, 2, bg::cs::cartesian>;
+  using Box = bg::model::box<Point>;
+  using Value = std::pair<Box, const EditableSpline*>;
+
+  struct Entry {
+    EditableSpline::Ptr spline;
+    unsigned revision;
+    Box box;
+    /** Defines the order of insertion. */
+    uint64_t serial;
+  };
+
+  static Box boundingBox(const EditableSpline& spline);
+
+  /**
+   * Re-indexes the splines that have changed since they were indexed.
+   */
+  void refresh();
+
+  bgi::rtree<Value, bgi::quadratic<16>> m_tree;
+  std::unordered_map<const EditableSpline*, Entry> m_entries;
+  uint64_t m_nextSerial;
+};
+
+
+ZoneSpatialIndex::ZoneSpatialIndex() : m_impl(std::make_unique<Impl>()) {}
+
+ZoneSpatialIndex::~ZoneSpatialIndex() = default;
+
+void ZoneSpatialIndex::insert(const EditableSpline::Ptr& spline) {
+  m_impl->insert(spline);
+}
+
+void ZoneSpatialIndex::remove(const EditableSpline::Ptr& spline) {
+  m_impl->remove(spline);
+}
+
+std::vector<EditableSpline::Ptr> ZoneSpatialIndex::query(const QRectF& rect) const {
+  return m_impl->query(rect);
+}
+
+/*========================== ZoneSpatialIndex::Impl ==========================*/
+
+void ZoneSpatialIndex::Impl::insert(const EditableSpline::Ptr& spline) {
+  if (m_entries.find(spline.get()) != m_entries.end()) {
+    return;
+  }
+
+  const Entry entry{spline, spline->revision(), boundingBox(*spline), m_nextSerial++};
+  m_tree.insert(Value(entry.box, spline.get()));
+  m_entries.emplace(spline.get(), entry);
+}
+
+void ZoneSpatialIndex::Impl::remove(const EditableSpline::Ptr& spline) {
+  const auto it = m_entries.find(spline.get());
+  if (it == m_entries.end()) {
+    return;
+  }
+
+  m_tree.remove(Value(it->second.box, spline.get()));
+  m_entries.erase(it);
+}
+
+std::vector<EditableSpline::Ptr> ZoneSpatialIndex::Impl::query(const QRectF& rect) {
+  refresh();
+
+  const Box queryBox(Point(rect.left(), rect.top()), Point(rect.right(), rect.bottom()));
+  std::vector<Value> found;
+  m_tree.query(bgi::intersects(queryBox), std::back_inserter(found));
+
+  std::vector<const Entry*> entries;
+  entries.reserve(found.size());
+  for (const Value& value : found) {
+    entries.push_back(&m_entries.at(value.second));
+  }
+  std::sort(entries.begin(), entries.end(), [](const Entry* lhs, const Entry* rhs) { return lhs->serial < rhs->serial; });
+
+  std::vector<EditableSpline::Ptr> splines;
+  splines.reserve(entries.size());
+  for (const Entry* entry : entries) {
+    splines.push_back(entry->spline);
+  }
+  return splines;
+}
+
+void ZoneSpatialIndex::Impl::refresh() {
+  for (auto& keyAndEntry : m_entries) {
+    Entry& entry = keyAndEntry.second;
+    const unsigned revision = entry.spline->revision();
+    if (revision == entry.revision) {
+      continue;
+    }
+
+    m_tree.remove(Value(entry.box, keyAndEntry.first));
+    entry.box = boundingBox(*entry.spline);
+    entry.revision = revision;
+    m_tree.insert(Value(entry.box, keyAndEntry.first));
+  }
+}
+
+ZoneSpatialIndex::Impl::Box ZoneSpatialIndex::Impl::boundingBox(const EditableSpline& spline) {
+  SplineVertex::Ptr vertex(spline.firstVertex());
+  if (!vertex) {
+    return Box(Point(0, 0), Point(0, 0));
+  }
+
+  double left = vertex->point().x();
+  double right = left;
+  double top = vertex->point().y();
+  double bottom = top;
+  for (vertex = vertex->next(SplineVertex::NO_LOOP); vertex; vertex = vertex->next(SplineVertex::NO_LOOP)) {
+    const QPointF& pt = vertex->point();
+    left = std::min(left, pt.x());
+    right = std::max(right, pt.x());
+    top = std::min(top, pt.y());
+    bottom = std::max(bottom, pt.y());
+  }
+  return Box(Point(left, top), Point(right, bottom));
+}
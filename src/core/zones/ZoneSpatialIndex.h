@@ -0,0 +1,47 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#ifndef SCANTAILOR_ZONES_ZONESPATIALINDEX_H_
+#define SCANTAILOR_ZONES_ZONESPATIALINDEX_H_
+
+#include <QRectF>
+#include <memory>
+#include <vector>
+
+#include "EditableSpline.h"
+#include "NonCopyable.h"
+
+/**
+ * \brief An R-tree of spline bounding boxes.
+ *
+ * Vertices of a spline may be added, removed or moved without notifying
+ * the index.  Such splines are detected by their EditableSpline::revision()
+ * and re-indexed before the next query.
+ */
+class ZoneSpatialIndex {
+  DECLARE_NON_COPYABLE(ZoneSpatialIndex)
+
+ public:
+  ZoneSpatialIndex();
+
+  ~ZoneSpatialIndex();
+
+  void insert(const EditableSpline::Ptr& spline);
+
+  void remove(const EditableSpline::Ptr& spline);
+
+  /**
+   * \brief Finds splines whose bounding boxes intersect the given rectangle.
+   *
+   * \return Splines in the order they were inserted in.
+   */
+  std::vector<EditableSpline::Ptr> query(const QRectF& rect) const;
+
+ private:
+  class Impl;
+
+  std::unique_ptr<Impl> m_impl;
+};
+
+
+#endif  // ifndef SCANTAILOR_ZONES_ZONESPATIALINDEX_H_
@@ -28,7 +28,7 @@ void ZoneVertexDragInteraction::onPaint(QPainter& painter, const InteractionStat
 
   const QTransform toScreen(m_context.imageView().imageToWidget());
 
-  for (const EditableZoneSet::Zone& zone : m_context.zones()) {
+  for (const EditableZoneSet::Zone& zone : BasicSplineVisualizer::visibleZones(painter, toScreen, m_context.zones())) {
     const EditableSpline::Ptr& spline = zone.spline();
 
     if (spline != m_spline) {
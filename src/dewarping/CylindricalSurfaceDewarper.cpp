@@ -4,10 +4,11 @@
 #include "CylindricalSurfaceDewarper.h"
 
 #include <QDebug>
+#include <algorithm>
 #include <boost/foreach.hpp>
 
+#include "FixedSizeMatrixOps.h"
 #include "NumericTraits.h"
-#include "ToLineProjector.h"
 
 /*
    Naming conventions:
@@ -103,12 +104,8 @@ CylindricalSurfaceDewarper::Generatrix CylindricalSurfaceDewarper::mapGeneratrix
   return Generatrix(imgGeneratrix, H);
 }  // CylindricalSurfaceDewarper::mapGeneratrix
 
-QPointF CylindricalSurfaceDewarper::mapToDewarpedSpace(const QPointF& imgPt) const {
-  State state;
-
-  const double plnX = m_img2pln(imgPt)[0];
-  const double crvX = m_arcLengthMapper.xToArcLen(plnX, state.m_arcLengthHint);
-
+CylindricalSurfaceDewarper::ImgGeneratrix CylindricalSurfaceDewarper::mapImgGeneratrix(double plnX,
+                                                                                       State& state) const {
   const Vec2d plnTopPt(plnX, 0);
   const Vec2d plnBottomPt(plnX, 1);
   const Vec2d imgTopPt(m_pln2img(plnTopPt));
@@ -130,11 +127,48 @@ QPointF CylindricalSurfaceDewarper::mapToDewarpedSpace(const QPointF& imgPt) con
   } else {
     pairs[2] = std::make_pair(imgStraightLineProj, m_plnStraightLineY);
   }
-  const HomographicTransform<1, double> H(threePoint1DHomography(pairs));
+  return ImgGeneratrix(projector, threePoint1DHomography(pairs));
+}  // CylindricalSurfaceDewarper::mapImgGeneratrix
 
-  const double imgPtProj(projector.projectionScalar(imgPt));
-  const double crvY = H(imgPtProj);
+QPointF CylindricalSurfaceDewarper::mapToDewarpedSpace(const QPointF& imgPt) const {
+  State state;
+
+  const double plnX = m_img2pln(imgPt)[0];
+  const double crvX = m_arcLengthMapper.xToArcLen(plnX, state.m_arcLengthHint);
+  const ImgGeneratrix gtx(mapImgGeneratrix(plnX, state));
+
+  const double imgPtProj(gtx.projector.projectionScalar(imgPt));
+  const double crvY = gtx.img2crv(imgPtProj);
   return QPointF(crvX, crvY);
+}
+
+QPolygonF CylindricalSurfaceDewarper::mapToDewarpedSpace(const QPolygonF& imgPts) const {
+  const int numPoints = imgPts.size();
+  std::vector<double> plnXs(numPoints);
+  std::vector<int> order(numPoints);
+  for (int i = 0; i < numPoints; ++i) {
+    plnXs[i] = m_img2pln(imgPts[i])[0];
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), [&plnXs](int lhs, int rhs) { return plnXs[lhs] < plnXs[rhs]; });
+
+  QPolygonF crvPts(numPoints);
+  State state;
+  for (int runBegin = 0; runBegin < numPoints;) {
+    const double plnX = plnXs[order[runBegin]];
+    const double crvX = m_arcLengthMapper.xToArcLen(plnX, state.m_arcLengthHint);
+    const ImgGeneratrix gtx(mapImgGeneratrix(plnX, state));
+
+    int runEnd = runBegin + 1;
+    while (runEnd < numPoints && plnXs[order[runEnd]] == plnX) {
+      ++runEnd;
+    }
+    for (; runBegin < runEnd; ++runBegin) {
+      const int idx = order[runBegin];
+      crvPts[idx] = QPointF(crvX, gtx.img2crv(gtx.projector.projectionScalar(imgPts[idx])));
+    }
+  }
+  return crvPts;
 }  // CylindricalSurfaceDewarper::mapToDewarpedSpace
 
 QPointF CylindricalSurfaceDewarper::mapToWarpedSpace(const QPointF& crvPt) const {
@@ -143,6 +177,32 @@ QPointF CylindricalSurfaceDewarper::mapToWarpedSpace(const QPointF& crvPt) const
   return gtx.imgLine.pointAt(gtx.pln2img(crvPt.y()));
 }
 
+QPolygonF CylindricalSurfaceDewarper::mapToWarpedSpace(const QPolygonF& crvPts) const {
+  const int numPoints = crvPts.size();
+  std::vector<int> order(numPoints);
+  for (int i = 0; i < numPoints; ++i) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), [&crvPts](int lhs, int rhs) { return crvPts[lhs].x() < crvPts[rhs].x(); });
+
+  QPolygonF imgPts(numPoints);
+  State state;
+  for (int runBegin = 0; runBegin < numPoints;) {
+    const double crvX = crvPts[order[runBegin]].x();
+    const Generatrix gtx(mapGeneratrix(crvX, state));
+
+    int runEnd = runBegin + 1;
+    while (runEnd < numPoints && crvPts[order[runEnd]].x() == crvX) {
+      ++runEnd;
+    }
+    for (; runBegin < runEnd; ++runBegin) {
+      const int idx = order[runBegin];
+      imgPts[idx] = gtx.imgLine.pointAt(gtx.pln2img(crvPts[idx].y()));
+    }
+  }
+  return imgPts;
+}  // CylindricalSurfaceDewarper::mapToWarpedSpace
+
 HomographicTransform<2, double> CylindricalSurfaceDewarper::calcPlnToImgHomography(
     const std::vector<QPointF>& imgDirectrix1,
     const std::vector<QPointF>& imgDirectrix2) {
@@ -237,8 +297,9 @@ HomographicTransform<2, double> CylindricalSurfaceDewarper::fourPoint2DHomograph
 
 HomographicTransform<1, double> CylindricalSurfaceDewarper::threePoint1DHomography(
     const boost::array<std::pair<double, double>, 3>& pairs) {
-  VecNT<9, double> A;
-  VecNT<3, double> B;
+  // This one is computed for every generatrix, so it's solved in closed form.
+  Mat33d A;
+  Vec3d B;
   double* pa = A.data();
   double* pb = B.data();
 
@@ -255,13 +316,9 @@ HomographicTransform<1, double> CylindricalSurfaceDewarper::threePoint1DHomograp
     ++pb;
   }
 
-  Vec4d H;
-  H[3] = 1.0;
-
-  MatrixCalc<double> mc;
-  mc(A, 3, 3).solve(mc(B, 3, 1)).write(H);
-  mc(H, 2, 2).trans().write(H);
-  return HomographicTransform<1, double>(H);
+  const Vec3d x(fixedsize::solve(A, B));
+  // The solution is the first three elements of a row-major 2x2 matrix, the last one being 1.
+  return HomographicTransform<1, double>(Vec4d(x[0], x[2], x[1], 1.0));
 }
 
 void CylindricalSurfaceDewarper::initArcLengthMapper(const std::vector<QPointF>& imgDirectrix1,
@@ -6,6 +6,7 @@
 
 #include <QLineF>
 #include <QPointF>
+#include <QPolygonF>
 #include <boost/array.hpp>
 #include <utility>
 #include <vector>
@@ -13,6 +14,7 @@
 #include "ArcLengthMapper.h"
 #include "HomographicTransform.h"
 #include "PolylineIntersector.h"
+#include "ToLineProjector.h"
 
 namespace dewarping {
 class CylindricalSurfaceDewarper {
@@ -60,6 +62,15 @@ class CylindricalSurfaceDewarper {
    */
   QPointF mapToDewarpedSpace(const QPointF& imgPt) const;
 
+  /**
+   * \brief Same as mapToDewarpedSpace(const QPointF&), but for many points.
+   *
+   * The points are processed in the order of their generatrixes, so the
+   * generatrix search state is shared by neighbouring points, and points
+   * lying on the same generatrix share a single generatrix computation.
+   */
+  QPolygonF mapToDewarpedSpace(const QPolygonF& imgPts) const;
+
   /**
    * Transforms a point from dewarped normalized coordinates
    * to warped image coordinates.  See comments in the beginning
@@ -68,9 +79,30 @@ class CylindricalSurfaceDewarper {
    */
   QPointF mapToWarpedSpace(const QPointF& crvPt) const;
 
+  /**
+   * \brief Same as mapToWarpedSpace(const QPointF&), but for many points.
+   *
+   * \see mapToDewarpedSpace(const QPolygonF&)
+   */
+  QPolygonF mapToWarpedSpace(const QPolygonF& crvPts) const;
+
  private:
   class CoupledPolylinesIterator;
 
+  /**
+   * Maps the points of a generatrix from warped image coordinates
+   * to dewarped normalized Y coordinates.
+   */
+  struct ImgGeneratrix {
+    ToLineProjector projector;
+    HomographicTransform<1, double> img2crv;
+
+    ImgGeneratrix(const ToLineProjector& projector, const HomographicTransform<1, double>& H)
+        : projector(projector), img2crv(H) {}
+  };
+
+  ImgGeneratrix mapImgGeneratrix(double plnX, State& state) const;
+
   static HomographicTransform<2, double> calcPlnToImgHomography(const std::vector<QPointF>& imgDirectrix1,
                                                                 const std::vector<QPointF>& imgDirectrix2);
 
@@ -40,6 +40,15 @@ QPointF DewarpingPointMapper::mapToDewarpedSpace(const QPointF& warpedPt) const
   return m_postTransform.map(QPointF(dewarpedX, dewarpedY));
 }
 
+QPolygonF DewarpingPointMapper::mapToDewarpedSpace(const QPolygonF& warpedPts) const {
+  QPolygonF dewarpedPts(m_dewarper.mapToDewarpedSpace(warpedPts));
+  for (QPointF& pt : dewarpedPts) {
+    pt.rx() = pt.x() * m_modelXScaleFromNormalized + m_modelDomainLeft;
+    pt.ry() = pt.y() * m_modelYScaleFromNormalized + m_modelDomainTop;
+  }
+  return m_postTransform.map(dewarpedPts);
+}
+
 QPointF DewarpingPointMapper::mapToWarpedSpace(const QPointF& dewarpedPt) const {
   QPointF dewarpedPtM = m_postTransform.inverted().map(dewarpedPt);
 
@@ -47,4 +56,13 @@ QPointF DewarpingPointMapper::mapToWarpedSpace(const QPointF& dewarpedPt) const
   const double crvY = (dewarpedPtM.y() - m_modelDomainTop) * m_modelYScaleToNormalized;
   return m_dewarper.mapToWarpedSpace(QPointF(crvX, crvY));
 }
-}  // namespace dewarping
\ No newline at end of file
+
+QPolygonF DewarpingPointMapper::mapToWarpedSpace(const QPolygonF& dewarpedPts) const {
+  QPolygonF crvPts(m_postTransform.inverted().map(dewarpedPts));
+  for (QPointF& pt : crvPts) {
+    pt.rx() = (pt.x() - m_modelDomainLeft) * m_modelXScaleToNormalized;
+    pt.ry() = (pt.y() - m_modelDomainTop) * m_modelYScaleToNormalized;
+  }
+  return m_dewarper.mapToWarpedSpace(crvPts);
+}
+}  // namespace dewarping
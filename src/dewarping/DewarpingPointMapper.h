@@ -28,6 +28,12 @@ class DewarpingPointMapper {
    */
   QPointF mapToDewarpedSpace(const QPointF& warpedPt) const;
 
+  /**
+   * Same as mapToDewarpedSpace(const QPointF&), but maps many points
+   * at once, which is much faster than mapping them one by one.
+   */
+  QPolygonF mapToDewarpedSpace(const QPolygonF& warpedPts) const;
+
   /**
    * Similar to CylindricalSurfaceDewarper::mapToWarpedSpace(),
    * except it maps from dewarped image coordinates rather than
@@ -35,6 +41,12 @@ class DewarpingPointMapper {
    */
   QPointF mapToWarpedSpace(const QPointF& dewarpedPt) const;
 
+  /**
+   * Same as mapToWarpedSpace(const QPointF&), but maps many points
+   * at once, which is much faster than mapping them one by one.
+   */
+  QPolygonF mapToWarpedSpace(const QPolygonF& dewarpedPts) const;
+
  private:
   CylindricalSurfaceDewarper m_dewarper;
   double m_modelDomainLeft;
@@ -9,12 +9,15 @@
 #if QT_VERSION_MAJOR > 5 or QT_VERSION_MINOR > 9
 #include <QRandomGenerator>
 #endif
+#include <algorithm>
 #include <boost/foreach.hpp>
+#include <memory>
 
 #include "CylindricalSurfaceDewarper.h"
 #include "DebugImages.h"
 #include "DistortionModel.h"
 #include "LineBoundedByRect.h"
+#include "ParallelFor.h"
 #include "SidesOfLine.h"
 #include "ToLineProjector.h"
 #include "spfit/ConstraintSet.h"
@@ -27,6 +30,16 @@
 using namespace imageproc;
 
 namespace dewarping {
+namespace {
+/**
+ * A model built from a warm start is accepted if its error per curve
+ * doesn't exceed the error of the warm start model by more than that factor.
+ * Text lines of the same book are about as straight from page to page,
+ * so anything more than a small excess means the model doesn't fit.
+ */
+const double WARM_START_ERROR_TOLERANCE = 1.1;
+}  // namespace
+
 struct DistortionModelBuilder::TracedCurve {
   std::vector<QPointF> trimmedPolyline;   // Both are left to right.
   std::vector<QPointF> extendedPolyline;  //
@@ -39,6 +52,12 @@ struct DistortionModelBuilder::TracedCurve {
         extendedSpline(extendedSpline),
         order(ord) {}
 
+  /**
+   * A curve we haven't fitted a spline to.  Such curves can't be
+   * the top or bottom curve of a model, but can still assess one.
+   */
+  TracedCurve(const std::vector<QPointF>& trimmedPolyline, double ord) : trimmedPolyline(trimmedPolyline), order(ord) {}
+
   bool operator<(const TracedCurve& rhs) const { return order < rhs.order; }
 };
 
@@ -56,17 +75,31 @@ class DistortionModelBuilder::RansacAlgo {
  public:
   explicit RansacAlgo(const std::vector<TracedCurve>& allCurves) : m_allCurves(allCurves) {}
 
-  void buildAndAssessModel(const TracedCurve* topCurve, const TracedCurve* bottomCurve);
+  void addCandidate(const TracedCurve* topCurve, const TracedCurve* bottomCurve);
+
+  /**
+   * Assesses the candidates added so far, concurrently, and selects the best one.
+   * On equal errors, the candidate added first wins, just like if they were
+   * assessed one by one, so the outcome doesn't depend on the number of threads.
+   */
+  void assessCandidates();
 
   RansacModel& bestModel() { return m_bestModel; }
 
   const RansacModel& bestModel() const { return m_bestModel; }
 
  private:
+  /**
+   * Returns the total error of a model built from the given pair of curves,
+   * or NumericTraits<double>::max() if such a model can't be built.
+   */
+  double assessModel(const TracedCurve* topCurve, const TracedCurve* bottomCurve) const;
+
   double calcReferenceHeight(const CylindricalSurfaceDewarper& dewarper, const QPointF& loc);
 
   RansacModel m_bestModel;
   const std::vector<TracedCurve>& m_allCurves;
+  std::vector<std::pair<const TracedCurve*, const TracedCurve*>> m_candidates;
 };
 
 
@@ -120,21 +153,44 @@ void DistortionModelBuilder::transform(const QTransform& xform) {
   }
 }
 
-DistortionModel DistortionModelBuilder::tryBuildModel(DebugImages* dbg, const QImage* dbgBackground) const {
+void DistortionModelBuilder::setWarmStart(const WarmStart& warmStart) {
+  m_warmStart = warmStart;
+}
+
+DistortionModel DistortionModelBuilder::tryBuildModel(DebugImages* dbg,
+                                                      const QImage* dbgBackground,
+                                                      WarmStart* builtModel) const {
   auto numCurves = static_cast<int>(m_ltrPolylines.size());
 
   if ((numCurves < 2) || (m_bound1.p1() == m_bound1.p2()) || (m_bound2.p1() == m_bound2.p2())) {
     return DistortionModel();
   }
 
+  if (m_warmStart.model.isValid()) {
+    const DistortionModel model(tryBuildFromWarmStart(dbg, dbgBackground, builtModel));
+    if (model.isValid()) {
+      return model;
+    }
+    // Fall back to the full search.
+  }
+
+  // Fitting a spline to each polyline is independent from the others.
+  std::vector<std::unique_ptr<TracedCurve>> fittedCurves(numCurves);
+  parallelFor(0, numCurves, 1, [&](const int from, const int to) {
+    for (int i = from; i < to; ++i) {
+      try {
+        fittedCurves[i] = std::make_unique<TracedCurve>(polylineToCurve(m_ltrPolylines[i]));
+      } catch (const BadCurve&) {
+        // Just skip it.
+      }
+    }
+  });
+
   std::vector<TracedCurve> orderedCurves;
   orderedCurves.reserve(numCurves);
-
-  for (const std::vector<QPointF>& polyline : m_ltrPolylines) {
-    try {
-      orderedCurves.push_back(polylineToCurve(polyline));
-    } catch (const BadCurve&) {
-      // Just skip it.
+  for (const std::unique_ptr<TracedCurve>& curve : fittedCurves) {
+    if (curve) {
+      orderedCurves.push_back(std::move(*curve));
     }
   }
   numCurves = static_cast<int>(orderedCurves.size());
@@ -154,7 +210,7 @@ DistortionModel DistortionModelBuilder::tryBuildModel(DebugImages* dbg, const QI
   for (int i = 0; i < std::min<int>(3, numCurves); ++i) {
     for (int j = std::max<int>(0, numCurves - 3); j < numCurves; ++j) {
       if (i < j) {
-        ransac.buildAndAssessModel(&orderedCurves[i], &orderedCurves[j]);
+        ransac.addCandidate(&orderedCurves[i], &orderedCurves[j]);
       }
     }
   }
@@ -177,9 +233,10 @@ DistortionModel DistortionModelBuilder::tryBuildModel(DebugImages* dbg, const QI
       std::swap(i, j);
     }
     if (i < j) {
-      ransac.buildAndAssessModel(&orderedCurves[i], &orderedCurves[j]);
+      ransac.addCandidate(&orderedCurves[i], &orderedCurves[j]);
     }
   }
+  ransac.assessCandidates();
 
   if (dbg && dbgBackground) {
     dbg->add(visualizeTrimmedPolylines(*dbgBackground, orderedCurves), "trimmed_polylines");
@@ -190,10 +247,76 @@ DistortionModel DistortionModelBuilder::tryBuildModel(DebugImages* dbg, const QI
   if (ransac.bestModel().isValid()) {
     model.setTopCurve(Curve(ransac.bestModel().topCurve->extendedPolyline));
     model.setBottomCurve(Curve(ransac.bestModel().bottomCurve->extendedPolyline));
+    if (builtModel) {
+      builtModel->model = model;
+      builtModel->errorPerCurve = ransac.bestModel().totalError / numCurves;
+    }
   }
   return model;
 }  // DistortionModelBuilder::tryBuildModel
 
+DistortionModel DistortionModelBuilder::tryBuildFromWarmStart(DebugImages* dbg,
+                                                              const QImage* dbgBackground,
+                                                              WarmStart* builtModel) const {
+  // Trimming polylines is cheap, unlike fitting splines to them,
+  // so we only fit splines to the two curves we are going to try.
+  std::vector<TracedCurve> curves;
+  curves.reserve(m_ltrPolylines.size());
+  for (const std::vector<QPointF>& polyline : m_ltrPolylines) {
+    const double order = centroid(polyline).dot(m_downDirection);
+    curves.emplace_back(maybeTrimPolyline(polyline, frontBackBounds(polyline)), order);
+  }
+
+  const auto closestCurve = [&curves](const double order) {
+    int closest = 0;
+    for (int i = 1; i < static_cast<int>(curves.size()); ++i) {
+      if (std::fabs(curves[i].order - order) < std::fabs(curves[closest].order - order)) {
+        closest = i;
+      }
+    }
+    return closest;
+  };
+  const int topIdx = closestCurve(centroid(m_warmStart.model.topCurve().polyline()).dot(m_downDirection));
+  const int bottomIdx = closestCurve(centroid(m_warmStart.model.bottomCurve().polyline()).dot(m_downDirection));
+  if (!(curves[topIdx] < curves[bottomIdx])) {
+    return DistortionModel();
+  }
+
+  try {
+    curves[topIdx] = polylineToCurve(m_ltrPolylines[topIdx]);
+    curves[bottomIdx] = polylineToCurve(m_ltrPolylines[bottomIdx]);
+  } catch (const BadCurve&) {
+    return DistortionModel();
+  }
+
+  RansacAlgo ransac(curves);
+  ransac.addCandidate(&curves[topIdx], &curves[bottomIdx]);
+  ransac.assessCandidates();
+  if (!ransac.bestModel().isValid()) {
+    return DistortionModel();
+  }
+
+  const double errorPerCurve = ransac.bestModel().totalError / curves.size();
+  if (errorPerCurve > m_warmStart.errorPerCurve * WARM_START_ERROR_TOLERANCE) {
+    return DistortionModel();
+  }
+
+  if (dbg && dbgBackground) {
+    dbg->add(visualizeTrimmedPolylines(*dbgBackground, curves), "trimmed_polylines");
+    dbg->add(visualizeModel(*dbgBackground, curves, ransac.bestModel()), "distortion_model");
+  }
+
+  DistortionModel model;
+  model.setTopCurve(Curve(ransac.bestModel().topCurve->extendedPolyline));
+  model.setBottomCurve(Curve(ransac.bestModel().bottomCurve->extendedPolyline));
+  if (builtModel) {
+    builtModel->model = model;
+    // Never let the reference error grow, or it could creep up page after page.
+    builtModel->errorPerCurve = std::min(errorPerCurve, m_warmStart.errorPerCurve);
+  }
+  return model;
+}  // DistortionModelBuilder::tryBuildFromWarmStart
+
 DistortionModelBuilder::TracedCurve DistortionModelBuilder::polylineToCurve(
     const std::vector<QPointF>& polyline) const {
   const std::pair<QLineF, QLineF> bounds(frontBackBounds(polyline));
@@ -420,13 +543,39 @@ XSpline DistortionModelBuilder::fitExtendedSpline(const std::vector<QPointF>& po
 
 /*============================== RansacAlgo ============================*/
 
-void DistortionModelBuilder::RansacAlgo::buildAndAssessModel(const TracedCurve* topCurve,
-                                                             const TracedCurve* bottomCurve) try {
+void DistortionModelBuilder::RansacAlgo::addCandidate(const TracedCurve* topCurve, const TracedCurve* bottomCurve) {
+  const std::pair<const TracedCurve*, const TracedCurve*> candidate(topCurve, bottomCurve);
+  // Assessing the same pair again can't change the outcome.
+  if (std::find(m_candidates.begin(), m_candidates.end(), candidate) == m_candidates.end()) {
+    m_candidates.push_back(candidate);
+  }
+}
+
+void DistortionModelBuilder::RansacAlgo::assessCandidates() {
+  std::vector<double> errors(m_candidates.size());
+  parallelFor(0, static_cast<int>(m_candidates.size()), 1, [&](const int from, const int to) {
+    for (int i = from; i < to; ++i) {
+      errors[i] = assessModel(m_candidates[i].first, m_candidates[i].second);
+    }
+  });
+
+  for (size_t i = 0; i < m_candidates.size(); ++i) {
+    if (errors[i] < m_bestModel.totalError) {
+      m_bestModel.topCurve = m_candidates[i].first;
+      m_bestModel.bottomCurve = m_candidates[i].second;
+      m_bestModel.totalError = errors[i];
+    }
+  }
+  m_candidates.clear();
+}
+
+double DistortionModelBuilder::RansacAlgo::assessModel(const TracedCurve* topCurve,
+                                                       const TracedCurve* bottomCurve) const try {
   DistortionModel model;
   model.setTopCurve(Curve(topCurve->extendedPolyline));
   model.setBottomCurve(Curve(bottomCurve->extendedPolyline));
   if (!model.isValid()) {
-    return;
+    return NumericTraits<double>::max();
   }
 
   const double depthPerception = 2.0;  // Doesn't matter much here.
@@ -487,14 +636,11 @@ void DistortionModelBuilder::RansacAlgo::buildAndAssessModel(const TracedCurve*
     }
   }
 
-  if (error < m_bestModel.totalError) {
-    m_bestModel.topCurve = topCurve;
-    m_bestModel.bottomCurve = bottomCurve;
-    m_bestModel.totalError = error;
-  }
-}  // DistortionModelBuilder::RansacAlgo::buildAndAssessModel
+  return error;
+}  // DistortionModelBuilder::RansacAlgo::assessModel
 catch (const std::runtime_error&) {
   // Probably CylindricalSurfaceDewarper didn't like something.
+  return NumericTraits<double>::max();
 }
 
 #if 0
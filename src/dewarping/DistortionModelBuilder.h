@@ -11,6 +11,7 @@
 #include <utility>
 #include <vector>
 
+#include "DistortionModel.h"
 #include "VecNT.h"
 
 class QImage;
@@ -18,11 +19,22 @@ class DebugImages;
 class XSpline;
 
 namespace dewarping {
-class DistortionModel;
-
 class DistortionModelBuilder {
   // Member-wise copying is OK.
  public:
+  /**
+   * \brief A model built for a page, along with how well it fit the text lines of that page.
+   *
+   * Consecutive pages of a book tend to be curved alike, so a model built for one page
+   * makes a good starting point for the next one on the same side.
+   */
+  struct WarmStart {
+    DistortionModel model;
+
+    /** The average straightness error of the text lines of the page the model was built for. */
+    double errorPerCurve = 0;
+  };
+
   /**
    * \brief Constructor.
    *
@@ -62,13 +74,27 @@ class DistortionModelBuilder {
    */
   void transform(const QTransform& xform);
 
+  /**
+   * \brief Makes tryBuildModel() start from the model of a similar page.
+   *
+   * The text lines closest to the top and bottom curves of the warm start model
+   * are tried first.  If they make a model that fits this page about as well as
+   * the warm start model fit its own page, the full search is skipped, and so
+   * is fitting splines to the rest of the text lines.
+   */
+  void setWarmStart(const WarmStart& warmStart);
+
   /**
    * \brief Tries to build a distortion model based on information provided so far.
    *
+   * \param builtModel If provided and a valid model was built, receives that model
+   *        along with its error, to be used as a warm start for the next page.
    * \return A DistortionModel that may be invalid.
    * \see DistortionModel::isValid()
    */
-  DistortionModel tryBuildModel(DebugImages* dbg = nullptr, const QImage* dbgBackground = nullptr) const;
+  DistortionModel tryBuildModel(DebugImages* dbg = nullptr,
+                                const QImage* dbgBackground = nullptr,
+                                WarmStart* builtModel = nullptr) const;
 
  private:
   struct TracedCurve;
@@ -79,6 +105,8 @@ class DistortionModelBuilder {
 
   TracedCurve polylineToCurve(const std::vector<QPointF>& polyline) const;
 
+  DistortionModel tryBuildFromWarmStart(DebugImages* dbg, const QImage* dbgBackground, WarmStart* builtModel) const;
+
   static Vec2d centroid(const std::vector<QPointF>& polyline);
 
   std::pair<QLineF, QLineF> frontBackBounds(const std::vector<QPointF>& polyline) const;
@@ -111,6 +139,8 @@ class DistortionModelBuilder {
 
   /** These go left to right in terms of content. */
   std::deque<std::vector<QPointF>> m_ltrPolylines;
+
+  WarmStart m_warmStart;
 };
 }  // namespace dewarping
 #endif  // ifndef SCANTAILOR_DEWARPING_DISTORTIONMODELBUILDER_H_
@@ -3,6 +3,7 @@
 
 #include "RasterDewarper.h"
 
+#include <CancellationPoint.h>
 #include <ColorMixer.h>
 #include <GrayImage.h>
 
@@ -46,6 +47,7 @@ void dewarpGeneric(const PixelType* const srcData,
   const float modelYScale = 1.0 / (modelDomain.bottom() - modelDomain.top());
 
   for (int dstX = 0; dstX < dstWidth; ++dstX) {
+    CancellationPoint::poll();
     const double modelX = (dstX - modelDomainLeft) * modelXScale;
     const CylindricalSurfaceDewarper::Generatrix generatrix(distortionModel.mapGeneratrix(modelX, state));
 
@@ -92,6 +94,7 @@ void dewarpGeneric(const PixelType* const srcData,
   const float modelYScale = 1.0 / (modelDomain.bottom() - modelDomain.top());
 
   for (int dstX = 0; dstX < dstWidth; ++dstX) {
+    CancellationPoint::poll();
     const double modelX = (dstX - modelDomainLeft) * modelXScale;
     const CylindricalSurfaceDewarper::Generatrix generatrix(distortionModel.mapGeneratrix(modelX, state));
 
@@ -423,6 +426,7 @@ void dewarpGeneric(const PixelType* const srcData,
   std::vector<Vec2f> nextGridColumn(dstHeight + 1);
 
   for (int dstX = 0; dstX <= dstWidth; ++dstX) {
+    CancellationPoint::poll();
     const double modelX = (dstX - modelDomainLeft) * modelXScale;
     const CylindricalSurfaceDewarper::Generatrix generatrix(distortionModel.mapGeneratrix(modelX, state));
 
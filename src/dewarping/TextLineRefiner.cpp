@@ -4,7 +4,6 @@
 #include "TextLineRefiner.h"
 
 #include <GaussBlur.h>
-#include <Sobel.h>
 
 #include <QDebug>
 #include <QPainter>
@@ -15,10 +14,19 @@
 
 #include "DebugImages.h"
 #include "NumericTraits.h"
+#include "ParallelFor.h"
 
 using namespace imageproc;
 
 namespace dewarping {
+namespace {
+/**
+ * The number of image rows in a unit of work when computing gradients in parallel.
+ */
+const int GRADIENT_ROWS_PER_BAND = 64;
+}  // namespace
+
+
 class TextLineRefiner::SnakeLength {
  public:
   explicit SnakeLength(const Snake& snake);
@@ -103,9 +111,12 @@ void TextLineRefiner::refine(std::list<std::vector<QPointF>>& polylines, const i
   float vSigma = (4.0f / 200.f) * m_dpi.vertical();
   calcBlurredGradient(gradient, hSigma, vSigma);
 
-  for (Snake& snake : snakes) {
-    evolveSnake(snake, gradient, ON_CONVERGENCE_STOP);
-  }
+  // Snakes evolve independently of each other.
+  parallelFor(0, static_cast<int>(snakes.size()), 1, [&](const int from, const int to) {
+    for (int i = from; i < to; ++i) {
+      evolveSnake(snakes[i], gradient, ON_CONVERGENCE_STOP);
+    }
+  });
   if (dbg) {
     dbg->add(visualizeSnakes(snakes, &gradient), "evolved_snakes1");
   }
@@ -115,9 +126,11 @@ void TextLineRefiner::refine(std::list<std::vector<QPointF>>& polylines, const i
   vSigma *= 0.5f;
   calcBlurredGradient(gradient, hSigma, vSigma);
 
-  for (Snake& snake : snakes) {
-    evolveSnake(snake, gradient, ON_CONVERGENCE_GO_FINER);
-  }
+  parallelFor(0, static_cast<int>(snakes.size()), 1, [&](const int from, const int to) {
+    for (int i = from; i < to; ++i) {
+      evolveSnake(snakes[i], gradient, ON_CONVERGENCE_GO_FINER);
+    }
+  });
   if (dbg) {
     dbg->add(visualizeSnakes(snakes, &gradient), "evolved_snakes2");
   }
@@ -137,18 +150,61 @@ void TextLineRefiner::refine(std::list<std::vector<QPointF>>& polylines, const i
 void TextLineRefiner::calcBlurredGradient(Grid<float>& gradient, float hSigma, float vSigma) const {
   using namespace boost::lambda;
 
-  const float downscale = 1.0f / (255.0f * 8.0f);
-  Grid<float> vertGrad(m_image.width(), m_image.height(), /*padding=*/0);
-  horizontalSobel<float>(m_image.width(), m_image.height(), m_image.data(), m_image.stride(), _1 * downscale,
-                         gradient.data(), gradient.stride(), _1 = _2, _1, gradient.data(), gradient.stride(), _1 = _2);
-  verticalSobel<float>(m_image.width(), m_image.height(), m_image.data(), m_image.stride(), _1 * downscale,
-                       vertGrad.data(), vertGrad.stride(), _1 = _2, _1, gradient.data(), gradient.stride(),
-                       _1 = _1 * m_unitDownVec[0] + _2 * m_unitDownVec[1]);
-  Grid<float>().swap(vertGrad);  // Save memory.
+  parallelFor(0, m_image.height(), GRADIENT_ROWS_PER_BAND,
+              [&](const int from, const int to) { calcGradientRows(gradient, from, to); });
   gaussBlurGeneric(m_image.size(), hSigma, vSigma, gradient.data(), gradient.stride(), _1, gradient.data(),
                    gradient.stride(), _1 = _2);
 }
 
+void TextLineRefiner::calcGradientRows(Grid<float>& gradient, const int fromY, const int toY) const {
+  // This computes the same values as imageproc::horizontalSobel() and verticalSobel() would,
+  // projected onto m_unitDownVec, but one row at a time, so that separate bands of rows
+  // may be processed concurrently.  Pixels outside of the image are taken from the nearest edge.
+  const int width = m_image.width();
+  const int height = m_image.height();
+  const int imageStride = m_image.stride();
+  const uint8_t* const imageData = m_image.data();
+  const float downscale = 1.0f / (255.0f * 8.0f);
+
+  // left + mid + mid + right, for a given row.
+  const auto horizontalSmoothing = [&](const uint8_t* imageLine, float* out) {
+    for (int x = 0; x < width; ++x) {
+      const float left = imageLine[std::max(x - 1, 0)] * downscale;
+      const float mid = imageLine[x] * downscale;
+      const float right = imageLine[std::min(x + 1, width - 1)] * downscale;
+      out[x] = left + mid + mid + right;
+    }
+  };
+
+  std::vector<float> verticalSmoothed(width);
+  std::vector<float> smoothedAbove(width);
+  std::vector<float> smoothedBelow(width);
+
+  float* gradientLine = gradient.data() + gradient.stride() * fromY;
+  for (int y = fromY; y < toY; ++y) {
+    const uint8_t* const aboveLine = imageData + imageStride * std::max(y - 1, 0);
+    const uint8_t* const imageLine = imageData + imageStride * y;
+    const uint8_t* const belowLine = imageData + imageStride * std::min(y + 1, height - 1);
+
+    // top + mid + mid + bottom
+    for (int x = 0; x < width; ++x) {
+      const float top = aboveLine[x] * downscale;
+      const float mid = imageLine[x] * downscale;
+      const float bottom = belowLine[x] * downscale;
+      verticalSmoothed[x] = top + mid + mid + bottom;
+    }
+    horizontalSmoothing(aboveLine, smoothedAbove.data());
+    horizontalSmoothing(belowLine, smoothedBelow.data());
+
+    for (int x = 0; x < width; ++x) {
+      const float horGrad = verticalSmoothed[std::min(x + 1, width - 1)] - verticalSmoothed[std::max(x - 1, 0)];
+      const float vertGrad = smoothedBelow[x] - smoothedAbove[x];
+      gradientLine[x] = horGrad * m_unitDownVec[0] + vertGrad * m_unitDownVec[1];
+    }
+    gradientLine += gradient.stride();
+  }
+}  // TextLineRefiner::calcGradientRows
+
 float TextLineRefiner::externalEnergyAt(const Grid<float>& gradient, const Vec2f& pos, float penaltyIfOutside) {
   const auto xBase = static_cast<float>(std::floor(pos[0]));
   const auto yBase = static_cast<float>(std::floor(pos[1]));
@@ -56,6 +56,11 @@ class TextLineRefiner {
 
   void calcBlurredGradient(Grid<float>& gradient, float hSigma, float vSigma) const;
 
+  /**
+   * Computes the directional derivative along m_unitDownVec for rows [fromY, toY).
+   */
+  void calcGradientRows(Grid<float>& gradient, int fromY, int toY) const;
+
   static float externalEnergyAt(const Grid<float>& gradient, const Vec2f& pos, float penaltyIfOutside);
 
   static Snake makeSnake(const std::vector<QPointF>& polyline, int iterations);
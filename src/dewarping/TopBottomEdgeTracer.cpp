@@ -21,32 +21,21 @@
 #include "LineBoundedByRect.h"
 #include "MatrixCalc.h"
 #include "NumericTraits.h"
-#include "PriorityQueue.h"
+#include "ParallelFor.h"
 #include "TaskStatus.h"
 #include "ToLineProjector.h"
 
 using namespace imageproc;
 
 namespace dewarping {
-struct TopBottomEdgeTracer::GridNode {
- private:
-  static const uint32_t HEAP_IDX_BITS = 28;
-  static const uint32_t PREV_NEIGHBOUR_BITS = 3;
-  static const uint32_t PATH_CONTINUATION_BITS = 1;
-
-  static const uint32_t HEAP_IDX_SHIFT = 0;
-  static const uint32_t PREV_NEIGHBOUR_SHIFT = HEAP_IDX_SHIFT + HEAP_IDX_BITS;
-  static const uint32_t PATH_CONTINUATION_SHIFT = PREV_NEIGHBOUR_SHIFT + PREV_NEIGHBOUR_BITS;
-
-  static const uint32_t HEAP_IDX_MASK = ((uint32_t(1) << HEAP_IDX_BITS) - uint32_t(1)) << HEAP_IDX_SHIFT;
-  static const uint32_t PREV_NEIGHBOUR_MASK = ((uint32_t(1) << PREV_NEIGHBOUR_BITS) - uint32_t(1))
-                                              << PREV_NEIGHBOUR_SHIFT;
-  static const uint32_t PATH_CONTINUATION_MASK = ((uint32_t(1) << PATH_CONTINUATION_BITS) - uint32_t(1))
-                                                 << PATH_CONTINUATION_SHIFT;
-
- public:
-  static const uint32_t INVALID_HEAP_IDX = HEAP_IDX_MASK >> HEAP_IDX_SHIFT;
+namespace {
+/**
+ * The number of grid rows or columns in a unit of work when processing the grid in parallel.
+ */
+const int LINES_PER_BAND = 64;
+}  // namespace
 
+struct TopBottomEdgeTracer::GridNode {
   union {
     float dirDeriv;  // Directional derivative.
     float xGrad;     // x component of the gradient.
@@ -61,14 +50,24 @@ struct TopBottomEdgeTracer::GridNode {
   // Note: xGrad and yGrad are used to calculate the directional
   // derivative, which then gets stored in dirDeriv.  Obviously,
   // pathCost gets overwritten, which is not a problem in our case.
-  uint32_t packedData;
+
+  /**
+   * Neibhgours are indexed like this:
+   * 0 1 2
+   * 3   4
+   * 5 6 7
+   */
+  uint8_t prevNeighbour;
+
+  bool pathContinuation;
 
   float absDirDeriv() const { return std::fabs(dirDeriv); }
 
   void setupForPadding() {
     dirDeriv = 0;
     pathCost = -1;
-    packedData = INVALID_HEAP_IDX;
+    prevNeighbour = 0;
+    pathContinuation = false;
   }
 
   /**
@@ -76,29 +75,18 @@ struct TopBottomEdgeTracer::GridNode {
    */
   void setupForInterior() {
     pathCost = NumericTraits<float>::max();
-    packedData = INVALID_HEAP_IDX;
+    prevNeighbour = 0;
+    pathContinuation = false;
   }
 
-  uint32_t heapIdx() const { return (packedData & HEAP_IDX_MASK) >> HEAP_IDX_SHIFT; }
+  bool hasPathContinuation() const { return pathContinuation; }
 
-  void setHeapIdx(uint32_t idx) {
-    assert(!(idx & ~(HEAP_IDX_MASK >> HEAP_IDX_SHIFT)));
-    packedData = idx | (packedData & ~HEAP_IDX_MASK);
-  }
-
-  bool hasPathContinuation() const { return static_cast<bool>(packedData & PATH_CONTINUATION_MASK); }
-
-  /**
-   * Neibhgours are indexed like this:
-   * 0 1 2
-   * 3   4
-   * 5 6 7
-   */
-  uint32_t prevNeighbourIdx() const { return (packedData & PREV_NEIGHBOUR_MASK) >> PREV_NEIGHBOUR_SHIFT; }
+  uint32_t prevNeighbourIdx() const { return prevNeighbour; }
 
   void setPrevNeighbourIdx(uint32_t idx) {
-    assert(!(idx & ~(PREV_NEIGHBOUR_MASK >> PREV_NEIGHBOUR_SHIFT)));
-    packedData = PATH_CONTINUATION_MASK | (idx << PREV_NEIGHBOUR_SHIFT) | (packedData & ~PREV_NEIGHBOUR_MASK);
+    assert(idx < 8);
+    prevNeighbour = static_cast<uint8_t>(idx);
+    pathContinuation = true;
   }
 
   void setBothGradients(float grad) {
@@ -108,18 +96,49 @@ struct TopBottomEdgeTracer::GridNode {
 };
 
 
-class TopBottomEdgeTracer::PrioQueue : public PriorityQueue<uint32_t, PrioQueue> {
+/**
+ * \brief Finds the paths minimizing the maximum of node costs along them.
+ *
+ * The cost of a node is 1 - |dirDeriv|, so path costs are in [0, 1] range.
+ * Instead of a binary heap, nodes are queued in buckets corresponding to
+ * quantized path costs (Dial's algorithm).  Path costs only grow along a path,
+ * so buckets are processed in a single pass.  Within a bucket, nodes aren't
+ * ordered by their exact cost, so a node that gets a lower cost after being
+ * processed is simply queued again.  That keeps the resulting path costs exact.
+ *
+ * The state of the search is kept in separate arrays, indexed like the grid,
+ * rather than in GridNode, which keeps the working set small.
+ */
+class TopBottomEdgeTracer::PathSearch {
  public:
-  explicit PrioQueue(Grid<GridNode>& grid) : m_data(grid.data()) {}
+  explicit PathSearch(const Grid<GridNode>& grid);
 
-  bool higherThan(uint32_t lhs, uint32_t rhs) const { return m_data[lhs].pathCost < m_data[rhs].pathCost; }
+  void addSource(int gridIdx);
 
-  void setIndex(uint32_t gridIdx, size_t heapIdx) { m_data[gridIdx].setHeapIdx(static_cast<uint32_t>(heapIdx)); }
+  void propagate(const Vec2f& direction);
 
-  void reposition(GridNode* node) { PriorityQueue<uint32_t, PrioQueue>::reposition(node->heapIdx()); }
+  /**
+   * Stores path costs and the previous neighbour indexes in the grid.
+   */
+  void writeResults(Grid<GridNode>& grid) const;
 
  private:
-  GridNode* const m_data;
+  static constexpr int NUM_BUCKETS = 4096;
+  static constexpr uint16_t NOT_QUEUED = 0xffff;
+  static constexpr uint8_t NO_PREV_NEIGHBOUR = 0xff;
+
+  static int bucketFor(float cost) { return std::min(static_cast<int>(cost * NUM_BUCKETS), NUM_BUCKETS - 1); }
+
+  int index(int gridIdx) const { return gridIdx + m_origin; }
+
+  void enqueue(int idx, int bucket);
+
+  int m_origin;
+  std::vector<float> m_nodeCosts;
+  std::vector<float> m_pathCosts;
+  std::vector<uint8_t> m_prevNeighbours;
+  std::vector<uint16_t> m_queuedBuckets;
+  std::vector<std::vector<uint32_t>> m_buckets;
 };
 
 
@@ -204,12 +223,13 @@ void TopBottomEdgeTracer::trace(const imageproc::GrayImage& image,
 
   status.throwIfCancelled();
 
-  PrioQueue queue(grid);
-
   // Shortest paths from bounds.first towards bounds.second.
-  prepareForShortestPathsFrom(queue, grid, bounds.first);
-  const Vec2f dir1stTo2nd(directionFromPointToLine(bounds.first.pointAt(0.5), bounds.second));
-  propagateShortestPaths(dir1stTo2nd, queue, grid);
+  {
+    PathSearch search(grid);
+    addPathSources(search, grid, bounds.first);
+    search.propagate(directionFromPointToLine(bounds.first.pointAt(0.5), bounds.second));
+    search.writeResults(grid);
+  }
   const std::vector<QPoint> endpoints1(locateBestPathEndpoints(grid, bounds.second));
   if (dbg) {
     dbg->add(visualizePaths(downscaled, grid, bounds, endpoints1), "best_paths_ltr");
@@ -218,22 +238,27 @@ void TopBottomEdgeTracer::trace(const imageproc::GrayImage& image,
   gaussBlurGradient(grid);
 
   std::vector<std::vector<QPointF>> snakes;
-  snakes.reserve(endpoints1.size());
-
-  for (QPoint endpoint : endpoints1) {
-    snakes.push_back(pathToSnake(grid, endpoint));
-    const Vec2f dir(downTheHillDirection(downscaled.rect(), snakes.back(), avgBoundsDir));
-    downTheHillSnake(snakes.back(), grid, dir);
-  }
+  snakes.resize(endpoints1.size());
+
+  // Each snake only reads the grid, so they can be processed concurrently.
+  parallelFor(0, static_cast<int>(endpoints1.size()), 1, [&](const int from, const int to) {
+    for (int i = from; i < to; ++i) {
+      snakes[i] = pathToSnake(grid, endpoints1[i]);
+      const Vec2f dir(downTheHillDirection(downscaled.rect(), snakes[i], avgBoundsDir));
+      downTheHillSnake(snakes[i], grid, dir);
+    }
+  });
   if (dbg) {
     const QImage background(visualizeBlurredGradient(grid));
     dbg->add(visualizeSnakes(background, snakes, bounds), "down_the_hill_snakes");
   }
 
-  for (std::vector<QPointF>& snake : snakes) {
-    const Vec2f dir(-downTheHillDirection(downscaled.rect(), snake, avgBoundsDir));
-    upTheHillSnake(snake, grid, dir);
-  }
+  parallelFor(0, static_cast<int>(snakes.size()), 1, [&](const int from, const int to) {
+    for (int i = from; i < to; ++i) {
+      const Vec2f dir(-downTheHillDirection(downscaled.rect(), snakes[i], avgBoundsDir));
+      upTheHillSnake(snakes[i], grid, dir);
+    }
+  });
   if (dbg) {
     const QImage background(visualizeGradient(grid));
     dbg->add(visualizeSnakes(background, snakes, bounds), "up_the_hill_snakes");
@@ -272,9 +297,6 @@ void TopBottomEdgeTracer::calcDirectionalDerivative(Grid<GridNode>& grid,
   const int gridStride = grid.stride();
   const int imageStride = image.stride();
 
-  const uint8_t* imageLine = image.data();
-  GridNode* gridLine = grid.data();
-
   // This ensures that partial derivatives never go beyond the [-1, 1] range.
   const float scale = 1.0f / (255.0f * 8.0f);
 
@@ -282,16 +304,20 @@ void TopBottomEdgeTracer::calcDirectionalDerivative(Grid<GridNode>& grid,
   // to calculate the gradient.
 
   // Copy image to gradient.
-  for (int y = 0; y < height; ++y) {
-    for (int x = 0; x < width; ++x) {
-      gridLine[x].setBothGradients(scale * imageLine[x]);
+  parallelFor(0, height, LINES_PER_BAND, [&](const int fromY, const int toY) {
+    const uint8_t* imageLine = image.data() + imageStride * fromY;
+    GridNode* gridLine = grid.data() + gridStride * fromY;
+    for (int y = fromY; y < toY; ++y) {
+      for (int x = 0; x < width; ++x) {
+        gridLine[x].setBothGradients(scale * imageLine[x]);
+      }
+      imageLine += imageStride;
+      gridLine += gridStride;
     }
-    imageLine += imageStride;
-    gridLine += gridStride;
-  }
+  });
 
   // Write border corners.
-  gridLine = grid.paddedData();
+  GridNode* gridLine = grid.paddedData();
   gridLine[0].setBothGradients(gridLine[gridStride + 1].xGrad);
   gridLine[gridStride - 1].setBothGradients(gridLine[gridStride * 2 - 2].xGrad);
   gridLine += gridStride * (height + 1);
@@ -322,16 +348,18 @@ void TopBottomEdgeTracer::calcDirectionalDerivative(Grid<GridNode>& grid,
   horizontalSobelInPlace(grid);
   verticalSobelInPlace(grid);
   // From horizontal and vertical gradients, calculate the directional one.
-  gridLine = grid.data();
-  for (int y = 0; y < height; ++y) {
-    for (int x = 0; x < width; ++x) {
-      const Vec2f gradVec(gridLine[x].xGrad, gridLine[x].yGrad);
-      gridLine[x].dirDeriv = gradVec.dot(direction);
-      assert(std::fabs(gridLine[x].dirDeriv) <= 1.0);
-    }
+  parallelFor(0, height, LINES_PER_BAND, [&](const int fromY, const int toY) {
+    GridNode* gridLine = grid.data() + gridStride * fromY;
+    for (int y = fromY; y < toY; ++y) {
+      for (int x = 0; x < width; ++x) {
+        const Vec2f gradVec(gridLine[x].xGrad, gridLine[x].yGrad);
+        gridLine[x].dirDeriv = gradVec.dot(direction);
+        assert(std::fabs(gridLine[x].dirDeriv) <= 1.0);
+      }
 
-    gridLine += gridStride;
-  }
+      gridLine += gridStride;
+    }
+  });
 }  // TopBottomEdgeTracer::calcDirectionalDerivative
 
 void TopBottomEdgeTracer::horizontalSobelInPlace(Grid<GridNode>& grid) {
@@ -341,29 +369,33 @@ void TopBottomEdgeTracer::horizontalSobelInPlace(Grid<GridNode>& grid) {
   const int height = grid.height();
   const int gridStride = grid.stride();
 
-  // Do a vertical pass.
-  for (int x = -1; x < width + 1; ++x) {
-    GridNode* pGrid = grid.data() + x;
-    float prev = pGrid[-gridStride].xGrad;
-    for (int y = 0; y < height; ++y) {
-      const float cur = pGrid->xGrad;
-      pGrid->xGrad = prev + cur + cur + pGrid[gridStride].xGrad;
-      prev = cur;
-      pGrid += gridStride;
+  // Do a vertical pass.  Columns are independent from each other.
+  parallelFor(-1, width + 1, LINES_PER_BAND, [&](const int fromX, const int toX) {
+    for (int x = fromX; x < toX; ++x) {
+      GridNode* pGrid = grid.data() + x;
+      float prev = pGrid[-gridStride].xGrad;
+      for (int y = 0; y < height; ++y) {
+        const float cur = pGrid->xGrad;
+        pGrid->xGrad = prev + cur + cur + pGrid[gridStride].xGrad;
+        prev = cur;
+        pGrid += gridStride;
+      }
     }
-  }
-
-  // Do a horizontal pass and write results.
-  GridNode* gridLine = grid.data();
-  for (int y = 0; y < height; ++y) {
-    float prev = gridLine[-1].xGrad;
-    for (int x = 0; x < width; ++x) {
-      float cur = gridLine[x].xGrad;
-      gridLine[x].xGrad = gridLine[x + 1].xGrad - prev;
-      prev = cur;
+  });
+
+  // Do a horizontal pass and write results.  Rows are independent from each other.
+  parallelFor(0, height, LINES_PER_BAND, [&](const int fromY, const int toY) {
+    GridNode* gridLine = grid.data() + gridStride * fromY;
+    for (int y = fromY; y < toY; ++y) {
+      float prev = gridLine[-1].xGrad;
+      for (int x = 0; x < width; ++x) {
+        float cur = gridLine[x].xGrad;
+        gridLine[x].xGrad = gridLine[x + 1].xGrad - prev;
+        prev = cur;
+      }
+      gridLine += gridStride;
     }
-    gridLine += gridStride;
-  }
+  });
 }
 
 void TopBottomEdgeTracer::verticalSobelInPlace(Grid<GridNode>& grid) {
@@ -372,29 +404,33 @@ void TopBottomEdgeTracer::verticalSobelInPlace(Grid<GridNode>& grid) {
   const int width = grid.width();
   const int height = grid.height();
   const int gridStride = grid.stride();
-  // Do a horizontal pass.
-  GridNode* gridLine = grid.paddedData() + 1;
-  for (int y = 0; y < height + 2; ++y) {
-    float prev = gridLine[-1].yGrad;
-    for (int x = 0; x < width; ++x) {
-      float cur = gridLine[x].yGrad;
-      gridLine[x].yGrad = prev + cur + cur + gridLine[x + 1].yGrad;
-      prev = cur;
+  // Do a horizontal pass.  Rows are independent from each other.
+  parallelFor(0, height + 2, LINES_PER_BAND, [&](const int fromY, const int toY) {
+    GridNode* gridLine = grid.paddedData() + gridStride * fromY + 1;
+    for (int y = fromY; y < toY; ++y) {
+      float prev = gridLine[-1].yGrad;
+      for (int x = 0; x < width; ++x) {
+        float cur = gridLine[x].yGrad;
+        gridLine[x].yGrad = prev + cur + cur + gridLine[x + 1].yGrad;
+        prev = cur;
+      }
+      gridLine += gridStride;
     }
-    gridLine += gridStride;
-  }
-
-  // Do a vertical pass and write resuts.
-  for (int x = 0; x < width; ++x) {
-    GridNode* pGrid = grid.data() + x;
-    float prev = pGrid[-gridStride].yGrad;
-    for (int y = 0; y < height; ++y) {
-      const float cur = pGrid->yGrad;
-      pGrid->yGrad = pGrid[gridStride].yGrad - prev;
-      prev = cur;
-      pGrid += gridStride;
+  });
+
+  // Do a vertical pass and write resuts.  Columns are independent from each other.
+  parallelFor(0, width, LINES_PER_BAND, [&](const int fromX, const int toX) {
+    for (int x = fromX; x < toX; ++x) {
+      GridNode* pGrid = grid.data() + x;
+      float prev = pGrid[-gridStride].yGrad;
+      for (int y = 0; y < height; ++y) {
+        const float cur = pGrid->yGrad;
+        pGrid->yGrad = pGrid[gridStride].yGrad - prev;
+        prev = cur;
+        pGrid += gridStride;
+      }
     }
-  }
+  });
 }
 
 Vec2f TopBottomEdgeTracer::calcAvgUnitVector(const std::pair<QLineF, QLineF>& bounds) {
@@ -418,26 +454,10 @@ Vec2f TopBottomEdgeTracer::directionFromPointToLine(const QPointF& pt, const QLi
   return vec;
 }
 
-void TopBottomEdgeTracer::prepareForShortestPathsFrom(PrioQueue& queue, Grid<GridNode>& grid, const QLineF& from) {
-  GridNode padding_node{};
-  padding_node.setupForPadding();
-  grid.initPadding(padding_node);
-
+void TopBottomEdgeTracer::addPathSources(PathSearch& search, const Grid<GridNode>& grid, const QLineF& from) {
   const int width = grid.width();
   const int height = grid.height();
   const int stride = grid.stride();
-  GridNode* const data = grid.data();
-
-  GridNode* line = grid.data();
-  for (int y = 0; y < height; ++y) {
-    for (int x = 0; x < width; ++x) {
-      GridNode* node = line + x;
-      node->setupForInterior();
-      // This doesn't modify dirDeriv, which is why
-      // we can't use grid.initInterior().
-    }
-    line += stride;
-  }
 
   GridLineTraverser traverser(from);
   while (traverser.hasNext()) {
@@ -446,46 +466,10 @@ void TopBottomEdgeTracer::prepareForShortestPathsFrom(PrioQueue& queue, Grid<Gri
     // intersectWithRect() ensures that.
     assert(pt.x() >= 0 && pt.y() >= 0 && pt.x() < width && pt.y() < height);
 
-    const int offset = pt.y() * stride + pt.x();
-    data[offset].pathCost = 0;
-    queue.push(offset);
+    search.addSource(pt.y() * stride + pt.x());
   }
 }
 
-void TopBottomEdgeTracer::propagateShortestPaths(const Vec2f& direction, PrioQueue& queue, Grid<GridNode>& grid) {
-  GridNode* const data = grid.data();
-
-  int nextNbhOffsets[8];
-  int prevNbhIndexes[8];
-  const int numNeighbours = initNeighbours(nextNbhOffsets, prevNbhIndexes, grid.stride(), direction);
-
-  while (!queue.empty()) {
-    const int gridIdx = queue.front();
-    GridNode* node = data + gridIdx;
-    assert(node->pathCost >= 0);
-    queue.pop();
-    node->setHeapIdx(GridNode::INVALID_HEAP_IDX);
-
-    for (int i = 0; i < numNeighbours; ++i) {
-      const int nbhGridIdx = gridIdx + nextNbhOffsets[i];
-      GridNode* nbhNode = data + nbhGridIdx;
-
-      assert(std::fabs(node->dirDeriv) <= 1.0);
-      const float newCost
-          = std::max<float>(node->pathCost, static_cast<const float&>(1.0f - std::fabs(node->dirDeriv)));
-      if (newCost < nbhNode->pathCost) {
-        nbhNode->pathCost = newCost;
-        nbhNode->setPrevNeighbourIdx(prevNbhIndexes[i]);
-        if (nbhNode->heapIdx() == GridNode::INVALID_HEAP_IDX) {
-          queue.push(nbhGridIdx);
-        } else {
-          queue.reposition(nbhNode);
-        }
-      }
-    }
-  }
-}  // TopBottomEdgeTracer::propagateShortestPaths
-
 int TopBottomEdgeTracer::initNeighbours(int* nextNbhOffsets, int* prevNbhIndexes, int stride, const Vec2f& direction) {
   const int candidate_offsets[] = {-stride - 1, -stride, -stride + 1, -1, 1, stride - 1, stride, stride + 1};
 
@@ -506,6 +490,108 @@ int TopBottomEdgeTracer::initNeighbours(int* nextNbhOffsets, int* prevNbhIndexes
   return outIdx;
 }  // TopBottomEdgeTracer::initNeighbours
 
+/*============================ PathSearch ==============================*/
+
+TopBottomEdgeTracer::PathSearch::PathSearch(const Grid<GridNode>& grid)
+    : m_origin(grid.stride() + 1),
+      m_nodeCosts(grid.stride() * (grid.height() + 2)),
+      m_pathCosts(m_nodeCosts.size(), -1.0f),
+      m_prevNeighbours(m_nodeCosts.size(), NO_PREV_NEIGHBOUR),
+      m_queuedBuckets(m_nodeCosts.size(), NOT_QUEUED),
+      m_buckets(NUM_BUCKETS) {
+  assert(grid.padding() == 1);
+
+  const int width = grid.width();
+  const int height = grid.height();
+  const int stride = grid.stride();
+
+  // Padding nodes keep the negative path cost, which no path can improve.
+  const GridNode* gridLine = grid.data();
+  for (int y = 0; y < height; ++y) {
+    const int lineIdx = index(y * stride);
+    for (int x = 0; x < width; ++x) {
+      assert(std::fabs(gridLine[x].dirDeriv) <= 1.0);
+      m_nodeCosts[lineIdx + x] = 1.0f - gridLine[x].absDirDeriv();
+      m_pathCosts[lineIdx + x] = NumericTraits<float>::max();
+    }
+    gridLine += stride;
+  }
+}
+
+void TopBottomEdgeTracer::PathSearch::addSource(const int gridIdx) {
+  const int idx = index(gridIdx);
+  m_pathCosts[idx] = 0;
+  enqueue(idx, 0);
+}
+
+void TopBottomEdgeTracer::PathSearch::enqueue(const int idx, const int bucket) {
+  if (m_queuedBuckets[idx] != bucket) {
+    // If it was queued in another bucket, that entry becomes stale.
+    m_queuedBuckets[idx] = static_cast<uint16_t>(bucket);
+    m_buckets[bucket].push_back(static_cast<uint32_t>(idx));
+  }
+}
+
+void TopBottomEdgeTracer::PathSearch::propagate(const Vec2f& direction) {
+  int nextNbhOffsets[8];
+  int prevNbhIndexes[8];
+  const int stride = m_origin - 1;
+  const int numNeighbours = initNeighbours(nextNbhOffsets, prevNbhIndexes, stride, direction);
+
+  for (int bucket = 0; bucket < NUM_BUCKETS; ++bucket) {
+    std::vector<uint32_t>& queue = m_buckets[bucket];
+    // Note that the queue may grow while we are iterating over it.
+    for (size_t i = 0; i < queue.size(); ++i) {
+      const uint32_t idx = queue[i];
+      if (m_queuedBuckets[idx] != bucket) {
+        continue;  // A stale entry.
+      }
+      m_queuedBuckets[idx] = NOT_QUEUED;
+
+      assert(m_pathCosts[idx] >= 0);
+      const float newCost = std::max<float>(m_pathCosts[idx], m_nodeCosts[idx]);
+      const int newBucket = bucketFor(newCost);
+      assert(newBucket >= bucket);
+
+      for (int j = 0; j < numNeighbours; ++j) {
+        const uint32_t nbhIdx = idx + nextNbhOffsets[j];
+        if (newCost < m_pathCosts[nbhIdx]) {
+          m_pathCosts[nbhIdx] = newCost;
+          m_prevNeighbours[nbhIdx] = static_cast<uint8_t>(prevNbhIndexes[j]);
+          enqueue(nbhIdx, newBucket);
+        }
+      }
+    }
+    std::vector<uint32_t>().swap(queue);
+  }
+}  // TopBottomEdgeTracer::PathSearch::propagate
+
+void TopBottomEdgeTracer::PathSearch::writeResults(Grid<GridNode>& grid) const {
+  GridNode paddingNode{};
+  paddingNode.setupForPadding();
+  grid.initPadding(paddingNode);
+
+  const int width = grid.width();
+  const int height = grid.height();
+  const int stride = grid.stride();
+
+  GridNode* gridLine = grid.data();
+  for (int y = 0; y < height; ++y) {
+    const int lineIdx = index(y * stride);
+    for (int x = 0; x < width; ++x) {
+      GridNode& node = gridLine[x];
+      // This doesn't modify dirDeriv, which is why
+      // we can't use grid.initInterior().
+      node.setupForInterior();
+      node.pathCost = m_pathCosts[lineIdx + x];
+      if (m_prevNeighbours[lineIdx + x] != NO_PREV_NEIGHBOUR) {
+        node.setPrevNeighbourIdx(m_prevNeighbours[lineIdx + x]);
+      }
+    }
+    gridLine += stride;
+  }
+}
+
 namespace {
 struct Path {
   QPoint pt;
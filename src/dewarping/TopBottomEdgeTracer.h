@@ -37,7 +37,7 @@ class TopBottomEdgeTracer {
  private:
   struct GridNode;
 
-  class PrioQueue;
+  class PathSearch;
 
   struct Step;
 
@@ -57,9 +57,7 @@ class TopBottomEdgeTracer {
 
   static Vec2f directionFromPointToLine(const QPointF& pt, const QLineF& line);
 
-  static void prepareForShortestPathsFrom(PrioQueue& queue, Grid<GridNode>& grid, const QLineF& from);
-
-  static void propagateShortestPaths(const Vec2f& direction, PrioQueue& queue, Grid<GridNode>& grid);
+  static void addPathSources(PathSearch& search, const Grid<GridNode>& grid, const QLineF& from);
 
   static int initNeighbours(int* nextNbhOffsets, int* prevNbhIndexes, int stride, const Vec2f& direction);
 
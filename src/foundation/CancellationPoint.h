@@ -0,0 +1,51 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#ifndef SCANTAILOR_FOUNDATION_CANCELLATIONPOINT_H_
+#define SCANTAILOR_FOUNDATION_CANCELLATIONPOINT_H_
+
+#include "NonCopyable.h"
+#include "TaskStatus.h"
+
+/**
+ * \brief Lets long running kernels notice their task was cancelled
+ *        without having a TaskStatus passed to them.
+ *
+ * The code running a task makes its status current for the calling thread
+ * by creating a Scope object.  Kernels call poll() every row or so, which
+ * throws whatever TaskStatus::throwIfCancelled() throws.  Outside of a scope,
+ * and in threads other than the one that created it, poll() does nothing.
+ */
+class CancellationPoint {
+ public:
+  class Scope {
+    DECLARE_NON_COPYABLE(Scope)
+
+   public:
+    explicit Scope(const TaskStatus& status) : m_prevStatus(s_status) { s_status = &status; }
+
+    ~Scope() { s_status = m_prevStatus; }
+
+   private:
+    const TaskStatus* m_prevStatus;
+  };
+
+  /**
+   * \brief Returns the status made current for the calling thread, or null.
+   *
+   * Useful for propagating it to helper threads working on behalf of this one.
+   */
+  static const TaskStatus* currentStatus() { return s_status; }
+
+  static void poll() {
+    if (const TaskStatus* status = s_status) {
+      status->throwIfCancelled();
+    }
+  }
+
+ private:
+  static thread_local const TaskStatus* s_status;
+};
+
+
+#endif  // ifndef SCANTAILOR_FOUNDATION_CANCELLATIONPOINT_H_
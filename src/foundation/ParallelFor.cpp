@@ -0,0 +1,155 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#include "ParallelFor.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+#include "CancellationPoint.h"
+
+namespace {
+class ParallelForJob {
+ public:
+  ParallelForJob(int begin, int end, int grainSize, const std::function<void(int, int)>& body)
+      : m_begin(begin),
+        m_end(end),
+        m_grainSize(grainSize),
+        m_numChunks((end - begin + grainSize - 1) / grainSize),
+        m_body(body),
+        m_nextChunk(0),
+        m_failed(false),
+        m_chunksDone(0) {}
+
+  int numChunks() const { return m_numChunks; }
+
+  /**
+   * Processes chunks until there are none left.
+   *
+   * Note that once every chunk is taken, m_body is no longer touched,
+   * which is why helpers may outlive the parallelFor() call.
+   */
+  void work() {
+    while (true) {
+      const int chunk = m_nextChunk.fetch_add(1);
+      if (chunk >= m_numChunks) {
+        break;
+      }
+
+      if (!m_failed.load()) {
+        const int from = m_begin + chunk * m_grainSize;
+        const int to = std::min(from + m_grainSize, m_end);
+        try {
+          m_body(from, to);
+        } catch (...) {
+          const QMutexLocker locker(&m_mutex);
+          if (!m_exception) {
+            m_exception = std::current_exception();
+          }
+          m_failed.store(true);
+        }
+      }
+
+      const QMutexLocker locker(&m_mutex);
+      if (++m_chunksDone == m_numChunks) {
+        m_cond.wakeAll();
+      }
+    }
+  }
+
+  void waitAndRethrow() {
+    QMutexLocker locker(&m_mutex);
+    while (m_chunksDone != m_numChunks) {
+      m_cond.wait(&m_mutex);
+    }
+    if (m_exception) {
+      std::rethrow_exception(m_exception);
+    }
+  }
+
+ private:
+  const int m_begin;
+  const int m_end;
+  const int m_grainSize;
+  const int m_numChunks;
+  const std::function<void(int, int)>& m_body;
+  std::atomic<int> m_nextChunk;
+  std::atomic<bool> m_failed;
+  QMutex m_mutex;
+  QWaitCondition m_cond;
+  int m_chunksDone;
+  std::exception_ptr m_exception;
+};
+
+
+/**
+ * The priority of the calling thread, which is what helpers run at.
+ */
+QThread::Priority callerPriority() {
+  const QThread::Priority priority = QThread::currentThread()->priority();
+  // Threads not started by QThread, such as the main one, report no priority of their own.
+  return (priority == QThread::InheritPriority) ? QThread::NormalPriority : priority;
+}
+
+class Helper : public QRunnable {
+ public:
+  Helper(std::shared_ptr<ParallelForJob> job, const TaskStatus* status, const QThread::Priority threadPriority)
+      : m_job(std::move(job)), m_status(status), m_threadPriority(threadPriority) {
+    setAutoDelete(true);
+  }
+
+  void run() override {
+    // Otherwise helpers of a low priority batch task would run at whatever
+    // priority the pool thread was left with.
+    if (QThread::currentThread()->priority() != m_threadPriority) {
+      QThread::currentThread()->setPriority(m_threadPriority);
+    }
+
+    if (m_status) {
+      const CancellationPoint::Scope cancellationScope(*m_status);
+      m_job->work();
+    } else {
+      m_job->work();
+    }
+  }
+
+ private:
+  std::shared_ptr<ParallelForJob> m_job;
+  const TaskStatus* m_status;
+  const QThread::Priority m_threadPriority;
+};
+}  // namespace
+
+void parallelFor(const int begin, const int end, const int grainSize, const std::function<void(int, int)>& body) {
+  if (begin >= end) {
+    return;
+  }
+
+  const int grain = std::max(grainSize, 1);
+  QThreadPool* pool = QThreadPool::globalInstance();
+  const int numHelpers = std::min((end - begin - 1) / grain, pool->maxThreadCount() - 1);
+  if (numHelpers <= 0) {
+    body(begin, end);
+    return;
+  }
+
+  auto job = std::make_shared<ParallelForJob>(begin, end, grain, body);
+  const TaskStatus* status = CancellationPoint::currentStatus();
+  const QThread::Priority threadPriority = callerPriority();
+  // The pool is shared by interactive and batch tasks, so queue the helpers
+  // of higher priority threads ahead of the others.
+  for (int i = 0; i < numHelpers; ++i) {
+    pool->start(new Helper(job, status, threadPriority), threadPriority);
+  }
+
+  job->work();
+  job->waitAndRethrow();
+}
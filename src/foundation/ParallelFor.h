@@ -0,0 +1,32 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#ifndef SCANTAILOR_FOUNDATION_PARALLELFOR_H_
+#define SCANTAILOR_FOUNDATION_PARALLELFOR_H_
+
+#include <functional>
+
+/**
+ * \brief Calls body(from, to) for consecutive subranges of [begin, end),
+ *        processing several of them concurrently.
+ *
+ * The range is split into chunks of \p grainSize elements (the last one may
+ * be shorter), which are handed out to the threads of QThreadPool::globalInstance()
+ * and to the calling thread.  The calling thread keeps taking chunks until none
+ * are left, so the call completes even if the pool is busy with other work,
+ * including the case of nested calls.  The function returns once every chunk
+ * has been processed.
+ *
+ * As long as \p body only writes the data corresponding to its subrange,
+ * the results are the same as those of a serial loop, no matter how many
+ * threads took part.
+ *
+ * The cancellation status made current for the calling thread by
+ * CancellationPoint::Scope is made current in the helper threads as well.
+ * If \p body throws, the chunks not started yet are skipped, and the first
+ * exception is rethrown in the calling thread.
+ */
+void parallelFor(int begin, int end, int grainSize, const std::function<void(int from, int to)>& body);
+
+
+#endif  // ifndef SCANTAILOR_FOUNDATION_PARALLELFOR_H_
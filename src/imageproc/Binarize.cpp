@@ -9,6 +9,7 @@
 #include <stdexcept>
 
 #include "BinaryImage.h"
+#include "CancellationPoint.h"
 #include "Grayscale.h"
 #include "IntegralImage.h"
 
@@ -42,6 +43,7 @@ BinaryImage binarizeSauvola(const QImage& src, const QSize windowSize, const dou
   const int grayBpl = gray.bytesPerLine();
 
   for (int y = 0; y < h; ++y, grayLine += grayBpl) {
+    CancellationPoint::poll();
     integralImage.beginRow();
     integralSqimage.beginRow();
     for (int x = 0; x < w; ++x) {
@@ -62,6 +64,7 @@ BinaryImage binarizeSauvola(const QImage& src, const QSize windowSize, const dou
 
   grayLine = gray.bits();
   for (int y = 0; y < h; ++y) {
+    CancellationPoint::poll();
     const int top = std::max(0, y - windowLowerHalf);
     const int bottom = std::min(h, y + windowUpperHalf);  // exclusive
     for (int x = 0; x < w; ++x) {
@@ -125,6 +128,7 @@ BinaryImage binarizeWolf(const QImage& src,
   uint32_t minGrayLevel = 255;
 
   for (int y = 0; y < h; ++y, grayLine += grayBpl) {
+    CancellationPoint::poll();
     integralImage.beginRow();
     integralSqimage.beginRow();
     for (int x = 0; x < w; ++x) {
@@ -146,6 +150,7 @@ BinaryImage binarizeWolf(const QImage& src,
   double maxDeviation = 0;
 
   for (int y = 0; y < h; ++y) {
+    CancellationPoint::poll();
     const int top = std::max(0, y - windowLowerHalf);
     const int bottom = std::min(h, y + windowUpperHalf);  // exclusive
     for (int x = 0; x < w; ++x) {
@@ -177,6 +182,7 @@ BinaryImage binarizeWolf(const QImage& src,
 
   grayLine = gray.bits();
   for (int y = 0; y < h; ++y, grayLine += grayBpl, bwLine += bwWpl) {
+    CancellationPoint::poll();
     for (int x = 0; x < w; ++x) {
       const float mean = means[y * w + x];
       const float deviation = deviations[y * w + x];
@@ -3,15 +3,19 @@
 
 #include "ColorSegmenter.h"
 
+#include <ParallelFor.h>
+
 #include <QImage>
+#include <cassert>
 #include <cmath>
 #include <stdexcept>
+#include <vector>
 
 #include "BinaryImage.h"
 #include "BinaryThreshold.h"
 #include "ConnectivityMap.h"
 #include "GrayImage.h"
-#include "ImageCombination.h"
+#include "Grayscale.h"
 #include "InfluenceMap.h"
 #include "RasterOp.h"
 
@@ -100,66 +104,236 @@ bool ComponentCleaner::eligibleForDelete(const Component& component, const Bound
   return (averageWidth <= m_minAverageWidthThreshold);
 }
 
-enum RgbChannel { RED_CHANNEL, GREEN_CHANNEL, BLUE_CHANNEL };
-
-GrayImage extractRgbChannel(const QImage& image, const RgbChannel channel) {
-  if ((image.format() != QImage::Format_RGB32) && (image.format() != QImage::Format_ARGB32)) {
-    throw std::invalid_argument("ColorSegmenter: wrong image format.");
-  }
-
-  GrayImage dst(image.size());
-  const auto* imgLine = reinterpret_cast<const uint32_t*>(image.bits());
-  const int imgStride = image.bytesPerLine() / sizeof(uint32_t);
-  uint8_t* dstLine = dst.data();
-  const int dstStride = dst.stride();
-  const int width = image.width();
-  const int height = image.height();
+inline BinaryThreshold adjustThreshold(const BinaryThreshold threshold, const int adjustment) {
+  return qBound(1, int(threshold) + adjustment, 255);
+}
 
-  for (int y = 0; y < height; ++y) {
-    for (int x = 0; x < width; ++x) {
-      switch (channel) {
-        case RED_CHANNEL:
-          dstLine[x] = static_cast<uint8_t>((imgLine[x] >> 16) & 0xff);
-          break;
-        case GREEN_CHANNEL:
-          dstLine[x] = static_cast<uint8_t>((imgLine[x] >> 8) & 0xff);
-          break;
-        case BLUE_CHANNEL:
-          dstLine[x] = static_cast<uint8_t>(imgLine[x] & 0xff);
-          break;
+/**
+ * Bands of this many rows are processed concurrently.
+ */
+const int ROWS_PER_BAND = 128;
+
+/**
+ * Pixels are classified by the channels they are darker than the threshold in.
+ * The classes are numbered in the order their components get their labels:
+ * 1 for the pixels dark in all the channels, then the ones dark in red and green,
+ * red and blue, green and blue, only red, only green and only blue.
+ * Class 0 is for the pixels not dark in any channel.
+ */
+const int NUM_CLASSES = 8;
+
+/**
+ * The class of a pixel by a set of the channels it's dark in,
+ * the red one being the most significant bit.
+ */
+const uint8_t CLASS_BY_DARK_CHANNELS[8] = {0, 7, 6, 4, 5, 3, 2, 1};
+
+/**
+ * \brief Thresholds all the channels of the masked color image in one go.
+ *
+ * Each channel is thresholded at its Otsu threshold, with the given adjustment.
+ * The pixels outside of \p mask are taken as white.
+ *
+ * \return The classes of pixels, laid out like the padded data of a ConnectivityMap.
+ */
+std::vector<uint8_t> classifyPixels(const BinaryImage& mask,
+                                    const QImage& colorImage,
+                                    const int redThresholdAdjustment,
+                                    const int greenThresholdAdjustment,
+                                    const int blueThresholdAdjustment) {
+  const int width = colorImage.width();
+  const int height = colorImage.height();
+  const int stride = width + 2;
+
+  const auto* const imgData = reinterpret_cast<const uint32_t*>(colorImage.bits());
+  const int imgStride = colorImage.bytesPerLine() / sizeof(uint32_t);
+  const uint32_t* const maskData = mask.data();
+  const int maskStride = mask.wordsPerLine();
+  const uint32_t msb = uint32_t(1) << 31;
+
+  const auto maskedPixel = [&](const int x, const int y) -> uint32_t {
+    return (maskData[y * maskStride + (x >> 5)] & (msb >> (x & 31))) ? imgData[y * imgStride + x] : 0xffffffffu;
+  };
+
+  const int numBands = (height + ROWS_PER_BAND - 1) / ROWS_PER_BAND;
+  std::vector<int> bandHists(static_cast<size_t>(numBands) * 3 * 256, 0);
+  parallelFor(0, height, ROWS_PER_BAND, [&](const int fromY, const int toY) {
+    int* const redHist = &bandHists[static_cast<size_t>(fromY / ROWS_PER_BAND) * 3 * 256];
+    int* const greenHist = redHist + 256;
+    int* const blueHist = greenHist + 256;
+    for (int y = fromY; y < toY; ++y) {
+      for (int x = 0; x < width; ++x) {
+        const uint32_t color = maskedPixel(x, y);
+        ++redHist[qRed(color)];
+        ++greenHist[qGreen(color)];
+        ++blueHist[qBlue(color)];
+      }
+    }
+  });
+
+  GrayscaleHistogram hists[3];
+  for (int band = 0; band < numBands; ++band) {
+    const int* const bandHist = &bandHists[static_cast<size_t>(band) * 3 * 256];
+    for (int channel = 0; channel < 3; ++channel) {
+      for (int level = 0; level < 256; ++level) {
+        hists[channel][level] += bandHist[channel * 256 + level];
       }
     }
-    imgLine += imgStride;
-    dstLine += dstStride;
   }
-  return dst;
-}
-
-inline BinaryThreshold adjustThreshold(const BinaryThreshold threshold, const int adjustment) {
-  return qBound(1, int(threshold) + adjustment, 255);
+  const int redThreshold = adjustThreshold(BinaryThreshold::otsuThreshold(hists[0]), redThresholdAdjustment);
+  const int greenThreshold = adjustThreshold(BinaryThreshold::otsuThreshold(hists[1]), greenThresholdAdjustment);
+  const int blueThreshold = adjustThreshold(BinaryThreshold::otsuThreshold(hists[2]), blueThresholdAdjustment);
+
+  std::vector<uint8_t> classes(static_cast<size_t>(stride) * (height + 2), 0);
+  parallelFor(0, height, ROWS_PER_BAND, [&](const int fromY, const int toY) {
+    for (int y = fromY; y < toY; ++y) {
+      uint8_t* const classLine = &classes[static_cast<size_t>(y + 1) * stride + 1];
+      for (int x = 0; x < width; ++x) {
+        const uint32_t color = maskedPixel(x, y);
+        const int darkChannels = ((qRed(color) < redThreshold) << 2) | ((qGreen(color) < greenThreshold) << 1)
+                                 | (qBlue(color) < blueThreshold);
+        classLine[x] = CLASS_BY_DARK_CHANNELS[darkChannels];
+      }
+    }
+  });
+  return classes;
 }
 
-void reduceNoise(ConnectivityMap& segmentsMap, const Dpi& dpi, const int noiseThreshold) {
-  const ComponentCleaner componentCleaner(dpi, noiseThreshold);
-  std::vector<Component> components(segmentsMap.maxLabel() + 1);
-  std::vector<BoundingBox> boundingBoxes(segmentsMap.maxLabel() + 1);
+/**
+ * \brief Labels the 8-connected components of each class of pixels.
+ *
+ * The labels are the same ConnectivityMap would give the components of each class,
+ * with the components of the following classes added by addComponents() in turn.
+ * That is, they are ordered by class and then by their first pixel in raster order.
+ *
+ * The bands of the image are labeled concurrently by union-find, with the roots
+ * of the sets being their first pixels, and stitched together afterwards.
+ * The sizes and the bounding boxes of the components are collected along the way.
+ */
+ConnectivityMap labelClasses(const std::vector<uint8_t>& classes,
+                             const QSize& size,
+                             std::vector<Component>& components,
+                             std::vector<BoundingBox>& boundingBoxes) {
+  ConnectivityMap segmentsMap(size);
+  if (size.isEmpty()) {
+    return segmentsMap;
+  }
 
-  const QSize size = segmentsMap.size();
   const int width = size.width();
   const int height = size.height();
+  const int stride = segmentsMap.stride();
+  assert(classes.size() == static_cast<size_t>(stride) * (height + 2));
+
+  // Until the labels are assigned, the map holds the parent of each pixel, as its index
+  // into the padded data.  Parents always precede their children in raster order.
+  uint32_t* const map = segmentsMap.paddedData();
+  const auto findRoot = [map](uint32_t idx) {
+    while (map[idx] != idx) {
+      map[idx] = map[map[idx]];
+      idx = map[idx];
+    }
+    return idx;
+  };
+  const auto unite = [map, &findRoot](const uint32_t idx1, const uint32_t idx2) {
+    const uint32_t root1 = findRoot(idx1);
+    const uint32_t root2 = findRoot(idx2);
+    if (root1 < root2) {
+      map[root2] = root1;
+    } else {
+      map[root1] = root2;
+    }
+  };
+  const auto uniteWithLineAbove = [&](const uint32_t idx, const uint8_t cls) {
+    for (const uint32_t neighbour : {idx - stride - 1, idx - stride, idx - stride + 1}) {
+      if (classes[neighbour] == cls) {
+        unite(idx, neighbour);
+      }
+    }
+  };
+
+  parallelFor(0, height, ROWS_PER_BAND, [&](const int fromY, const int toY) {
+    for (int y = fromY; y < toY; ++y) {
+      auto idx = static_cast<uint32_t>((y + 1) * stride + 1);
+      for (int x = 0; x < width; ++x, ++idx) {
+        const uint8_t cls = classes[idx];
+        if (cls == 0) {
+          continue;
+        }
+        map[idx] = idx;
+        if (classes[idx - 1] == cls) {
+          unite(idx, idx - 1);
+        }
+        if (y > fromY) {
+          uniteWithLineAbove(idx, cls);
+        }
+      }
+    }
+  });
+
+  for (int y = ROWS_PER_BAND; y < height; y += ROWS_PER_BAND) {
+    auto idx = static_cast<uint32_t>((y + 1) * stride + 1);
+    for (int x = 0; x < width; ++x, ++idx) {
+      const uint8_t cls = classes[idx];
+      if (cls != 0) {
+        uniteWithLineAbove(idx, cls);
+      }
+    }
+  }
 
-  // Count the number of pixels and the bounding rect of each component.
-  const uint32_t* mapLine = segmentsMap.data();
-  const int mapStride = segmentsMap.stride();
+  // Count the components of each class, to know where their labels start.
+  const int numBands = (height + ROWS_PER_BAND - 1) / ROWS_PER_BAND;
+  std::vector<uint32_t> bandRoots(static_cast<size_t>(numBands) * NUM_CLASSES, 0);
+  parallelFor(0, height, ROWS_PER_BAND, [&](const int fromY, const int toY) {
+    uint32_t* const roots = &bandRoots[(fromY / ROWS_PER_BAND) * NUM_CLASSES];
+    for (int y = fromY; y < toY; ++y) {
+      auto idx = static_cast<uint32_t>((y + 1) * stride + 1);
+      for (int x = 0; x < width; ++x, ++idx) {
+        if ((classes[idx] != 0) && (map[idx] == idx)) {
+          ++roots[classes[idx]];
+        }
+      }
+    }
+  });
+
+  uint32_t nextLabel[NUM_CLASSES];
+  uint32_t maxLabel = 0;
+  for (int cls = 1; cls < NUM_CLASSES; ++cls) {
+    nextLabel[cls] = maxLabel + 1;
+    for (int band = 0; band < numBands; ++band) {
+      maxLabel += bandRoots[band * NUM_CLASSES + cls];
+    }
+  }
+
+  components.assign(maxLabel + 1, Component());
+  boundingBoxes.assign(maxLabel + 1, BoundingBox());
+
+  // Going in raster order, the parent of a pixel is always labeled already.
   for (int y = 0; y < height; ++y) {
-    for (int x = 0; x < width; ++x) {
-      const uint32_t label = mapLine[x];
+    auto idx = static_cast<uint32_t>((y + 1) * stride + 1);
+    for (int x = 0; x < width; ++x, ++idx) {
+      const uint8_t cls = classes[idx];
+      if (cls == 0) {
+        continue;
+      }
+      const uint32_t parent = map[idx];
+      const uint32_t label = (parent == idx) ? nextLabel[cls]++ : map[parent];
+      map[idx] = label;
       ++components[label].size;
       boundingBoxes[label].extend(x, y);
     }
-    mapLine += mapStride;
   }
 
+  segmentsMap.setMaxLabel(maxLabel);
+  return segmentsMap;
+}  // labelClasses
+
+void reduceNoise(ConnectivityMap& segmentsMap,
+                 const std::vector<Component>& components,
+                 const std::vector<BoundingBox>& boundingBoxes,
+                 const Dpi& dpi,
+                 const int noiseThreshold) {
+  const ComponentCleaner componentCleaner(dpi, noiseThreshold);
+
   // creating set of labels determining components to be removed
   std::unordered_set<uint32_t> labels;
   for (uint32_t label = 1; label <= segmentsMap.maxLabel(); ++label) {
@@ -171,19 +345,6 @@ void reduceNoise(ConnectivityMap& segmentsMap, const Dpi& dpi, const int noiseTh
   segmentsMap.removeComponents(labels);
 }
 
-QImage prepareToMap(const QImage& colorImage, const BinaryImage& image) {
-  QImage dst = colorImage;
-  applyMask(dst, image);
-  return dst;
-}
-
-BinaryImage componentFromChannel(const QImage& colorImage, const RgbChannel channel, const int adjustment) {
-  GrayImage channelImage = extractRgbChannel(colorImage, channel);
-  BinaryThreshold threshold = BinaryThreshold::otsuThreshold(channelImage);
-  BinaryImage component = BinaryImage(channelImage, adjustThreshold(threshold, adjustment));
-  return component;
-}
-
 ConnectivityMap buildMapFromRgb(const BinaryImage& image,
                                 const QImage& colorImage,
                                 const Dpi& dpi,
@@ -191,45 +352,13 @@ ConnectivityMap buildMapFromRgb(const BinaryImage& image,
                                 const int redThresholdAdjustment,
                                 const int greenThresholdAdjustment,
                                 const int blueThresholdAdjustment) {
-  QImage imageToMap = prepareToMap(colorImage, image);
-
-  BinaryImage redComponent = componentFromChannel(imageToMap, RED_CHANNEL, redThresholdAdjustment);
-  BinaryImage greenComponent = componentFromChannel(imageToMap, GREEN_CHANNEL, greenThresholdAdjustment);
-  BinaryImage blueComponent = componentFromChannel(imageToMap, BLUE_CHANNEL, blueThresholdAdjustment);
-
-  BinaryImage yellowComponent(redComponent);
-  rasterOp<RopAnd<RopSrc, RopDst>>(yellowComponent, greenComponent);
-  BinaryImage magentaComponent(redComponent);
-  rasterOp<RopAnd<RopSrc, RopDst>>(magentaComponent, blueComponent);
-  BinaryImage cyanComponent(greenComponent);
-  rasterOp<RopAnd<RopSrc, RopDst>>(cyanComponent, blueComponent);
-
-  BinaryImage blackComponent(blueComponent);
-  rasterOp<RopAnd<RopSrc, RopDst>>(blackComponent, yellowComponent);
-
-  rasterOp<RopSubtract<RopDst, RopSrc>>(redComponent, blackComponent);
-  rasterOp<RopSubtract<RopDst, RopSrc>>(greenComponent, blackComponent);
-  rasterOp<RopSubtract<RopDst, RopSrc>>(blueComponent, blackComponent);
-  rasterOp<RopSubtract<RopDst, RopSrc>>(yellowComponent, blackComponent);
-  rasterOp<RopSubtract<RopDst, RopSrc>>(magentaComponent, blackComponent);
-  rasterOp<RopSubtract<RopDst, RopSrc>>(cyanComponent, blackComponent);
-
-  rasterOp<RopSubtract<RopDst, RopSrc>>(redComponent, yellowComponent);
-  rasterOp<RopSubtract<RopDst, RopSrc>>(redComponent, magentaComponent);
-  rasterOp<RopSubtract<RopDst, RopSrc>>(greenComponent, yellowComponent);
-  rasterOp<RopSubtract<RopDst, RopSrc>>(greenComponent, cyanComponent);
-  rasterOp<RopSubtract<RopDst, RopSrc>>(blueComponent, magentaComponent);
-  rasterOp<RopSubtract<RopDst, RopSrc>>(blueComponent, cyanComponent);
-
-  ConnectivityMap segmentsMap = ConnectivityMap(blackComponent, CONN8);
-  segmentsMap.addComponents(yellowComponent, CONN8);
-  segmentsMap.addComponents(magentaComponent, CONN8);
-  segmentsMap.addComponents(cyanComponent, CONN8);
-  segmentsMap.addComponents(redComponent, CONN8);
-  segmentsMap.addComponents(greenComponent, CONN8);
-  segmentsMap.addComponents(blueComponent, CONN8);
-
-  reduceNoise(segmentsMap, dpi, noiseThreshold);
+  std::vector<Component> components;
+  std::vector<BoundingBox> boundingBoxes;
+  ConnectivityMap segmentsMap = labelClasses(
+      classifyPixels(image, colorImage, redThresholdAdjustment, greenThresholdAdjustment, blueThresholdAdjustment),
+      colorImage.size(), components, boundingBoxes);
+
+  reduceNoise(segmentsMap, components, boundingBoxes, dpi, noiseThreshold);
 
   // Extend the map to cover unlabeled components.
   segmentsMap = InfluenceMap(segmentsMap, image);
@@ -253,6 +382,8 @@ class ComponentColor {
     ++m_size;
   }
 
+  inline bool isEmpty() const { return m_size == 0; }
+
   inline uint32_t getColor() {
     const auto sizeF = static_cast<long double>(m_size);
     return qRgb(getAverage(m_red, m_size), getAverage(m_green, m_size), getAverage(m_blue, m_size));
@@ -299,26 +430,31 @@ QImage buildRgbImage(const ConnectivityMap& segmentsMap, const QImage& colorImag
     }
   }
 
+  // Unlabeled pixels become white.
+  std::vector<uint32_t> labelColors(segmentsMap.maxLabel() + 1, 0xffffffffu);
+  for (uint32_t label = 1; label <= segmentsMap.maxLabel(); ++label) {
+    if (!compColorMap[label].isEmpty()) {
+      labelColors[label] = compColorMap[label].getColor();
+    }
+  }
+
   QImage dst(colorImage.size(), QImage::Format_RGB32);
-  dst.fill(Qt::white);
 
-  auto* dstLine = reinterpret_cast<uint32_t*>(dst.bits());
+  auto* const dstData = reinterpret_cast<uint32_t*>(dst.bits());
   const int dstStride = dst.bytesPerLine() / sizeof(uint32_t);
 
-  const uint32_t* mapLine = segmentsMap.data();
+  const uint32_t* const mapData = segmentsMap.data();
   const int mapStride = segmentsMap.stride();
 
-  for (int y = 0; y < height; ++y) {
-    for (int x = 0; x < width; ++x) {
-      const uint32_t label = mapLine[x];
-      if (label == 0) {
-        continue;
+  parallelFor(0, height, ROWS_PER_BAND, [&](const int fromY, const int toY) {
+    for (int y = fromY; y < toY; ++y) {
+      const uint32_t* const mapLine = mapData + y * mapStride;
+      uint32_t* const dstLine = dstData + y * dstStride;
+      for (int x = 0; x < width; ++x) {
+        dstLine[x] = labelColors[mapLine[x]];
       }
-      dstLine[x] = compColorMap[label].getColor();
     }
-    mapLine += mapStride;
-    dstLine += dstStride;
-  }
+  });
   return dst;
 }
 
@@ -10,6 +10,7 @@
 #include <cstring>
 #include <iterator>
 
+#include "CancellationPoint.h"
 #include "ValueConv.h"
 
 namespace imageproc {
@@ -125,6 +126,7 @@ void gaussBlurGeneric(const QSize size,
   // Vertical pass.
   gauss_blur_impl::findIirConstants(nP, nM, dP, dM, bdP, bdM, vSigma);
   for (int x = 0; x < width; ++x) {
+    CancellationPoint::poll();
     memset(&valP[0], 0, height * sizeof(valP[0]));
     memset(&valM[0], 0, height * sizeof(valM[0]));
 
@@ -161,6 +163,7 @@ void gaussBlurGeneric(const QSize size,
   const float* intermediateLine = &intermediateImage[0];
   DstIt outputLine(output);
   for (int y = 0; y < height; ++y) {
+    CancellationPoint::poll();
     memset(&valP[0], 0, width * sizeof(valP[0]));
     memset(&valM[0], 0, width * sizeof(valM[0]));
 
@@ -0,0 +1,304 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#include "HitMissReplacer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "BinaryImage.h"
+#include "CancellationPoint.h"
+
+namespace imageproc {
+namespace {
+/**
+ * The amount of image data, in bytes, to run all the steps over before moving on.
+ * A band should stay in L2 cache while it's being processed.
+ */
+const int BAND_BYTES = 256 * 1024;
+
+/**
+ * Returns the 32 pixels starting bitShift pixels into the word pointed to.
+ * Works for a bitShift of 0 too, without branching.
+ */
+inline uint32_t shiftedWord(const uint32_t* const word, const int bitShift) {
+  return (word[0] << bitShift) | ((word[1] >> 1) >> (31 - bitShift));
+}
+}  // namespace
+
+HitMissReplacer::Cell::Cell(const int dx, const int dy, const uint32_t invert)
+    : dy(dy), wordOffset(dx >= 0 ? dx / 32 : -((31 - dx) / 32)), bitShift(dx - wordOffset * 32), invert(invert) {}
+
+HitMissReplacer::HitMissReplacer(const BWColor srcSurroundings) : m_srcSurroundings(srcSurroundings), m_guardWords(1) {}
+
+void HitMissReplacer::add(const char* const pattern, const int patternWidth, const int patternHeight) {
+  // The origin has to be chosen exactly as hitMissReplaceInPlace() does,
+  // as it decides which partially outside-of-image matches are found.
+  const int patternLen = patternWidth * patternHeight;
+  const auto* const minusPos = (const char*) memchr(pattern, '-', patternLen);
+  const auto* const plusPos = (const char*) memchr(pattern, '+', patternLen);
+  const char* originPos;
+  if (minusPos && plusPos) {
+    originPos = std::min(minusPos, plusPos);
+  } else if (minusPos) {
+    originPos = minusPos;
+  } else if (plusPos) {
+    originPos = plusPos;
+  } else {
+    // No replacements requested - nothing to do.
+    return;
+  }
+
+  const auto originX = static_cast<int>((originPos - pattern) % patternWidth);
+  const auto originY = static_cast<int>((originPos - pattern) / patternWidth);
+
+  Step step;
+  std::vector<Cell> hits;
+  std::vector<Cell> misses;
+
+  const char* p = pattern;
+  for (int y = 0; y < patternHeight; ++y) {
+    for (int x = 0; x < patternWidth; ++x, ++p) {
+      const int dx = x - originX;
+      const int dy = y - originY;
+      switch (*p) {
+        case '-':
+          step.blackToWhite.emplace_back(-dx, -dy, 0);
+          // fall through
+        case 'X':
+          hits.emplace_back(dx, dy, 0);
+          break;
+        case '+':
+          step.whiteToBlack.emplace_back(-dx, -dy, 0);
+          // fall through
+        case ' ':
+          misses.emplace_back(dx, dy, ~uint32_t(0));
+          break;
+        case '?':
+          break;
+        default:
+          throw std::invalid_argument("HitMissReplacer: invalid character in pattern");
+      }
+    }
+  }
+
+  // Alternating between hits and misses rules out positions in both
+  // black and white areas after checking just a couple of cells.
+  for (size_t i = 0; i < std::max(hits.size(), misses.size()); ++i) {
+    if (i < hits.size()) {
+      step.matchCells.push_back(hits[i]);
+    }
+    if (i < misses.size()) {
+      step.matchCells.push_back(misses[i]);
+    }
+  }
+
+  for (const Cell& cell : step.matchCells) {
+    updateGuardWords(cell);
+  }
+  for (const std::vector<Cell>* replacements : {&step.whiteToBlack, &step.blackToWhite}) {
+    for (const Cell& replacement : *replacements) {
+      updateGuardWords(replacement);
+      step.matchesAbove = std::max(step.matchesAbove, -replacement.dy);
+      step.matchesBelow = std::max(step.matchesBelow, replacement.dy);
+      for (const Cell& cell : step.matchCells) {
+        step.rowsAbove = std::max(step.rowsAbove, -(replacement.dy + cell.dy));
+        step.rowsBelow = std::max(step.rowsBelow, replacement.dy + cell.dy);
+      }
+    }
+  }
+  m_steps.push_back(std::move(step));
+}  // HitMissReplacer::add
+
+void HitMissReplacer::addAllDirections(const char* const pattern, const int patternWidth, const int patternHeight) {
+  add(pattern, patternWidth, patternHeight);
+
+  std::vector<char> newPattern(static_cast<size_t>(patternWidth * patternHeight), ' ');
+
+  // Rotate 90 degrees clockwise.
+  const char* p = pattern;
+  int newWidth = patternHeight;
+  int newHeight = patternWidth;
+  for (int y = 0; y < patternHeight; ++y) {
+    for (int x = 0; x < patternWidth; ++x, ++p) {
+      const int newX = patternHeight - 1 - y;
+      const int newY = x;
+      newPattern[newY * newWidth + newX] = *p;
+    }
+  }
+  add(newPattern.data(), newWidth, newHeight);
+
+  // Rotate upside down.
+  p = pattern;
+  newWidth = patternWidth;
+  newHeight = patternHeight;
+  for (int y = 0; y < patternHeight; ++y) {
+    for (int x = 0; x < patternWidth; ++x, ++p) {
+      const int newX = patternWidth - 1 - x;
+      const int newY = patternHeight - 1 - y;
+      newPattern[newY * newWidth + newX] = *p;
+    }
+  }
+  add(newPattern.data(), newWidth, newHeight);
+
+  // Rotate 90 degrees counter-clockwise.
+  p = pattern;
+  newWidth = patternHeight;
+  newHeight = patternWidth;
+  for (int y = 0; y < patternHeight; ++y) {
+    for (int x = 0; x < patternWidth; ++x, ++p) {
+      const int newX = y;
+      const int newY = patternWidth - 1 - x;
+      newPattern[newY * newWidth + newX] = *p;
+    }
+  }
+  add(newPattern.data(), newWidth, newHeight);
+}  // HitMissReplacer::addAllDirections
+
+void HitMissReplacer::updateGuardWords(const Cell& cell) {
+  // shiftedWord() reads the word at wordOffset and the one following it.
+  m_guardWords = std::max({m_guardWords, -cell.wordOffset, cell.wordOffset + 1});
+}
+
+void HitMissReplacer::apply(BinaryImage& img) const {
+  if (img.isNull() || m_steps.empty()) {
+    return;
+  }
+
+  const int width = img.width();
+  const int height = img.height();
+  const int imgWpl = img.wordsPerLine();
+  const int words = (width + 31) / 32;
+  const int lastWordIdx = words - 1;
+  const uint32_t lastWordMask = ~uint32_t(0) << (31 - (width - 1) % 32);
+  const uint32_t outside = (m_srcSurroundings == BLACK) ? ~uint32_t(0) : 0;
+
+  // Band rows are padded with guard words on both sides, so that shifted reads
+  // never go out of bounds.  Guard words and the padding bits of the last word
+  // always hold the surroundings color.
+  const int guard = m_guardWords;
+  const int stride = words + 2 * guard;
+
+  // A step may only be relied upon for rows it had correct input for.  Going
+  // backwards from the last step, marginsAbove[i] and marginsBelow[i] are how
+  // many rows around the band step i has to get right, and haloAbove and haloBelow
+  // are what the first step needs as input.
+  const auto numSteps = static_cast<int>(m_steps.size());
+  std::vector<int> marginsAbove(numSteps);
+  std::vector<int> marginsBelow(numSteps);
+  int haloAbove = 0;
+  int haloBelow = 0;
+  for (int i = numSteps - 1; i >= 0; --i) {
+    marginsAbove[i] = haloAbove;
+    marginsBelow[i] = haloBelow;
+    haloAbove += m_steps[i].rowsAbove;
+    haloBelow += m_steps[i].rowsBelow;
+  }
+  const int halo = haloAbove + haloBelow;
+
+  const int bandHeight = std::max({1, halo, BAND_BYTES / (stride * 4) - halo});
+  const int bufferRows = std::min(height, bandHeight + halo);
+  std::vector<uint32_t> band(static_cast<size_t>(bufferRows * stride), outside);
+  std::vector<uint32_t> matches(static_cast<size_t>(bufferRows * stride), 0);
+  std::vector<uint32_t> carry(static_cast<size_t>(std::min(height, haloAbove) * stride));
+  const std::vector<uint32_t> outsideLine(static_cast<size_t>(stride), outside);
+  std::vector<char> hasMatches(static_cast<size_t>(bufferRows));
+  std::vector<const uint32_t*> cellLines;
+  for (const Step& step : m_steps) {
+    cellLines.resize(std::max(cellLines.size(), step.matchCells.size()));
+  }
+
+  uint32_t* const data = img.data();
+  for (int y0 = 0; y0 < height; y0 += bandHeight) {
+    CancellationPoint::poll();
+
+    const int y1 = std::min(height, y0 + bandHeight);
+    const int top = std::max(0, y0 - haloAbove);
+    const int bottom = std::min(height, y1 + haloBelow);
+
+    // The rows above y0 have been written back already,
+    // so their original versions come from the carry buffer.
+    std::copy(carry.begin(), carry.begin() + (y0 - top) * stride, band.begin());
+    for (int y = y0; y < bottom; ++y) {
+      const uint32_t* const srcLine = data + y * imgWpl;
+      uint32_t* const bandLine = &band[(y - top) * stride] + guard;
+      std::copy(srcLine, srcLine + words, bandLine);
+      bandLine[lastWordIdx] = (bandLine[lastWordIdx] & lastWordMask) | (outside & ~lastWordMask);
+    }
+
+    const int nextTop = std::max(0, y1 - haloAbove);
+    std::copy(band.begin() + (nextTop - top) * stride, band.begin() + (y1 - top) * stride, carry.begin());
+
+    const auto bandRow = [&](const int y) -> const uint32_t* {
+      return ((y >= top) && (y < bottom)) ? &band[(y - top) * stride] + guard : outsideLine.data() + guard;
+    };
+
+    for (int i = 0; i < numSteps; ++i) {
+      const Step& step = m_steps[i];
+      const int lo = std::max(top, y0 - marginsAbove[i]);
+      const int hi = std::min(bottom, y1 + marginsBelow[i]);
+      const int matchesLo = std::max(top, lo - step.matchesAbove);
+      const int matchesHi = std::min(bottom, hi + step.matchesBelow);
+
+      for (int y = matchesLo; y < matchesHi; ++y) {
+        for (size_t c = 0; c < step.matchCells.size(); ++c) {
+          cellLines[c] = bandRow(y + step.matchCells[c].dy) + step.matchCells[c].wordOffset;
+        }
+
+        uint32_t* const matchesLine = &matches[(y - top) * stride] + guard;
+        uint32_t anyMatches = 0;
+        for (int w = 0; w < words; ++w) {
+          // Patterns only match at positions inside the image.
+          uint32_t match = (w == lastWordIdx) ? lastWordMask : ~uint32_t(0);
+          // Most positions are ruled out by the first few cells.
+          for (size_t c = 0; match && c < step.matchCells.size(); ++c) {
+            match &= shiftedWord(cellLines[c] + w, step.matchCells[c].bitShift) ^ step.matchCells[c].invert;
+          }
+          matchesLine[w] = match;
+          anyMatches |= match;
+        }
+        hasMatches[y - top] = (anyMatches != 0);
+      }
+
+      const auto matchesRow = [&](const int y) -> const uint32_t* {
+        return ((y >= matchesLo) && (y < matchesHi) && hasMatches[y - top]) ? &matches[(y - top) * stride] + guard
+                                                                             : nullptr;
+      };
+
+      for (int y = lo; y < hi; ++y) {
+        uint32_t* const line = &band[(y - top) * stride] + guard;
+        for (const Cell& cell : step.whiteToBlack) {
+          const uint32_t* src = matchesRow(y + cell.dy);
+          if (!src) {
+            continue;
+          }
+          src += cell.wordOffset;
+          for (int w = 0; w < words; ++w) {
+            line[w] |= shiftedWord(src + w, cell.bitShift);
+          }
+        }
+        for (const Cell& cell : step.blackToWhite) {
+          const uint32_t* src = matchesRow(y + cell.dy);
+          if (!src) {
+            continue;
+          }
+          src += cell.wordOffset;
+          for (int w = 0; w < words; ++w) {
+            line[w] &= ~shiftedWord(src + w, cell.bitShift);
+          }
+        }
+        line[lastWordIdx] = (line[lastWordIdx] & lastWordMask) | (outside & ~lastWordMask);
+      }
+    }
+
+    for (int y = y0; y < y1; ++y) {
+      const uint32_t* const bandLine = &band[(y - top) * stride] + guard;
+      uint32_t* const dstLine = data + y * imgWpl;
+      std::copy(bandLine, bandLine + lastWordIdx, dstLine);
+      // Leave the padding bits as they were.
+      dstLine[lastWordIdx] = (dstLine[lastWordIdx] & ~lastWordMask) | (bandLine[lastWordIdx] & lastWordMask);
+    }
+  }
+}  // HitMissReplacer::apply
+}  // namespace imageproc
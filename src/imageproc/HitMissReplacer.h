@@ -0,0 +1,100 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#ifndef SCANTAILOR_IMAGEPROC_HITMISSREPLACER_H_
+#define SCANTAILOR_IMAGEPROC_HITMISSREPLACER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "BWColor.h"
+
+namespace imageproc {
+class BinaryImage;
+
+/**
+ * \brief A sequence of hit-miss replacements compiled into a single operation.
+ *
+ * Applying it gives exactly the same result as calling hitMissReplaceInPlace()
+ * for each of the added patterns in turn.  That function makes a few full image
+ * passes per pattern cell, so a sequence of patterns ends up going over the image
+ * hundreds of times.  Here every pattern is compiled into a table of word-parallel
+ * shifts, and the whole sequence is run over one horizontal band of the image
+ * at a time, while that band is still in cache.
+ */
+class HitMissReplacer {
+ public:
+  /**
+   * \param srcSurroundings The color that is assumed to be outside of the image.
+   */
+  explicit HitMissReplacer(BWColor srcSurroundings = WHITE);
+
+  /**
+   * \brief Appends a pattern to the sequence.
+   *
+   * \param pattern A pattern in the format hitMissReplaceInPlace() accepts.
+   * \param patternWidth The width of the pattern.
+   * \param patternHeight The height of the pattern.
+   */
+  void add(const char* pattern, int patternWidth, int patternHeight);
+
+  /**
+   * \brief Appends a pattern followed by its versions rotated 90 degrees clockwise,
+   *        upside down and 90 degrees counter-clockwise.
+   */
+  void addAllDirections(const char* pattern, int patternWidth, int patternHeight);
+
+  /**
+   * \brief Applies the sequence of replacements to an image.
+   */
+  void apply(BinaryImage& img) const;
+
+ private:
+  /**
+   * A pixel a pattern looks at or modifies, relative to the pixel being processed.
+   * The horizontal offset is split into a whole number of words and a bit shift.
+   */
+  struct Cell {
+    int dy;
+    int wordOffset;
+    int bitShift;
+    uint32_t invert;  // ~0 for misses, 0 otherwise.
+
+    Cell(int dx, int dy, uint32_t invert);
+  };
+
+  struct Step {
+    /**
+     * The hits and misses, relative to the pattern origin.
+     */
+    std::vector<Cell> matchCells;
+
+    /**
+     * Positions of the pattern origin relative to the pixels turned black
+     * and turned white respectively.  That is, where to look for matches
+     * when deciding the fate of a pixel.
+     */
+    std::vector<Cell> whiteToBlack;
+    std::vector<Cell> blackToWhite;
+
+    /**
+     * How many rows above and below a pixel may influence its fate.
+     */
+    int rowsAbove = 0;
+    int rowsBelow = 0;
+
+    /**
+     * How many rows above and below a pixel to look for matches at.
+     */
+    int matchesAbove = 0;
+    int matchesBelow = 0;
+  };
+
+  void updateGuardWords(const Cell& cell);
+
+  std::vector<Step> m_steps;
+  BWColor m_srcSurroundings;
+  int m_guardWords;
+};
+}  // namespace imageproc
+#endif  // ifndef SCANTAILOR_IMAGEPROC_HITMISSREPLACER_H_
@@ -392,6 +392,8 @@ BinaryImage hitMissReplace(const BinaryImage& src,
  * '?': Any pixel, we don't care which.\n
  * \param patternWidth The width of the pattern.
  * \param patternHeight The height of the pattern.
+ *
+ * \see HitMissReplacer for applying a sequence of patterns.
  */
 void hitMissReplaceInPlace(BinaryImage& img,
                            BWColor srcSurroundings,
@@ -11,17 +11,25 @@
 #include <cmath>
 #include <cstdint>
 #include <stdexcept>
+#include <vector>
 
-#include "AlignedArray.h"
 #include "BinaryImage.h"
 #include "BitOps.h"
 #include "GrayImage.h"
 #include "Grayscale.h"
 #include "MatT.h"
 #include "MatrixCalc.h"
+#include "ParallelFor.h"
 #include "VecT.h"
 
 namespace imageproc {
+namespace {
+/**
+ * Rows are processed in bands of that many rows, concurrently.
+ */
+const int ROWS_PER_BAND = 32;
+}  // namespace
+
 PolynomialSurface::PolynomialSurface(const int horDegree, const int vertDegree, const GrayImage& src)
     : m_horDegree(horDegree), m_vertDegree(vertDegree) {
   // Note: m_horDegree and m_vertDegree may still change!
@@ -51,7 +59,7 @@ PolynomialSurface::PolynomialSurface(const int horDegree, const int vertDegree,
   // This allows us not to build matrix A at all.
   MatT<double> AtA(numTerms, numTerms);
   VecT<double> Atb(numTerms);
-  prepareDataForLeastSquares(src, AtA, Atb, m_horDegree, m_vertDegree);
+  prepareDataForLeastSquares(src, nullptr, AtA, Atb, m_horDegree, m_vertDegree);
 
   fixSquareMatrixRankDeficiency(AtA);
 
@@ -97,7 +105,7 @@ PolynomialSurface::PolynomialSurface(const int horDegree,
   // This allows us not to build matrix A at all.
   MatT<double> AtA(numTerms, numTerms);
   VecT<double> Atb(numTerms);
-  prepareDataForLeastSquares(src, mask, AtA, Atb, m_horDegree, m_vertDegree);
+  prepareDataForLeastSquares(src, &mask, AtA, Atb, m_horDegree, m_vertDegree);
 
   fixSquareMatrixRankDeficiency(AtA);
 
@@ -116,54 +124,54 @@ GrayImage PolynomialSurface::render(const QSize& size) const {
   GrayImage image(size);
   const int width = size.width();
   const int height = size.height();
-  unsigned char* line = image.data();
+  uint8_t* const data = image.data();
   const int bpl = image.stride();
-  const auto numCoeffs = static_cast<int>(m_coeffs.size());
 
   // Pretend that both x and y positions of pixels
   // lie in range of [0, 1].
   const double xscale = calcScale(width);
   const double yscale = calcScale(height);
 
-  AlignedArray<float, 4> vertMatrix(numCoeffs * height);
-  float* out = &vertMatrix[0];
-  for (int y = 0; y < height; ++y) {
-    const double yAdjusted = y * yscale;
-    double pow = 1.0;
-    int pos = 0;
-    for (int i = 0; i <= m_vertDegree; ++i) {
-      for (int j = 0; j <= m_horDegree; ++j, ++pos, ++out) {
-        *out = static_cast<float>(m_coeffs[pos] * pow);
-      }
-      pow *= yAdjusted;
-    }
+  std::vector<double> xs(width);
+  for (int x = 0; x < width; ++x) {
+    xs[x] = x * xscale;
   }
 
-  AlignedArray<float, 4> horMatrix(numCoeffs * width);
-  out = &horMatrix[0];
-  for (int x = 0; x < width; ++x) {
-    const double xAdjusted = x * xscale;
-    for (int i = 0; i <= m_vertDegree; ++i) {
+  // Along a row, the surface is a polynomial of x, with coefficients being
+  // polynomials of y.  Those are evaluated once per row, and then the whole
+  // row is evaluated by Horner's scheme, one coefficient at a time, so that
+  // the loops over x vectorize.
+  parallelFor(0, height, ROWS_PER_BAND, [&](const int fromY, const int toY) {
+    std::vector<double> rowCoeffs(m_horDegree + 1);
+    std::vector<double> values(width);
+
+    for (int y = fromY; y < toY; ++y) {
+      const double yAdjusted = y * yscale;
+      std::fill(rowCoeffs.begin(), rowCoeffs.end(), 0.0);
       double pow = 1.0;
-      for (int j = 0; j <= m_horDegree; ++j, ++out) {
-        *out = static_cast<float>(pow);
-        pow *= xAdjusted;
+      int pos = 0;
+      for (int i = 0; i <= m_vertDegree; ++i) {
+        for (int j = 0; j <= m_horDegree; ++j, ++pos) {
+          rowCoeffs[j] += m_coeffs[pos] * pow;
+        }
+        pow *= yAdjusted;
       }
-    }
-  }
 
-  const float* vertLine = &vertMatrix[0];
-  for (int y = 0; y < height; ++y, line += bpl, vertLine += numCoeffs) {
-    const float* horLine = &horMatrix[0];
-    for (int x = 0; x < width; ++x, horLine += numCoeffs) {
-      float sum = 0.5f / 255.0f;  // for rounding purposes.
-      for (int i = 0; i < numCoeffs; ++i) {
-        sum += horLine[i] * vertLine[i];
+      std::fill(values.begin(), values.end(), rowCoeffs[m_horDegree]);
+      for (int j = m_horDegree - 1; j >= 0; --j) {
+        const double coeff = rowCoeffs[j];
+        for (int x = 0; x < width; ++x) {
+          values[x] = values[x] * xs[x] + coeff;
+        }
+      }
+
+      uint8_t* const line = data + y * bpl;
+      for (int x = 0; x < width; ++x) {
+        const auto isum = static_cast<int>(values[x] * 255.0 + 0.5);
+        line[x] = static_cast<uint8_t>(qBound(0, isum, 255));
       }
-      const auto isum = (int) (sum * 255.0);
-      line[x] = static_cast<unsigned char>(qBound(0, isum, 255));
     }
-  }
+  });
   return image;
 }  // PolynomialSurface::render
 
@@ -192,20 +200,15 @@ double PolynomialSurface::calcScale(const int dimension) {
 }
 
 void PolynomialSurface::prepareDataForLeastSquares(const GrayImage& image,
+                                                   const BinaryImage* const mask,
                                                    MatT<double>& AtA,
                                                    VecT<double>& Atb,
                                                    const int hDegree,
                                                    const int vDegree) {
-  double* const AtA_data = AtA.data();
-  double* const Atb_data = Atb.data();
-
   const int width = image.width();
   const int height = image.height();
   const auto numTerms = static_cast<int>(Atb.size());
 
-  const uint8_t* line = image.data();
-  const int stride = image.stride();
-
   // Pretend that both x and y positions of pixels
   // lie in range of [0, 1].
   const double xscale = calcScale(width);
@@ -214,140 +217,97 @@ void PolynomialSurface::prepareDataForLeastSquares(const GrayImage& image,
   // To force data samples into [0, 1] range.
   const double dataScale = 1.0 / 255.0;
 
-  // 1, y, y^2, y^3, ...
-  VecT<double> yPowers(vDegree + 1);  // Initialized to 0.
-
-  // Same as yPowers, except yPowers correspond to a given y,
-  // while xPowers are computed for all possible x values.
-  MatT<double> xPowers(hDegree + 1, width);  // Initialized to 0.
+  // The element of A^T*A corresponding to terms x^j1*y^i1 and x^j2*y^i2
+  // is the sum of x^(j1+j2)*y^(i1+i2) over all data points.  So rather than
+  // adding numTerms^2 products per data point, we sum up the first 2*hDegree+1
+  // powers of x in each row, and then multiply those sums by powers of y.
+  // A^T*b is built the same way, from sums of data points times powers of x.
+  const int numXPowers = 2 * hDegree + 1;
+  const int numYPowers = 2 * vDegree + 1;
+  const int numPowerSums = numXPowers * numYPowers;
+
+  // 1, x, x^2, x^3, ... for all possible x values.
+  std::vector<double> xPowers(numXPowers * width);
   for (int x = 0; x < width; ++x) {
     const double xAdjusted = xscale * x;
     double xPower = 1.0;
-    for (int i = 0; i <= hDegree; ++i) {
-      xPowers(i, x) = xPower;
+    for (int i = 0; i < numXPowers; ++i) {
+      xPowers[x * numXPowers + i] = xPower;
       xPower *= xAdjusted;
     }
   }
 
-  VecT<double> fullPowers(numTerms);
-
-  for (int y = 0; y < height; ++y, line += stride) {
-    const double yAdjusted = yscale * y;
-
-    double yPower = 1.0;
-    for (int i = 0; i <= vDegree; ++i) {
-      yPowers[i] = yPower;
-      yPower *= yAdjusted;
-    }
-
-    for (int x = 0; x < width; ++x) {
-      const double dataPoint = dataScale * line[x];
+  // Each band of rows gets its own sums.  They are added up in order
+  // afterwards, so the result doesn't depend on how many threads took part.
+  const int numBands = (height + ROWS_PER_BAND - 1) / ROWS_PER_BAND;
+  std::vector<double> bandPowerSums(numBands * numPowerSums);
+  std::vector<double> bandDataSums(numBands * numTerms);
+
+  parallelFor(0, height, ROWS_PER_BAND, [&](const int fromY, const int toY) {
+    double* const powerSums = &bandPowerSums[(fromY / ROWS_PER_BAND) * numPowerSums];
+    double* const dataSums = &bandDataSums[(fromY / ROWS_PER_BAND) * numTerms];
+    std::vector<double> rowPowerSums(numXPowers);
+    std::vector<double> rowDataSums(hDegree + 1);
+
+    const uint32_t msb = uint32_t(1) << 31;
+    for (int y = fromY; y < toY; ++y) {
+      const uint8_t* const imageLine = image.data() + y * image.stride();
+      const uint32_t* const maskLine = mask ? mask->data() + y * mask->wordsPerLine() : nullptr;
+
+      std::fill(rowPowerSums.begin(), rowPowerSums.end(), 0.0);
+      std::fill(rowDataSums.begin(), rowDataSums.end(), 0.0);
+      for (int x = 0; x < width; ++x) {
+        if (maskLine && !(maskLine[x >> 5] & (msb >> (x & 31)))) {
+          continue;
+        }
 
-      int pos = 0;
-      for (int i = 0; i <= vDegree; ++i) {
-        for (int j = 0; j <= hDegree; ++j, ++pos) {
-          fullPowers[pos] = yPowers[i] * xPowers(j, x);
+        const double dataPoint = dataScale * imageLine[x];
+        const double* const powers = &xPowers[x * numXPowers];
+        for (int i = 0; i < numXPowers; ++i) {
+          rowPowerSums[i] += powers[i];
+        }
+        for (int i = 0; i <= hDegree; ++i) {
+          rowDataSums[i] += dataPoint * powers[i];
         }
       }
 
-      double* p_AtA = AtA_data;
-      for (int i = 0; i < numTerms; ++i) {
-        const double iVal = fullPowers[i];
-        Atb_data[i] += iVal * dataPoint;
-
-        for (int j = 0; j < numTerms; ++j) {
-          const double jVal = fullPowers[j];
-          *p_AtA += iVal * jVal;
-          ++p_AtA;
+      const double yAdjusted = yscale * y;
+      double yPower = 1.0;
+      for (int i = 0; i < numYPowers; ++i) {
+        for (int j = 0; j < numXPowers; ++j) {
+          powerSums[i * numXPowers + j] += yPower * rowPowerSums[j];
         }
+        if (i <= vDegree) {
+          for (int j = 0; j <= hDegree; ++j) {
+            dataSums[i * (hDegree + 1) + j] += yPower * rowDataSums[j];
+          }
+        }
+        yPower *= yAdjusted;
       }
     }
-  }
-}  // PolynomialSurface::prepareDataForLeastSquares
+  });
 
-void PolynomialSurface::prepareDataForLeastSquares(const GrayImage& image,
-                                                   const BinaryImage& mask,
-                                                   MatT<double>& AtA,
-                                                   VecT<double>& Atb,
-                                                   const int hDegree,
-                                                   const int vDegree) {
-  double* const AtA_data = AtA.data();
+  std::vector<double> powerSums(numPowerSums);
   double* const Atb_data = Atb.data();
-
-  const int width = image.width();
-  const int height = image.height();
-  const auto numTerms = static_cast<int>(Atb.size());
-
-  const uint8_t* imageLine = image.data();
-  const int imageStride = image.stride();
-
-  const uint32_t* maskLine = mask.data();
-  const int maskStride = mask.wordsPerLine();
-
-  // Pretend that both x and y positions of pixels
-  // lie in range of [0, 1].
-  const double xscale = calcScale(width);
-  const double yscale = calcScale(height);
-
-  // To force data samples into [0, 1] range.
-  const double dataScale = 1.0 / 255.0;
-
-  // 1, y, y^2, y^3, ...
-  VecT<double> yPowers(vDegree + 1);  // Initialized to 0.
-
-  // Same as yPowers, except yPowers correspond to a given y,
-  // while xPowers are computed for all possible x values.
-  MatT<double> xPowers(hDegree + 1, width);  // Initialized to 0.
-  for (int x = 0; x < width; ++x) {
-    const double xAdjusted = xscale * x;
-    double xPower = 1.0;
-    for (int i = 0; i <= hDegree; ++i) {
-      xPowers(i, x) = xPower;
-      xPower *= xAdjusted;
+  for (int band = 0; band < numBands; ++band) {
+    for (int i = 0; i < numPowerSums; ++i) {
+      powerSums[i] += bandPowerSums[band * numPowerSums + i];
     }
-  }
-
-  VecT<double> fullPowers(numTerms);
-
-  const uint32_t msb = uint32_t(1) << 31;
-  for (int y = 0; y < height; ++y) {
-    const double yAdjusted = yscale * y;
-
-    double yPower = 1.0;
-    for (int i = 0; i <= vDegree; ++i) {
-      yPowers[i] = yPower;
-      yPower *= yAdjusted;
+    for (int i = 0; i < numTerms; ++i) {
+      Atb_data[i] += bandDataSums[band * numTerms + i];
     }
+  }
 
-    for (int x = 0; x < width; ++x) {
-      if (!(maskLine[x >> 5] & (msb >> (x & 31)))) {
-        continue;
-      }
-
-      const double dataPoint = dataScale * imageLine[x];
-
-      int pos = 0;
-      for (int i = 0; i <= vDegree; ++i) {
-        for (int j = 0; j <= hDegree; ++j, ++pos) {
-          fullPowers[pos] = yPowers[i] * xPowers(j, x);
-        }
-      }
-
-      double* p_AtA = AtA_data;
-      for (int i = 0; i < numTerms; ++i) {
-        const double iVal = fullPowers[i];
-        Atb_data[i] += iVal * dataPoint;
-
-        for (int j = 0; j < numTerms; ++j) {
-          const double jVal = fullPowers[j];
-          *p_AtA += iVal * jVal;
+  double* p_AtA = AtA.data();
+  for (int i1 = 0; i1 <= vDegree; ++i1) {
+    for (int j1 = 0; j1 <= hDegree; ++j1) {
+      for (int i2 = 0; i2 <= vDegree; ++i2) {
+        for (int j2 = 0; j2 <= hDegree; ++j2) {
+          *p_AtA += powerSums[(i1 + i2) * numXPowers + j1 + j2];
           ++p_AtA;
         }
       }
     }
-
-    imageLine += imageStride;
-    maskLine += maskStride;
   }
 }  // PolynomialSurface::prepareDataForLeastSquares
 
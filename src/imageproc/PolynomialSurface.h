@@ -73,14 +73,13 @@ class PolynomialSurface {
 
   static double calcScale(int dimension);
 
+  /**
+   * \brief Builds A^T*A and A^T*b from the pixels of \p image.
+   *
+   * If \p mask is not null, only the pixels that are black in it are considered.
+   */
   static void prepareDataForLeastSquares(const GrayImage& image,
-                                         MatT<double>& AtA,
-                                         VecT<double>& Atb,
-                                         int hDegree,
-                                         int vDegree);
-
-  static void prepareDataForLeastSquares(const GrayImage& image,
-                                         const BinaryImage& mask,
+                                         const BinaryImage* mask,
                                          MatT<double>& AtA,
                                          VecT<double>& Atb,
                                          int hDegree,
@@ -3,15 +3,61 @@
 
 #include "Posterizer.h"
 
+#include <ParallelFor.h>
+
+#include <algorithm>
 #include <stdexcept>
 #include <cassert>
 #include <set>
 #include <unordered_set>
 #include <list>
+#include <vector>
 
 #include "BinaryImage.h"
 
 namespace imageproc {
+namespace {
+/**
+ * The number of row bands the histograms of an image are accumulated in, concurrently.
+ * Every band gets its own copy of a histogram, so this also bounds the memory used.
+ */
+const int HISTOGRAM_BANDS = 8;
+
+/**
+ * Up to this level, there are at most 32^3 color groups, few enough to map
+ * every group to its color with a table.  Higher levels are rare, and those
+ * are handled by collecting every distinct color of the image.
+ */
+const int MAX_LEVEL_FOR_GROUP_TABLE = 31;
+
+/**
+ * The side of a cell of the color histogram, in levels of a channel.
+ */
+const int CELL_SIDE = 8;
+
+/**
+ * The number of exact color counters a pass over an image may use, in all of the bands.
+ * This bounds the number of cells whose colors are counted in a single pass.
+ */
+const int MAX_COLOR_COUNTERS = 1 << 23;
+
+/**
+ * The number of passes over an image counting exact colors, beyond which the image
+ * has so many colors that collecting every distinct one of them is done instead.
+ * A pass costs a small fraction of that, and even noisy photos take fewer.
+ */
+const int MAX_EXACT_COLOR_PASSES = 32;
+
+struct ChannelHistograms {
+  int red[256];
+  int green[256];
+  int blue[256];
+  int numBlack;
+  int numWhite;
+  uint32_t missingAlpha;  // The alpha bits that are zero in some pixel.
+};
+}  // namespace
+
 Posterizer::Posterizer(int level,
                        bool normalize,
                        bool forceBlackAndWhite,
@@ -45,7 +91,8 @@ QVector<QRgb> paletteFromRgb(const QImage& image) {
     imgLine += imgStride;
   }
 
-  QVector<QRgb> palette(colorSet.size());
+  QVector<QRgb> palette;
+  palette.reserve(static_cast<int>(colorSet.size()));
   std::copy(colorSet.begin(), colorSet.end(), std::back_inserter(palette));
   return palette;
 }
@@ -121,14 +168,19 @@ std::unordered_map<uint32_t, int> paletteFromIndexedWithStatistics(const QImage&
 
   QVector<QRgb> colorTable = image.colorTable();
 
+  int indexStats[256] = {};
   for (int y = 0; y < height; ++y) {
     for (int x = 0; x < width; ++x) {
-      uint8_t colorIndex = imgLine[x];
-      uint32_t color = colorTable[colorIndex];
-      ++palette[color];
+      ++indexStats[imgLine[x]];
     }
     imgLine += imgStride;
   }
+
+  for (int i = 0; i < colorTable.size(); ++i) {
+    if (indexStats[i] != 0) {
+      palette[colorTable[i]] += indexStats[i];
+    }
+  }
   return palette;
 }
 
@@ -167,13 +219,19 @@ void remapColorsInIndexedImage(QImage& image, const std::unordered_map<uint32_t,
     uint8_t* imgLine = image.bits();
     const int imgStride = image.bytesPerLine();
 
-    QVector<QRgb> colorTable = image.colorTable();
+    // Only the colors present in the image are in colorMap.
+    const QVector<QRgb> colorTable = image.colorTable();
+    uint8_t oldToNewIndex[256] = {};
+    for (int i = 0; i < colorTable.size(); ++i) {
+      const auto it = colorMap.find(colorTable[i]);
+      if (it != colorMap.end()) {
+        oldToNewIndex[i] = colorToIndexMap[it->second];
+      }
+    }
 
     for (int y = 0; y < height; ++y) {
       for (int x = 0; x < width; ++x) {
-        uint32_t color = colorTable[imgLine[x]];
-        uint32_t newColor = colorMap.at(color);
-        imgLine[x] = colorToIndexMap[newColor];
+        imgLine[x] = oldToNewIndex[imgLine[x]];
       }
       imgLine += imgStride;
     }
@@ -209,20 +267,53 @@ QVector<QRgb> paletteFromColorMap(const std::unordered_map<uint32_t, uint32_t>&
     colorSet.insert(srcAndDstColors.second);
   }
 
-  QVector<QRgb> palette(static_cast<int>(colorSet.size()));
+  QVector<QRgb> palette;
+  palette.reserve(static_cast<int>(colorSet.size()));
   std::copy(colorSet.begin(), colorSet.end(), std::back_inserter(palette));
   return palette;
 }
 
+/**
+ * Finds the darkest and the lightest levels present in any of the channels,
+ * ignoring the levels too rare to count.
+ */
+void findNormalizationRange(const int* redHist,
+                            const int* greenHist,
+                            const int* blueHist,
+                            const int pixelCount,
+                            int& minLevel,
+                            int& maxLevel) {
+  const double threshold = 0.0005;  // mustn't be larger than (1 / 256)
+
+  minLevel = 255;
+  maxLevel = 0;
+  for (int level = 0; level < 256; ++level) {
+    if (((double(redHist[level]) / pixelCount) >= threshold) || ((double(greenHist[level]) / pixelCount) >= threshold)
+        || ((double(blueHist[level]) / pixelCount) >= threshold)) {
+      if (level < minLevel) {
+        minLevel = level;
+      }
+      if (level > maxLevel) {
+        maxLevel = level;
+      }
+    }
+  }
+
+  assert(maxLevel >= minLevel);
+}
+
+int normalizeLevel(const int level, const int minLevel, const int maxLevel) {
+  return qBound(0, qRound((double(level - minLevel) / (maxLevel - minLevel)) * 255), 255);
+}
+
 std::unordered_map<uint32_t, uint32_t> normalizePalette(const QImage& image,
                                                         const std::unordered_map<uint32_t, int>& palette,
                                                         const int normalizeBlackLevel = 0,
                                                         const int normalizeWhiteLevel = 255) {
   const int pixelCount = image.width() * image.height();
-  const double threshold = 0.0005;  // mustn't be larger than (1 / 256)
 
-  int minLevel = 255;
-  int maxLevel = 0;
+  int minLevel;
+  int maxLevel;
   {
     // Build RGB histogram from colors with statistics
     int red_hist[256] = {};
@@ -251,20 +342,7 @@ std::unordered_map<uint32_t, uint32_t> normalizePalette(const QImage& image,
     }
 
     // Find the max and min levels discarding a noise
-    for (int level = 0; level < 256; ++level) {
-      if (((double(red_hist[level]) / pixelCount) >= threshold)
-          || ((double(green_hist[level]) / pixelCount) >= threshold)
-          || ((double(blue_hist[level]) / pixelCount) >= threshold)) {
-        if (level < minLevel) {
-          minLevel = level;
-        }
-        if (level > maxLevel) {
-          maxLevel = level;
-        }
-      }
-    }
-
-    assert(maxLevel >= minLevel);
+    findNormalizationRange(red_hist, green_hist, blue_hist, pixelCount, minLevel, maxLevel);
   }
 
   std::unordered_map<uint32_t, uint32_t> colorToNormalizedMap;
@@ -279,14 +357,9 @@ std::unordered_map<uint32_t, uint32_t> normalizePalette(const QImage& image,
       continue;
     }
 
-    int normalizedRed = qRound((double(qRed(color) - minLevel) / (maxLevel - minLevel)) * 255);
-    int normalizedGreen = qRound((double(qGreen(color) - minLevel) / (maxLevel - minLevel)) * 255);
-    int normalizedBlue = qRound((double(qBlue(color) - minLevel) / (maxLevel - minLevel)) * 255);
-    normalizedRed = qBound(0, normalizedRed, 255);
-    normalizedGreen = qBound(0, normalizedGreen, 255);
-    normalizedBlue = qBound(0, normalizedBlue, 255);
-
-    colorToNormalizedMap[color] = qRgb(normalizedRed, normalizedGreen, normalizedBlue);
+    colorToNormalizedMap[color] = qRgb(normalizeLevel(qRed(color), minLevel, maxLevel),
+                                       normalizeLevel(qGreen(color), minLevel, maxLevel),
+                                       normalizeLevel(qBlue(color), minLevel, maxLevel));
   }
   return colorToNormalizedMap;
 }
@@ -319,6 +392,14 @@ QImage Posterizer::posterize(const QImage& image) const {
     return image;
   }
 
+  if ((m_level <= MAX_LEVEL_FOR_GROUP_TABLE) && !image.isNull()
+      && ((image.format() == QImage::Format_RGB32) || (image.format() == QImage::Format_ARGB32))) {
+    const QImage posterized = posterizeOpaqueRgb(image);
+    if (!posterized.isNull()) {
+      return posterized;
+    }
+  }
+
   std::unordered_map<uint32_t, uint32_t> oldToNewColorMap;
   size_t newColorTableSize;
 
@@ -396,4 +477,286 @@ QImage Posterizer::posterize(const QImage& image) const {
   }
   return dst;
 }
+
+QImage Posterizer::posterizeOpaqueRgb(const QImage& image) const {
+  // This gives the same groups as posterize() does, but instead of counting every
+  // distinct color, it counts the pixels in coarse cells of the RGB space, and then
+  // the exact colors only in those cells that may hold the representative of a group.
+
+  const int width = image.width();
+  const int height = image.height();
+
+  const auto* const imgData = reinterpret_cast<const uint32_t*>(image.bits());
+  const int imgStride = image.bytesPerLine() / sizeof(uint32_t);
+
+  const int rowsPerBand = (height + HISTOGRAM_BANDS - 1) / HISTOGRAM_BANDS;
+  const int numBands = (height + rowsPerBand - 1) / rowsPerBand;
+
+  // Levels of each channel, for normalization.
+  int minLevel;
+  int maxLevel;
+  {
+    std::vector<ChannelHistograms> bandHists(numBands, ChannelHistograms());
+    parallelFor(0, height, rowsPerBand, [&](const int fromY, const int toY) {
+      ChannelHistograms& hists = bandHists[fromY / rowsPerBand];
+      for (int y = fromY; y < toY; ++y) {
+        const uint32_t* const imgLine = imgData + y * imgStride;
+        for (int x = 0; x < width; ++x) {
+          const uint32_t color = imgLine[x];
+          ++hists.red[qRed(color)];
+          ++hists.green[qGreen(color)];
+          ++hists.blue[qBlue(color)];
+          hists.numBlack += (color == 0xff000000u);
+          hists.numWhite += (color == 0xffffffffu);
+          hists.missingAlpha |= ~color;
+        }
+      }
+    });
+
+    ChannelHistograms& hists = bandHists[0];
+    for (int band = 1; band < numBands; ++band) {
+      for (int level = 0; level < 256; ++level) {
+        hists.red[level] += bandHists[band].red[level];
+        hists.green[level] += bandHists[band].green[level];
+        hists.blue[level] += bandHists[band].blue[level];
+      }
+      hists.numBlack += bandHists[band].numBlack;
+      hists.numWhite += bandHists[band].numWhite;
+      hists.missingAlpha |= bandHists[band].missingAlpha;
+    }
+
+    if ((hists.missingAlpha & 0xff000000u) != 0) {
+      return QImage();
+    }
+
+    // Pure black and white count as the given levels, like in normalizePalette().
+    for (int* hist : {hists.red, hists.green, hists.blue}) {
+      hist[0] -= hists.numBlack;
+      hist[m_normalizeBlackLevel] += hists.numBlack;
+      hist[255] -= hists.numWhite;
+      hist[m_normalizeWhiteLevel] += hists.numWhite;
+    }
+
+    findNormalizationRange(hists.red, hists.green, hists.blue, width * height, minLevel, maxLevel);
+    if (maxLevel == minLevel) {
+      return QImage();
+    }
+  }
+
+  // Normalization and grouping work on each channel separately, so they are done with tables.
+  // The cells are split at the group boundaries, so that each one belongs to a single group.
+  const int groupsPerChannel = m_level + 1;
+  const double levelStride = 255.0 / m_level;
+  int normalized[256];
+  int groupOf[256];
+  int cellOf[256];
+  int offsetInCell[256];
+  std::vector<int> cellStart;
+  for (int level = 0; level < 256; ++level) {
+    normalized[level] = normalizeLevel(level, minLevel, maxLevel);
+    groupOf[level] = static_cast<int>(normalized[level] / levelStride);
+    if ((level == 0) || (groupOf[level] != groupOf[level - 1]) || (level % CELL_SIDE == 0)) {
+      cellStart.push_back(level);
+    }
+    cellOf[level] = static_cast<int>(cellStart.size()) - 1;
+    offsetInCell[level] = level - cellStart.back();
+  }
+  const int cellsPerChannel = static_cast<int>(cellStart.size());
+  const int numCells = cellsPerChannel * cellsPerChannel * cellsPerChannel;
+  const int numGroups = groupsPerChannel * groupsPerChannel * groupsPerChannel;
+
+  // Cell and group indices are sums of per channel terms.
+  int redCell[256];
+  int greenCell[256];
+  int redGroup[256];
+  int greenGroup[256];
+  for (int level = 0; level < 256; ++level) {
+    redCell[level] = cellOf[level] * cellsPerChannel * cellsPerChannel;
+    greenCell[level] = cellOf[level] * cellsPerChannel;
+    redGroup[level] = groupOf[level] * groupsPerChannel * groupsPerChannel;
+    greenGroup[level] = groupOf[level] * groupsPerChannel;
+  }
+
+  std::vector<int> cellHist(static_cast<size_t>(numBands) * numCells, 0);
+  parallelFor(0, height, rowsPerBand, [&](const int fromY, const int toY) {
+    int* const hist = &cellHist[static_cast<size_t>(fromY / rowsPerBand) * numCells];
+    for (int y = fromY; y < toY; ++y) {
+      const uint32_t* const imgLine = imgData + y * imgStride;
+      for (int x = 0; x < width; ++x) {
+        const uint32_t color = imgLine[x];
+        ++hist[redCell[qRed(color)] + greenCell[qGreen(color)] + cellOf[qBlue(color)]];
+      }
+    }
+  });
+  for (int band = 1; band < numBands; ++band) {
+    const int* const bandHist = &cellHist[static_cast<size_t>(band) * numCells];
+    for (int cell = 0; cell < numCells; ++cell) {
+      cellHist[cell] += bandHist[cell];
+    }
+  }
+
+  // Every group is represented by its most often occurring color.  No color of a cell
+  // occurs more often than the cell is populated, so the cells of a group are visited
+  // in descending order of population, until the rest of them can't hold a color more
+  // frequent than the best one found.  Each pass over the image counts the exact colors
+  // of as many cells as the counters allow, taken from all of the groups in turn.
+  std::vector<std::vector<int>> groupCells(numGroups);
+  for (int cell = 0; cell < numCells; ++cell) {
+    if (cellHist[cell] == 0) {
+      continue;
+    }
+    const int redLevel = cellStart[cell / (cellsPerChannel * cellsPerChannel)];
+    const int greenLevel = cellStart[(cell / cellsPerChannel) % cellsPerChannel];
+    const int blueLevel = cellStart[cell % cellsPerChannel];
+    groupCells[redGroup[redLevel] + greenGroup[greenLevel] + groupOf[blueLevel]].push_back(cell);
+  }
+
+  std::vector<int> groups;
+  for (int group = 0; group < numGroups; ++group) {
+    std::vector<int>& cells = groupCells[group];
+    if (!cells.empty()) {
+      std::stable_sort(cells.begin(), cells.end(), [&](int lhs, int rhs) { return cellHist[lhs] > cellHist[rhs]; });
+      groups.push_back(group);
+    }
+  }
+
+  const int cellVolume = CELL_SIDE * CELL_SIDE * CELL_SIDE;
+  const size_t maxCellsPerPass = static_cast<size_t>(std::max(1, MAX_COLOR_COUNTERS / (numBands * cellVolume)));
+  std::vector<size_t> nextCell(groups.size(), 0);
+  std::vector<int> bestCount(groups.size(), 0);
+  std::vector<QRgb> bestColor(groups.size(), 0);
+  std::vector<size_t> pending(groups.size());
+  for (size_t slot = 0; slot < groups.size(); ++slot) {
+    pending[slot] = slot;
+  }
+
+  std::vector<int> cellIndex(numCells, -1);
+  std::vector<int> passCells;
+  std::vector<size_t> passSlots;
+  std::vector<int> colorHist;
+  int numPasses = 0;
+  while (!pending.empty()) {
+    passCells.clear();
+    passSlots.clear();
+    while ((passCells.size() < maxCellsPerPass) && !pending.empty()) {
+      size_t numPending = 0;
+      for (const size_t slot : pending) {
+        const std::vector<int>& cells = groupCells[groups[slot]];
+        if ((nextCell[slot] == cells.size()) || (cellHist[cells[nextCell[slot]]] <= bestCount[slot])) {
+          continue;
+        }
+        if (passCells.size() < maxCellsPerPass) {
+          cellIndex[cells[nextCell[slot]]] = static_cast<int>(passCells.size());
+          passCells.push_back(cells[nextCell[slot]]);
+          passSlots.push_back(slot);
+          ++nextCell[slot];
+        }
+        pending[numPending++] = slot;
+      }
+      pending.resize(numPending);
+    }
+    if (passCells.empty()) {
+      break;
+    }
+    if (++numPasses > MAX_EXACT_COLOR_PASSES) {
+      return QImage();
+    }
+
+    const size_t passVolume = passCells.size() * cellVolume;
+    colorHist.assign(numBands * passVolume, 0);
+    parallelFor(0, height, rowsPerBand, [&](const int fromY, const int toY) {
+      int* const hist = &colorHist[(fromY / rowsPerBand) * passVolume];
+      for (int y = fromY; y < toY; ++y) {
+        const uint32_t* const imgLine = imgData + y * imgStride;
+        for (int x = 0; x < width; ++x) {
+          const uint32_t color = imgLine[x];
+          const int index = cellIndex[redCell[qRed(color)] + greenCell[qGreen(color)] + cellOf[qBlue(color)]];
+          if (index >= 0) {
+            const int offset = (offsetInCell[qRed(color)] * CELL_SIDE + offsetInCell[qGreen(color)]) * CELL_SIDE
+                               + offsetInCell[qBlue(color)];
+            ++hist[index * cellVolume + offset];
+          }
+        }
+      }
+    });
+
+    for (size_t i = 0; i < passCells.size(); ++i) {
+      const int cell = passCells[i];
+      const size_t slot = passSlots[i];
+      cellIndex[cell] = -1;
+      const int redLevel = cellStart[cell / (cellsPerChannel * cellsPerChannel)];
+      const int greenLevel = cellStart[(cell / cellsPerChannel) % cellsPerChannel];
+      const int blueLevel = cellStart[cell % cellsPerChannel];
+      for (int offset = 0; offset < cellVolume; ++offset) {
+        int count = 0;
+        for (int band = 0; band < numBands; ++band) {
+          count += colorHist[band * passVolume + i * cellVolume + offset];
+        }
+        if (count > bestCount[slot]) {
+          bestCount[slot] = count;
+          bestColor[slot] = qRgb(redLevel + offset / (CELL_SIDE * CELL_SIDE),
+                                 greenLevel + (offset / CELL_SIDE) % CELL_SIDE, blueLevel + offset % CELL_SIDE);
+        }
+      }
+    }
+  }
+
+  // Pick the color of every group and build the palette.
+  std::vector<uint32_t> groupColor(numGroups, 0);
+  std::vector<uint8_t> groupIndex(numGroups, 0);
+  QVector<QRgb> palette;
+  std::unordered_map<uint32_t, int> colorToIndex;
+  for (size_t slot = 0; slot < groups.size(); ++slot) {
+    QRgb color = bestColor[slot];
+    if (m_forceBlackAndWhite) {
+      makeGrayBlackOrWhiteInPlace(color, qRgb(normalized[qRed(color)], normalized[qGreen(color)],
+                                              normalized[qBlue(color)]));
+    }
+    if (m_normalize) {
+      color = qRgb(normalized[qRed(color)], normalized[qGreen(color)], normalized[qBlue(color)]);
+    }
+
+    const auto it = colorToIndex.emplace(color, palette.size()).first;
+    if (it->second == palette.size()) {
+      palette.push_back(color);
+    }
+    groupColor[groups[slot]] = color;
+    groupIndex[groups[slot]] = static_cast<uint8_t>(it->second);
+  }
+
+  if (palette.size() <= 256) {
+    QImage dst(image.size(), QImage::Format_Indexed8);
+    dst.setColorTable(palette);
+    dst.setDotsPerMeterX(image.dotsPerMeterX());
+    dst.setDotsPerMeterY(image.dotsPerMeterY());
+
+    uint8_t* const dstData = dst.bits();
+    const int dstStride = dst.bytesPerLine();
+    parallelFor(0, height, rowsPerBand, [&](const int fromY, const int toY) {
+      for (int y = fromY; y < toY; ++y) {
+        const uint32_t* const imgLine = imgData + y * imgStride;
+        uint8_t* const dstLine = dstData + y * dstStride;
+        for (int x = 0; x < width; ++x) {
+          const uint32_t color = imgLine[x];
+          dstLine[x] = groupIndex[redGroup[qRed(color)] + greenGroup[qGreen(color)] + groupOf[qBlue(color)]];
+        }
+      }
+    });
+    return dst;
+  }
+
+  QImage dst(image);
+  auto* const dstData = reinterpret_cast<uint32_t*>(dst.bits());
+  const int dstStride = dst.bytesPerLine() / sizeof(uint32_t);
+  parallelFor(0, height, rowsPerBand, [&](const int fromY, const int toY) {
+    for (int y = fromY; y < toY; ++y) {
+      uint32_t* const dstLine = dstData + y * dstStride;
+      for (int x = 0; x < width; ++x) {
+        const uint32_t color = dstLine[x];
+        dstLine[x] = groupColor[redGroup[qRed(color)] + greenGroup[qGreen(color)] + groupOf[qBlue(color)]];
+      }
+    }
+  });
+  return dst;
+}  // Posterizer::posterizeOpaqueRgb
 }  // namespace imageproc
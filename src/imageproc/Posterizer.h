@@ -26,6 +26,14 @@ class Posterizer {
   QImage posterize(const QImage& image) const;
 
  private:
+  /**
+   * \brief posterize() for opaque RGB32 and ARGB32 images, without tracking every color.
+   *
+   * Returns a null image if some of the pixels aren't opaque, or if the image has
+   * so many colors that collecting every one of them is cheaper.
+   */
+  QImage posterizeOpaqueRgb(const QImage& image) const;
+
   int m_level;
   bool m_normalize;
   bool m_forceBlackAndWhite;
@@ -5,6 +5,7 @@
 
 #include <stdexcept>
 
+#include "CancellationPoint.h"
 #include "Grayscale.h"
 #include "SavGolKernel.h"
 
@@ -158,6 +159,7 @@ QImage savGolFilterGrayToGray(const QImage& src, const QSize& windowSize, const
   srcLine = srcData - shift;
   float* tempLine = tempArray.data() - shift;
   for (int y = 0; y < height; ++y) {
+    CancellationPoint::poll();
     for (int i = shift; i < width; ++i) {
       float sum = 0.0f;
 
@@ -174,6 +176,7 @@ QImage savGolFilterGrayToGray(const QImage& src, const QSize& windowSize, const
   dstLine = dstData + kTop * dstBpl + kLeft - shift;
   tempLine = tempArray.data() - shift;
   for (int y = kTop; y < height - kBottom; ++y) {
+    CancellationPoint::poll();
     for (int i = shift; i < width; ++i) {
       float sum = 0.0f;
 
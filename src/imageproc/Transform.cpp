@@ -8,6 +8,7 @@
 #include <stdexcept>
 
 #include "BadAllocIfNull.h"
+#include "CancellationPoint.h"
 #include "ColorMixer.h"
 #include "Grayscale.h"
 
@@ -71,6 +72,7 @@ static void transformGeneric(const StorageUnit* const srcData,
   const int src32UnitH = std::max<int>(1, qRound(src32UnitSize.height()));
 
   for (int dy = 0; dy < dh; ++dy, dstLine += dstStride) {
+    CancellationPoint::poll();
     const double fDyCenter = dy + 0.5;
     const double fSx32Base = fDyCenter * invXform.m21() + invXform.dx();
     const double fSy32Base = fDyCenter * invXform.m22() + invXform.dy();
@@ -0,0 +1,121 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#include <BinaryImage.h>
+#include <ColorSegmenter.h>
+#include <Dpi.h>
+
+#include <QImage>
+#include <QRect>
+#include <boost/test/unit_test.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace imageproc {
+namespace tests {
+BOOST_AUTO_TEST_SUITE(ColorSegmenterTestSuite)
+
+namespace {
+/**
+ * Fills \p rect with \p color, made lighter by 2 on every other pixel,
+ * and marks it in \p mask.
+ */
+void paintRect(QImage& image, BinaryImage& mask, const QRect& rect, const QRgb color) {
+  const QRgb lighter = qRgb(qRed(color) + 2, qGreen(color) + 2, qBlue(color) + 2);
+  for (int y = rect.top(); y <= rect.bottom(); ++y) {
+    for (int x = rect.left(); x <= rect.right(); ++x) {
+      image.setPixel(x, y, ((x + y) & 1) ? lighter : color);
+      mask.setPixel(x, y, BLACK);
+    }
+  }
+}
+
+/**
+ * The average color of the pixels within \p rects, rounded like ColorSegmenter does.
+ */
+QRgb averageColor(const QImage& image, const std::vector<QRect>& rects) {
+  uint64_t red = 0;
+  uint64_t green = 0;
+  uint64_t blue = 0;
+  uint64_t count = 0;
+  for (const QRect& rect : rects) {
+    for (int y = rect.top(); y <= rect.bottom(); ++y) {
+      for (int x = rect.left(); x <= rect.right(); ++x) {
+        const QRgb color = image.pixel(x, y);
+        red += qRed(color);
+        green += qGreen(color);
+        blue += qBlue(color);
+        ++count;
+      }
+    }
+  }
+  return qRgb(int((2 * red + count) / (2 * count)), int((2 * green + count) / (2 * count)),
+              int((2 * blue + count) / (2 * count)));
+}
+
+bool rectHasColor(const QImage& image, const QRect& rect, const QRgb color) {
+  for (int y = rect.top(); y <= rect.bottom(); ++y) {
+    for (int x = rect.left(); x <= rect.right(); ++x) {
+      if (image.pixel(x, y) != color) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(test_adjacent_colors_stay_apart) {
+  QImage image(96, 64, QImage::Format_RGB32);
+  image.fill(0xffffffff);
+  BinaryImage mask(image.size(), WHITE);
+
+  const QRect redRect(12, 16, 24, 32);
+  const QRect blueRect(36, 16, 24, 32);
+  const QRect blackRect(60, 16, 24, 32);
+  paintRect(image, mask, redRect, qRgb(230, 20, 20));
+  paintRect(image, mask, blueRect, qRgb(20, 20, 230));
+  paintRect(image, mask, blackRect, qRgb(20, 20, 20));
+
+  const QImage segmented(ColorSegmenter(Dpi(300, 300), 1).segment(mask, image));
+
+  BOOST_CHECK(rectHasColor(segmented, redRect, averageColor(image, {redRect})));
+  BOOST_CHECK(rectHasColor(segmented, blueRect, averageColor(image, {blueRect})));
+  BOOST_CHECK(rectHasColor(segmented, blackRect, averageColor(image, {blackRect})));
+  BOOST_CHECK(rectHasColor(segmented, QRect(0, 0, 96, 16), 0xffffffff));
+}
+
+BOOST_AUTO_TEST_CASE(test_components_are_8_connected) {
+  // Tall enough for components to span several bands processed concurrently.
+  QImage image(64, 600, QImage::Format_RGB32);
+  image.fill(0xffffffff);
+  BinaryImage mask(image.size(), WHITE);
+
+  // Touching only at a corner.
+  const QRect upperLeft(10, 20, 10, 21);
+  const QRect lowerRight(20, 41, 10, 21);
+  // One above the other, across the band boundaries.
+  const QRect upper(36, 100, 12, 200);
+  const QRect lower(36, 300, 12, 250);
+  // Apart from the rest.
+  const QRect separate(10, 400, 10, 40);
+  paintRect(image, mask, upperLeft, qRgb(20, 20, 230));
+  paintRect(image, mask, lowerRight, qRgb(30, 30, 200));
+  paintRect(image, mask, upper, qRgb(20, 20, 230));
+  paintRect(image, mask, lower, qRgb(40, 40, 220));
+  paintRect(image, mask, separate, qRgb(35, 25, 210));
+
+  const QImage segmented(ColorSegmenter(Dpi(300, 300), 1).segment(mask, image));
+
+  const QRgb cornerColor = averageColor(image, {upperLeft, lowerRight});
+  BOOST_CHECK(rectHasColor(segmented, upperLeft, cornerColor));
+  BOOST_CHECK(rectHasColor(segmented, lowerRight, cornerColor));
+  const QRgb columnColor = averageColor(image, {upper, lower});
+  BOOST_CHECK(rectHasColor(segmented, upper, columnColor));
+  BOOST_CHECK(rectHasColor(segmented, lower, columnColor));
+  BOOST_CHECK(rectHasColor(segmented, separate, averageColor(image, {separate})));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+}  // namespace tests
+}  // namespace imageproc
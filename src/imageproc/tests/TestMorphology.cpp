@@ -4,12 +4,14 @@
 #include <BWColor.h>
 #include <BinaryImage.h>
 #include <GrayImage.h>
+#include <HitMissReplacer.h>
 #include <Morphology.h>
 
 #include <QImage>
 #include <QPoint>
 #include <QSize>
 #include <boost/test/unit_test.hpp>
+#include <vector>
 
 #include "Utils.h"
 
@@ -672,6 +674,106 @@ BOOST_AUTO_TEST_CASE(test_hmr_1) {
   BOOST_CHECK(hitMissReplace(img, BLACK, pattern, 3, 3) == control);
 }
 
+namespace {
+struct Pattern {
+  const char* pattern;
+  int width;
+  int height;
+};
+
+// Some of the edge smoothing patterns of the output stage, a few of them rotated clockwise.
+const Pattern smoothingPatterns[] = {{"XXX"
+                                      " - "
+                                      "   ",
+                                      3, 3},
+                                     {"X ?"
+                                      "X  "
+                                      "X- "
+                                      "X- "
+                                      "X  "
+                                      "X ?",
+                                      3, 6},
+                                     {"XXXXXX"
+                                      "  --  "
+                                      "?    ?",
+                                      6, 3},
+                                     {"XX?"
+                                      "XX?"
+                                      "XX "
+                                      "X+ "
+                                      "X+ "
+                                      "X+ "
+                                      "XX "
+                                      "XX?"
+                                      "XX?",
+                                      3, 9},
+                                     {"XXXXXXXXX"
+                                      "XXX+++XXX"
+                                      "??     ??",
+                                      9, 3},
+                                     {"   "
+                                      "X+X"
+                                      "XXX",
+                                      3, 3}};
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(test_hit_miss_replacer_matches_sequential_replacements) {
+  for (const BWColor surroundings : {WHITE, BLACK}) {
+    HitMissReplacer replacer(surroundings);
+    for (const Pattern& pattern : smoothingPatterns) {
+      replacer.add(pattern.pattern, pattern.width, pattern.height);
+    }
+
+    // The last size is processed in several bands.
+    static const QSize sizes[] = {QSize(1, 1), QSize(5, 40), QSize(32, 32), QSize(33, 7), QSize(97, 203),
+                                  QSize(6000, 1200)};
+    for (const QSize& size : sizes) {
+      BinaryImage control(randomBinaryImage(size.width(), size.height()));
+      BinaryImage img(control);
+
+      for (const Pattern& pattern : smoothingPatterns) {
+        hitMissReplaceInPlace(control, surroundings, pattern.pattern, pattern.width, pattern.height);
+      }
+      replacer.apply(img);
+
+      BOOST_REQUIRE(img == control);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_hit_miss_replacer_all_directions) {
+  static const char pattern[]
+      = "X ?"
+        "X- "
+        "X  ";
+  static const char rotatedCw[]
+      = "XXX"
+        " - "
+        "  ?";
+  static const char upsideDown[]
+      = "  X"
+        " -X"
+        "? X";
+  static const char rotatedCcw[]
+      = "?  "
+        " - "
+        "XXX";
+
+  HitMissReplacer allDirections;
+  allDirections.addAllDirections(pattern, 3, 3);
+
+  HitMissReplacer oneByOne;
+  for (const char* p : {pattern, rotatedCw, upsideDown, rotatedCcw}) {
+    oneByOne.add(p, 3, 3);
+  }
+
+  BinaryImage img1(randomBinaryImage(100, 100));
+  BinaryImage img2(img1);
+  allDirections.apply(img1);
+  oneByOne.apply(img2);
+  BOOST_CHECK(img1 == img2);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 }  // namespace tests
 }  // namespace imageproc
\ No newline at end of file
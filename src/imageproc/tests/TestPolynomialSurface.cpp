@@ -0,0 +1,76 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#include <BinaryImage.h>
+#include <GrayImage.h>
+#include <PolynomialSurface.h>
+
+#include <QSize>
+#include <boost/test/unit_test.hpp>
+#include <cstdlib>
+
+namespace imageproc {
+namespace tests {
+BOOST_AUTO_TEST_SUITE(PolynomialSurfaceTestSuite)
+
+namespace {
+/**
+ * A surface that can be represented exactly with a polynomial of degree 2
+ * in both directions.  Both x and y are in [0, 1].
+ */
+double surfaceAt(const double x, const double y) {
+  return 40.0 + 120.0 * x - 80.0 * x * x + 60.0 * y * y + 50.0 * x * y;
+}
+
+GrayImage renderSurface(const QSize& size) {
+  GrayImage image(size);
+  for (int y = 0; y < size.height(); ++y) {
+    for (int x = 0; x < size.width(); ++x) {
+      const double value = surfaceAt(double(x) / (size.width() - 1), double(y) / (size.height() - 1));
+      image.data()[y * image.stride() + x] = static_cast<uint8_t>(value + 0.5);
+    }
+  }
+  return image;
+}
+
+bool renderedClose(const GrayImage& image, const GrayImage& control) {
+  for (int y = 0; y < image.height(); ++y) {
+    for (int x = 0; x < image.width(); ++x) {
+      const int diff = image.data()[y * image.stride() + x] - control.data()[y * control.stride() + x];
+      if (std::abs(diff) > 1) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(test_fit_whole_image) {
+  const GrayImage image(renderSurface(QSize(97, 61)));
+  const PolynomialSurface surface(2, 2, image);
+  BOOST_CHECK(renderedClose(surface.render(image.size()), image));
+
+  // Rendering to another size scales the surface.
+  const QSize largeSize(1001, 777);
+  BOOST_CHECK(renderedClose(surface.render(largeSize), renderSurface(largeSize)));
+}
+
+BOOST_AUTO_TEST_CASE(test_fit_masked) {
+  GrayImage image(renderSurface(QSize(120, 80)));
+  BinaryImage mask(image.size(), BLACK);
+  // Garbage in the area left out by the mask must not affect the result.
+  for (int y = 20; y < 50; ++y) {
+    for (int x = 30; x < 90; ++x) {
+      image.data()[y * image.stride() + x] = static_cast<uint8_t>(rand() % 256);
+      mask.setPixel(x, y, WHITE);
+    }
+  }
+
+  const PolynomialSurface surface(4, 3, image, mask);
+  BOOST_CHECK(renderedClose(surface.render(image.size()), renderSurface(image.size())));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+}  // namespace tests
+}  // namespace imageproc
@@ -0,0 +1,178 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#include <Posterizer.h>
+
+#include <QImage>
+#include <algorithm>
+#include <boost/test/unit_test.hpp>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace imageproc {
+namespace tests {
+BOOST_AUTO_TEST_SUITE(PosterizerTestSuite)
+
+namespace {
+/**
+ * Every color of \p colors occupies a column of the image, the wider the later it comes,
+ * so that no two colors occur equally often.
+ */
+QImage makeStripes(const std::vector<QRgb>& colors) {
+  const int height = 4;
+  int width = 0;
+  for (size_t i = 0; i < colors.size(); ++i) {
+    width += static_cast<int>(i) + 1;
+  }
+
+  QImage image(QSize(width, height), QImage::Format_RGB32);
+  for (int y = 0; y < height; ++y) {
+    auto* line = reinterpret_cast<uint32_t*>(image.bits() + y * image.bytesPerLine());
+    int x = 0;
+    for (size_t i = 0; i < colors.size(); ++i) {
+      for (size_t j = 0; j <= i; ++j) {
+        line[x++] = colors[i];
+      }
+    }
+  }
+  return image;
+}
+
+QImage toIndexed(const QImage& image, const std::vector<QRgb>& colors) {
+  QVector<QRgb> colorTable;
+  for (const QRgb color : colors) {
+    colorTable.push_back(color);
+  }
+
+  QImage indexed(image.size(), QImage::Format_Indexed8);
+  indexed.setColorTable(colorTable);
+  for (int y = 0; y < image.height(); ++y) {
+    for (int x = 0; x < image.width(); ++x) {
+      const int index = colorTable.indexOf(image.pixel(x, y));
+      indexed.bits()[y * indexed.bytesPerLine() + x] = static_cast<uint8_t>(index);
+    }
+  }
+  return indexed;
+}
+
+bool sameColors(const QImage& image, const QImage& control) {
+  for (int y = 0; y < image.height(); ++y) {
+    for (int x = 0; x < image.width(); ++x) {
+      if (image.pixel(x, y) != control.pixel(x, y)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(test_most_often_occurring_color_represents_group) {
+  // At level 2, the two reds fall into the same group, while black and white
+  // make sure normalization doesn't move them apart.
+  const QRgb black = 0xff000000u;
+  const QRgb white = 0xffffffffu;
+  const QRgb rareRed = qRgb(180, 60, 20);
+  const QRgb commonRed = qRgb(200, 40, 40);
+  const QImage image(makeStripes({black, white, rareRed, commonRed}));
+
+  const QImage posterized(Posterizer(2, true).posterize(image));
+  BOOST_REQUIRE(posterized.format() == QImage::Format_Indexed8);
+  BOOST_CHECK_EQUAL(posterized.colorTable().size(), 3);
+
+  for (int x = 0; x < image.width(); ++x) {
+    const QRgb expected = (image.pixel(x, 0) == rareRed) ? commonRed : image.pixel(x, 0);
+    BOOST_REQUIRE_EQUAL(posterized.pixel(x, 0), expected);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_most_often_occurring_color_wins_over_most_populated_region) {
+  // At level 2, all of the dark grays fall into one group.  The five darkest ones are so close
+  // that together they outnumber the lighter one, though each of them occurs less often.
+  // Black and white make sure the levels aren't stretched, and white stays a group of its own.
+  const QRgb white = 0xffffffffu;
+  std::vector<QRgb> colors{0xff000000u, white};
+  for (int level = 1; level <= 5; ++level) {
+    colors.push_back(qRgb(level, level, level));
+  }
+  const QRgb rareLight = qRgb(200, 200, 200);
+  const QRgb commonLight = qRgb(201, 201, 201);
+  const QRgb commonDark = qRgb(20, 20, 20);
+  colors.push_back(rareLight);
+  colors.push_back(commonLight);
+  colors.push_back(commonDark);
+  const QImage rgb(makeStripes(colors));
+
+  for (const QImage& image : {rgb, toIndexed(rgb, colors)}) {
+    const QImage posterized(Posterizer(2).posterize(image));
+    BOOST_REQUIRE(posterized.format() == QImage::Format_Indexed8);
+    BOOST_CHECK_EQUAL(posterized.colorTable().size(), 3);
+
+    for (int x = 0; x < image.width(); ++x) {
+      QRgb expected = (qRed(image.pixel(x, 0)) < 128) ? commonDark : commonLight;
+      if (image.pixel(x, 0) == white) {
+        expected = white;
+      }
+      BOOST_REQUIRE_EQUAL(posterized.pixel(x, 0), expected);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_rgb_and_indexed_images_agree) {
+  // Indexed images go through the code tracking every color,
+  // unlike opaque RGB ones.
+  std::vector<QRgb> colors;
+  for (int i = 0; i < 40; ++i) {
+    colors.push_back(qRgb((i * 97) % 256, (i * 53 + 40) % 256, (i * 29 + 200) % 256));
+  }
+  colors.push_back(0xff000000u);
+  colors.push_back(0xffffffffu);
+  const QImage rgb(makeStripes(colors));
+  const QImage indexed(toIndexed(rgb, colors));
+
+  for (int level : {2, 3, 5, 8, 31}) {
+    for (int flags = 0; flags < 4; ++flags) {
+      const Posterizer posterizer(level, (flags & 1) != 0, (flags & 2) != 0, 0, 240);
+      BOOST_REQUIRE(sameColors(posterizer.posterize(rgb), posterizer.posterize(indexed)));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_noise_falls_back_to_tracking_every_color) {
+  // At level 31, noise has so many colors that counting them in passes over the image
+  // is given up for collecting every one of them.  Either way, every group must be
+  // represented by one of its most often occurring colors, whichever of them it is.
+  std::mt19937 rng(1);
+  QImage image(QSize(768, 512), QImage::Format_RGB32);
+  for (int y = 0; y < image.height(); ++y) {
+    for (int x = 0; x < image.width(); ++x) {
+      image.setPixel(x, y, 0xff000000u | (rng() & 0x00ffffffu));
+    }
+  }
+
+  const QImage posterized(Posterizer(31).posterize(image));
+
+  std::unordered_map<QRgb, int> colorCounts;
+  for (int y = 0; y < image.height(); ++y) {
+    for (int x = 0; x < image.width(); ++x) {
+      ++colorCounts[image.pixel(x, y)];
+    }
+  }
+  std::unordered_map<QRgb, int> groupMaxCounts;
+  for (int y = 0; y < image.height(); ++y) {
+    for (int x = 0; x < image.width(); ++x) {
+      int& maxCount = groupMaxCounts[posterized.pixel(x, y)];
+      maxCount = std::max(maxCount, colorCounts[image.pixel(x, y)]);
+    }
+  }
+  for (const auto& colorAndMaxCount : groupMaxCounts) {
+    const auto it = colorCounts.find(colorAndMaxCount.first);
+    BOOST_REQUIRE(it != colorCounts.end());
+    BOOST_REQUIRE_EQUAL(it->second, colorAndMaxCount.second);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+}  // namespace tests
+}  // namespace imageproc
@@ -0,0 +1,66 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#include "BandedCholesky.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+BandedCholesky::BandedCholesky(const size_t size, const size_t bandwidth)
+    : m_size(size), m_bandwidth(std::min(bandwidth, size > 0 ? size - 1 : 0)), m_data(size * (m_bandwidth + 1)) {}
+
+bool BandedCholesky::factorize() {
+  BandedCholesky& a = *this;
+
+  double maxDiagonal = 0;
+  for (size_t i = 0; i < m_size; ++i) {
+    maxDiagonal = std::max(maxDiagonal, std::fabs(a(i, i)));
+  }
+  // Pivots below this are considered to be zero.
+  const double minPivot = maxDiagonal * m_size * std::numeric_limits<double>::epsilon();
+
+  for (size_t i = 0; i < m_size; ++i) {
+    const size_t firstCol = i > m_bandwidth ? i - m_bandwidth : 0;
+    for (size_t j = firstCol; j <= i; ++j) {
+      double sum = a(i, j);
+      // Both rows i and j only have non-zeros starting from firstCol.
+      for (size_t k = firstCol; k < j; ++k) {
+        sum -= a(i, k) * a(j, k);
+      }
+
+      if (j < i) {
+        a(i, j) = sum / a(j, j);
+      } else if (sum <= minPivot) {
+        return false;
+      } else {
+        a(i, i) = std::sqrt(sum);
+      }
+    }
+  }
+  return true;
+}
+
+void BandedCholesky::solveInPlace(double* x) const {
+  const BandedCholesky& l = *this;
+
+  // L * y = b
+  for (size_t i = 0; i < m_size; ++i) {
+    const size_t firstCol = i > m_bandwidth ? i - m_bandwidth : 0;
+    double sum = x[i];
+    for (size_t k = firstCol; k < i; ++k) {
+      sum -= l(i, k) * x[k];
+    }
+    x[i] = sum / l(i, i);
+  }
+
+  // L^T * x = y
+  for (size_t i = m_size; i-- > 0;) {
+    const size_t lastRow = std::min(i + m_bandwidth, m_size - 1);
+    double sum = x[i];
+    for (size_t k = i + 1; k <= lastRow; ++k) {
+      sum -= l(k, i) * x[k];
+    }
+    x[i] = sum / l(i, i);
+  }
+}
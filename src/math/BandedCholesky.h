@@ -0,0 +1,68 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#ifndef SCANTAILOR_MATH_BANDEDCHOLESKY_H_
+#define SCANTAILOR_MATH_BANDEDCHOLESKY_H_
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+/**
+ * \brief Solves Ax = b for a symmetric positive definite band matrix A
+ *        using Cholesky decomposition.
+ *
+ * Only the lower half of the band is stored, so memory usage is
+ * O(size * bandwidth) and decomposition takes O(size * bandwidth^2)
+ * operations rather than O(size^3) for a dense matrix.
+ * The bandwidth is the maximum distance from the diagonal
+ * to a non-zero element, that is 0 for diagonal matrices.
+ */
+class BandedCholesky {
+  // Member-wise copying is OK.
+ public:
+  BandedCholesky(size_t size, size_t bandwidth);
+
+  size_t size() const { return m_size; }
+
+  size_t bandwidth() const { return m_bandwidth; }
+
+  /**
+   * \brief Provides access to element (row, col) of A, or of its decomposition
+   *        after factorize() was called.
+   *
+   * \p col must be in [row - bandwidth, row] range.
+   */
+  double& operator()(size_t row, size_t col) {
+    assert(col <= row && row - col <= m_bandwidth);
+    return m_data[row * (m_bandwidth + 1) + m_bandwidth + col - row];
+  }
+
+  double operator()(size_t row, size_t col) const {
+    assert(col <= row && row - col <= m_bandwidth);
+    return m_data[row * (m_bandwidth + 1) + m_bandwidth + col - row];
+  }
+
+  /**
+   * \brief Replaces A with its decomposition L, where A = L * L^T.
+   *
+   * \return false if A is not positive definite (within numeric precision),
+   *         in which case the stored data is undefined.
+   */
+  bool factorize();
+
+  /**
+   * \brief Solves Ax = b, with \p x initially containing b.
+   *
+   * Must be called after a successful factorize().
+   */
+  void solveInPlace(double* x) const;
+
+ private:
+  size_t m_size;
+  size_t m_bandwidth;
+  std::vector<double> m_data;
+};
+
+
+#endif  // ifndef SCANTAILOR_MATH_BANDEDCHOLESKY_H_
@@ -0,0 +1,133 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#ifndef SCANTAILOR_MATH_FIXEDSIZEMATRIXOPS_H_
+#define SCANTAILOR_MATH_FIXEDSIZEMATRIXOPS_H_
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "MatMNT.h"
+#include "VecNT.h"
+
+/**
+ * \brief Closed-form determinants, inverses and linear solvers for 2x2 and 3x3 matrices.
+ *
+ * MatrixCalc handles matrices of any size, at the cost of going through a pool
+ * allocator and a generic LU decomposition even for the smallest ones.  That
+ * matters where a small system is solved per pixel column or per point.
+ *
+ * These throw std::runtime_error on matrices that are singular, or nearly so
+ * relative to the magnitude of their rows.
+ */
+namespace fixedsize {
+namespace detail {
+/**
+ * The product of the norms of the rows of \p m, which is the largest absolute value
+ * the determinant of a matrix with such rows can have.
+ */
+template <size_t N, typename T>
+T rowNormProduct(const MatMNT<N, N, T>& m) {
+  using namespace std;  // To catch different overloads of std::sqrt()
+  T product(1);
+  for (int i = 0; i < static_cast<int>(N); ++i) {
+    T sqNorm(0);
+    for (int j = 0; j < static_cast<int>(N); ++j) {
+      sqNorm += m(i, j) * m(i, j);
+    }
+    product *= sqrt(sqNorm);
+  }
+  return product;
+}
+
+/**
+ * Returns 1 / det, unless \p det is negligible compared to \p scale, the result
+ * of rowNormProduct().  Being relative, the check doesn't depend on the units
+ * the matrix entries are expressed in.
+ */
+template <typename T>
+T reciprocalDet(const T det, const T scale) {
+  using namespace std;  // To catch different overloads of std::abs()
+  if (!(abs(det) > sqrt(numeric_limits<T>::epsilon()) * scale)) {
+    throw std::runtime_error("fixedsize: singular matrix");
+  }
+  return T(1) / det;
+}
+}  // namespace detail
+
+template <typename T>
+T det(const MatMNT<2, 2, T>& m) {
+  return m(0, 0) * m(1, 1) - m(0, 1) * m(1, 0);
+}
+
+template <typename T>
+T det(const MatMNT<3, 3, T>& m) {
+  return m(0, 0) * (m(1, 1) * m(2, 2) - m(1, 2) * m(2, 1)) - m(0, 1) * (m(1, 0) * m(2, 2) - m(1, 2) * m(2, 0))
+         + m(0, 2) * (m(1, 0) * m(2, 1) - m(1, 1) * m(2, 0));
+}
+
+template <typename T>
+MatMNT<2, 2, T> inv(const MatMNT<2, 2, T>& m) {
+  const T r = detail::reciprocalDet(det(m), detail::rowNormProduct(m));
+
+  MatMNT<2, 2, T> res;
+  res(0, 0) = m(1, 1) * r;
+  res(0, 1) = -m(0, 1) * r;
+  res(1, 0) = -m(1, 0) * r;
+  res(1, 1) = m(0, 0) * r;
+  return res;
+}
+
+template <typename T>
+MatMNT<3, 3, T> inv(const MatMNT<3, 3, T>& m) {
+  // Cofactors of the first row, shared with the determinant.
+  const T c00 = m(1, 1) * m(2, 2) - m(1, 2) * m(2, 1);
+  const T c01 = m(1, 2) * m(2, 0) - m(1, 0) * m(2, 2);
+  const T c02 = m(1, 0) * m(2, 1) - m(1, 1) * m(2, 0);
+  const T r = detail::reciprocalDet(m(0, 0) * c00 + m(0, 1) * c01 + m(0, 2) * c02, detail::rowNormProduct(m));
+
+  // The transposed matrix of cofactors, divided by the determinant.
+  MatMNT<3, 3, T> res;
+  res(0, 0) = c00 * r;
+  res(1, 0) = c01 * r;
+  res(2, 0) = c02 * r;
+  res(0, 1) = (m(0, 2) * m(2, 1) - m(0, 1) * m(2, 2)) * r;
+  res(1, 1) = (m(0, 0) * m(2, 2) - m(0, 2) * m(2, 0)) * r;
+  res(2, 1) = (m(0, 1) * m(2, 0) - m(0, 0) * m(2, 1)) * r;
+  res(0, 2) = (m(0, 1) * m(1, 2) - m(0, 2) * m(1, 1)) * r;
+  res(1, 2) = (m(0, 2) * m(1, 0) - m(0, 0) * m(1, 2)) * r;
+  res(2, 2) = (m(0, 0) * m(1, 1) - m(0, 1) * m(1, 0)) * r;
+  return res;
+}
+
+/**
+ * \brief Solves Ax = b by Cramer's rule.
+ */
+template <typename T>
+VecNT<2, T> solve(const MatMNT<2, 2, T>& A, const VecNT<2, T>& b) {
+  const T r = detail::reciprocalDet(det(A), detail::rowNormProduct(A));
+  return VecNT<2, T>((b[0] * A(1, 1) - A(0, 1) * b[1]) * r, (A(0, 0) * b[1] - b[0] * A(1, 0)) * r);
+}
+
+/**
+ * \brief Solves Ax = b by Cramer's rule.
+ */
+template <typename T>
+VecNT<3, T> solve(const MatMNT<3, 3, T>& A, const VecNT<3, T>& b) {
+  // Minors of the last two rows, each shared by two of the determinants below.
+  const T m01 = A(1, 0) * A(2, 1) - A(1, 1) * A(2, 0);
+  const T m02 = A(1, 0) * A(2, 2) - A(1, 2) * A(2, 0);
+  const T m12 = A(1, 1) * A(2, 2) - A(1, 2) * A(2, 1);
+  const T mb0 = b[1] * A(2, 0) - A(1, 0) * b[2];
+  const T mb1 = b[1] * A(2, 1) - A(1, 1) * b[2];
+  const T mb2 = b[1] * A(2, 2) - A(1, 2) * b[2];
+
+  const T r = detail::reciprocalDet(A(0, 0) * m12 - A(0, 1) * m02 + A(0, 2) * m01, detail::rowNormProduct(A));
+  const T x0 = b[0] * m12 - A(0, 1) * mb2 + A(0, 2) * mb1;
+  const T x1 = A(0, 0) * mb2 - b[0] * m02 - A(0, 2) * mb0;
+  const T x2 = b[0] * m01 - A(0, 0) * mb1 + A(0, 1) * mb0;
+  return VecNT<3, T>(x0 * r, x1 * r, x2 * r);
+}
+}  // namespace fixedsize
+#endif  // ifndef SCANTAILOR_MATH_FIXEDSIZEMATRIXOPS_H_
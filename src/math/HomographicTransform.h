@@ -6,6 +6,7 @@
 
 #include <cstddef>
 
+#include "FixedSizeMatrixOps.h"
 #include "MatrixCalc.h"
 #include "VecNT.h"
 
@@ -46,6 +47,8 @@ class HomographicTransform<1, T> : public HomographicTransformBase<1, T> {
   explicit HomographicTransform(const typename HomographicTransformBase<1, T>::Mat& mat)
       : HomographicTransformBase<1, T>(mat) {}
 
+  HomographicTransform inv() const;
+
   T operator()(T from) const;
 
   // Prevent it's shadowing by the above one.
@@ -53,6 +56,21 @@ class HomographicTransform<1, T> : public HomographicTransformBase<1, T> {
 };
 
 
+/** An optimized 2D version, avoiding MatrixCalc for the 3x3 matrix. */
+template <typename T>
+class HomographicTransform<2, T> : public HomographicTransformBase<2, T> {
+ public:
+  using Vec = typename HomographicTransformBase<2, T>::Vec;
+
+  explicit HomographicTransform(const typename HomographicTransformBase<2, T>::Mat& mat)
+      : HomographicTransformBase<2, T>(mat) {}
+
+  HomographicTransform inv() const;
+
+  Vec operator()(const Vec& from) const;
+};
+
+
 template <size_t N, typename T>
 HomographicTransform<N, T> HomographicTransformBase<N, T>::inv() const {
   StaticMatrixCalc<T, 4 * (N + 1) * (N + 1), N + 1> mc;
@@ -72,6 +90,12 @@ typename HomographicTransformBase<N, T>::Vec HomographicTransformBase<N, T>::ope
   return res;
 }
 
+template <typename T>
+HomographicTransform<1, T> HomographicTransform<1, T>::inv() const {
+  const MatMNT<2, 2, T> invMat(fixedsize::inv(MatMNT<2, 2, T>(this->mat().data())));
+  return HomographicTransform<1, T>(typename HomographicTransformBase<1, T>::Mat(invMat.data()));
+}
+
 template <typename T>
 T HomographicTransform<1, T>::operator()(T from) const {
   // Optimized version for 1D case.
@@ -79,4 +103,20 @@ T HomographicTransform<1, T>::operator()(T from) const {
   return (from * m[0] + m[2]) / (from * m[1] + m[3]);
 }
 
+template <typename T>
+HomographicTransform<2, T> HomographicTransform<2, T>::inv() const {
+  const MatMNT<3, 3, T> invMat(fixedsize::inv(MatMNT<3, 3, T>(this->mat().data())));
+  return HomographicTransform<2, T>(typename HomographicTransformBase<2, T>::Mat(invMat.data()));
+}
+
+template <typename T>
+typename HomographicTransform<2, T>::Vec HomographicTransform<2, T>::operator()(const Vec& from) const {
+  // Same as the generic version, operation for operation, only unrolled.
+  const T* m = this->mat().data();
+  const T x = from[0];
+  const T y = from[1];
+  const T r = T(1) / (x * m[2] + y * m[5] + m[8]);
+  return Vec((x * m[0] + y * m[3] + m[6]) * r, (x * m[1] + y * m[4] + m[7]) * r);
+}
+
 #endif  // ifndef SCANTAILOR_MATH_HOMOGRAPHICTRANSFORM_H_
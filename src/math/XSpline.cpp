@@ -12,6 +12,23 @@
 #include "adiff/Function.h"
 #include "adiff/SparseMap.h"
 
+namespace {
+/**
+ * Marks the Hessian elements coupling the same coordinate of two control points
+ * as non-zero, along with the diagonal elements of both.
+ */
+void markCoupled(adiff::SparseMap<2>& sparseMap, const int controlPointIdx1, const int controlPointIdx2) {
+  for (int coord = 0; coord < 2; ++coord) {
+    const size_t var1 = controlPointIdx1 * 2 + coord;
+    const size_t var2 = controlPointIdx2 * 2 + coord;
+    sparseMap.markNonZero(var1, var1);
+    sparseMap.markNonZero(var2, var2);
+    sparseMap.markNonZero(var1, var2);
+    sparseMap.markNonZero(var2, var1);
+  }
+}
+}  // namespace
+
 struct XSpline::TensionDerivedParams {
   static const double t0;
   static const double t1;
@@ -70,6 +87,24 @@ class XSpline::HBlendFunc {
 };
 
 
+/**
+ * The blending functions of a segment.  They only depend on the tensions
+ * of the two control points the segment connects, so they can be set up
+ * once and then used for any number of positions within the segment.
+ */
+struct XSpline::SegmentBasis {
+  TensionDerivedParams tdp;
+  GBlendFunc g0;
+  GBlendFunc g1;
+  GBlendFunc g2;
+  GBlendFunc g3;
+  HBlendFunc h0;
+  HBlendFunc h3;
+
+  SegmentBasis(double tension1, double tension2);
+};
+
+
 struct XSpline::DecomposedDerivs {
   double zeroDerivCoeffs[4];
   double firstDerivCoeffs[4];
@@ -130,7 +165,18 @@ void XSpline::setControlPointTension(int idx, double tension) {
   m_controlPoints[idx].tension = tension;
 }
 
-QPointF XSpline::pointAt(double t) const {
+std::vector<XSpline::SegmentBasis> XSpline::segmentBases() const {
+  const int numSegments = this->numSegments();
+
+  std::vector<SegmentBasis> bases;
+  bases.reserve(numSegments);
+  for (int segment = 0; segment < numSegments; ++segment) {
+    bases.emplace_back(m_controlPoints[segment].tension, m_controlPoints[segment + 1].tension);
+  }
+  return bases;
+}
+
+void XSpline::toSegmentT(const double t, int& segment, double& segmentT) const {
   const int numSegments = this->numSegments();
   assert(numSegments > 0);
   assert(t >= 0 && t <= 1);
@@ -138,17 +184,48 @@ QPointF XSpline::pointAt(double t) const {
   if (t == 1.0) {
     // If we went with the branch below, we would end up with
     // segment == numSegments, which is an error.
-    return pointAtImpl(numSegments - 1, 1.0);
+    segment = numSegments - 1;
+    segmentT = 1.0;
   } else {
     const double t2 = t * numSegments;
-    const double segment = std::floor(t2);
-    return pointAtImpl((int) segment, t2 - segment);
+    const double segmentFloor = std::floor(t2);
+    segment = (int) segmentFloor;
+    segmentT = t2 - segmentFloor;
   }
 }
 
+QPointF XSpline::pointAt(double t) const {
+  int segment;
+  double segmentT;
+  toSegmentT(t, segment, segmentT);
+  return pointAtImpl(segment, segmentT);
+}
+
+QPointF XSpline::pointAt(const double t, const std::vector<SegmentBasis>& bases) const {
+  int segment;
+  double segmentT;
+  toSegmentT(t, segment, segmentT);
+  return pointAtImpl(segment, segmentT, bases[segment]);
+}
+
+std::vector<QPointF> XSpline::pointsAt(const std::vector<double>& ts) const {
+  const std::vector<SegmentBasis> bases(segmentBases());
+
+  std::vector<QPointF> points;
+  points.reserve(ts.size());
+  for (const double t : ts) {
+    points.push_back(pointAt(t, bases));
+  }
+  return points;
+}
+
 QPointF XSpline::pointAtImpl(int segment, double t) const {
+  return pointAtImpl(segment, t, SegmentBasis(m_controlPoints[segment].tension, m_controlPoints[segment + 1].tension));
+}
+
+QPointF XSpline::pointAtImpl(int segment, double t, const SegmentBasis& basis) const {
   LinearCoefficient coeffs[4];
-  const int numCoeffs = linearCombinationFor(coeffs, segment, t);
+  const int numCoeffs = linearCombinationFor(coeffs, segment, t, basis);
 
   QPointF pt(0, 0);
   for (int i = 0; i < numCoeffs; ++i) {
@@ -176,23 +253,26 @@ void XSpline::sample(const VirtualFunction<void, const QPointF&, double, SampleF
     maxSqdistBetweenSamples *= params.maxDistBetweenSamples;
   }
 
-  const QPointF fromPt(pointAt(fromT));
-  const QPointF toPt(pointAt(toT));
-  sink(fromPt, fromT, HEAD_SAMPLE);
-
   const int numSegments = this->numSegments();
   if (numSegments == 0) {
+    sink(m_controlPoints.front().pos, fromT, HEAD_SAMPLE);
     return;
   }
   const double rNumSegments = 1.0 / numSegments;
 
-  maybeAddMoreSamples(sink, maxSqdistToSpline, maxSqdistBetweenSamples, numSegments, rNumSegments, fromT, fromPt, toT,
-                      toPt);
+  const std::vector<SegmentBasis> bases(segmentBases());
+  const QPointF fromPt(pointAt(fromT, bases));
+  const QPointF toPt(pointAt(toT, bases));
+  sink(fromPt, fromT, HEAD_SAMPLE);
+
+  maybeAddMoreSamples(sink, bases, maxSqdistToSpline, maxSqdistBetweenSamples, numSegments, rNumSegments, fromT,
+                      fromPt, toT, toPt);
 
   sink(toPt, toT, TAIL_SAMPLE);
 }  // XSpline::sample
 
 void XSpline::maybeAddMoreSamples(const VirtualFunction<void, const QPointF&, double, SampleFlags>& sink,
+                                  const std::vector<SegmentBasis>& bases,
                                   double maxSqdistToSpline,
                                   double maxSqdistBetweenSamples,
                                   double numSegments,
@@ -217,7 +297,7 @@ void XSpline::maybeAddMoreSamples(const VirtualFunction<void, const QPointF&, do
     flags = JUNCTION_SAMPLE;
   }
 
-  const QPointF midPt(pointAt(midT));
+  const QPointF midPt(pointAt(midT, bases));
 
   if (flags != JUNCTION_SAMPLE) {
     const QPointF projection(ToLineProjector(QLineF(prevPt, nextPt)).projectionPoint(midPt));
@@ -229,13 +309,13 @@ void XSpline::maybeAddMoreSamples(const VirtualFunction<void, const QPointF&, do
     }
   }
 
-  maybeAddMoreSamples(sink, maxSqdistToSpline, maxSqdistBetweenSamples, numSegments, rNumSegments, prevT, prevPt, midT,
-                      midPt);
+  maybeAddMoreSamples(sink, bases, maxSqdistToSpline, maxSqdistBetweenSamples, numSegments, rNumSegments, prevT, prevPt,
+                      midT, midPt);
 
   sink(midPt, midT, flags);
 
-  maybeAddMoreSamples(sink, maxSqdistToSpline, maxSqdistBetweenSamples, numSegments, rNumSegments, midT, midPt, nextT,
-                      nextPt);
+  maybeAddMoreSamples(sink, bases, maxSqdistToSpline, maxSqdistBetweenSamples, numSegments, rNumSegments, midT, midPt,
+                      nextT, nextPt);
 }  // XSpline::maybeAddMoreSamples
 
 void XSpline::linearCombinationAt(double t, std::vector<LinearCoefficient>& coeffs) const {
@@ -266,6 +346,15 @@ void XSpline::linearCombinationAt(double t, std::vector<LinearCoefficient>& coef
 
 int XSpline::linearCombinationFor(LinearCoefficient* coeffs, int segment, double t) const {
   assert(segment >= 0 && segment < (int) m_controlPoints.size() - 1);
+  return linearCombinationFor(coeffs, segment, t,
+                              SegmentBasis(m_controlPoints[segment].tension, m_controlPoints[segment + 1].tension));
+}
+
+int XSpline::linearCombinationFor(LinearCoefficient* coeffs,
+                                  int segment,
+                                  double t,
+                                  const SegmentBasis& basis) const {
+  assert(segment >= 0 && segment < (int) m_controlPoints.size() - 1);
   assert(t >= 0 && t <= 1);
 
   int idxs[4];
@@ -274,28 +363,23 @@ int XSpline::linearCombinationFor(LinearCoefficient* coeffs, int segment, double
   idxs[2] = segment + 1;
   idxs[3] = std::min<int>(segment + 2, static_cast<const int&>(m_controlPoints.size() - 1));
 
-  ControlPoint pts[4];
-  for (int i = 0; i < 4; ++i) {
-    pts[i] = m_controlPoints[idxs[i]];
-  }
-
-  const TensionDerivedParams tdp(pts[1].tension, pts[2].tension);
+  const TensionDerivedParams& tdp = basis.tdp;
 
   Vec4d A;
 
   if (t <= tdp.T0p) {
-    A[0] = GBlendFunc(tdp.q[0], tdp.p[0]).value((t - tdp.T0p) / (tdp.t0 - tdp.T0p));
+    A[0] = basis.g0.value((t - tdp.T0p) / (tdp.t0 - tdp.T0p));
   } else {
-    A[0] = HBlendFunc(tdp.q[0]).value((t - tdp.T0p) / (tdp.t0 - tdp.T0p));
+    A[0] = basis.h0.value((t - tdp.T0p) / (tdp.t0 - tdp.T0p));
   }
 
-  A[1] = GBlendFunc(tdp.q[1], tdp.p[1]).value((t - tdp.T1p) / (tdp.t1 - tdp.T1p));
-  A[2] = GBlendFunc(tdp.q[2], tdp.p[2]).value((t - tdp.T2m) / (tdp.t2 - tdp.T2m));
+  A[1] = basis.g1.value((t - tdp.T1p) / (tdp.t1 - tdp.T1p));
+  A[2] = basis.g2.value((t - tdp.T2m) / (tdp.t2 - tdp.T2m));
 
   if (t >= tdp.T3m) {
-    A[3] = GBlendFunc(tdp.q[3], tdp.p[3]).value((t - tdp.T3m) / (tdp.t3 - tdp.T3m));
+    A[3] = basis.g3.value((t - tdp.T3m) / (tdp.t3 - tdp.T3m));
   } else {
-    A[3] = HBlendFunc(tdp.q[3]).value((t - tdp.T3m) / (tdp.t3 - tdp.T3m));
+    A[3] = basis.h3.value((t - tdp.T3m) / (tdp.t3 - tdp.T3m));
   }
 
   A /= A.sum();
@@ -320,9 +404,25 @@ int XSpline::linearCombinationFor(LinearCoefficient* coeffs, int segment, double
 
 XSpline::PointAndDerivs XSpline::pointAndDtsAt(double t) const {
   assert(t >= 0 && t <= 1);
-  PointAndDerivs pd;
+  return pointAndDtsFrom(decomposedDerivs(t));
+}
+
+std::vector<XSpline::PointAndDerivs> XSpline::pointsAndDtsAt(const std::vector<double>& ts) const {
+  const std::vector<SegmentBasis> bases(segmentBases());
+
+  std::vector<PointAndDerivs> pds;
+  pds.reserve(ts.size());
+  for (const double t : ts) {
+    int segment;
+    double segmentT;
+    toSegmentT(t, segment, segmentT);
+    pds.push_back(pointAndDtsFrom(decomposedDerivsImpl(segment, segmentT, bases[segment])));
+  }
+  return pds;
+}
 
-  const DecomposedDerivs derivs(decomposedDerivs(t));
+XSpline::PointAndDerivs XSpline::pointAndDtsFrom(const DecomposedDerivs& derivs) const {
+  PointAndDerivs pd;
   for (int i = 0; i < derivs.numControlPoints; ++i) {
     const QPointF& cp = m_controlPoints[derivs.controlPoints[i]].pos;
     pd.point += cp * derivs.zeroDerivCoeffs[i];
@@ -333,24 +433,22 @@ XSpline::PointAndDerivs XSpline::pointAndDtsAt(double t) const {
 }
 
 XSpline::DecomposedDerivs XSpline::decomposedDerivs(const double t) const {
-  assert(t >= 0 && t <= 1);
-
-  const int numSegments = this->numSegments();
-  assert(numSegments > 0);
-
-  if (t == 1.0) {
-    // If we went with the branch below, we would end up with
-    // segment == numSegments, which is an error.
-    return decomposedDerivsImpl(numSegments - 1, 1.0);
-  } else {
-    const double t2 = t * numSegments;
-    const double segment = std::floor(t2);
-    return decomposedDerivsImpl((int) segment, t2 - segment);
-  }
+  int segment;
+  double segmentT;
+  toSegmentT(t, segment, segmentT);
+  return decomposedDerivsImpl(segment, segmentT);
 }
 
 XSpline::DecomposedDerivs XSpline::decomposedDerivsImpl(const int segment, const double t) const {
   assert(segment >= 0 && segment < (int) m_controlPoints.size() - 1);
+  return decomposedDerivsImpl(segment, t,
+                              SegmentBasis(m_controlPoints[segment].tension, m_controlPoints[segment + 1].tension));
+}
+
+XSpline::DecomposedDerivs XSpline::decomposedDerivsImpl(const int segment,
+                                                        const double t,
+                                                        const SegmentBasis& basis) const {
+  assert(segment >= 0 && segment < (int) m_controlPoints.size() - 1);
   assert(t >= 0 && t <= 1);
 
   DecomposedDerivs derivs{};
@@ -361,12 +459,7 @@ XSpline::DecomposedDerivs XSpline::decomposedDerivsImpl(const int segment, const
   derivs.controlPoints[2] = segment + 1;
   derivs.controlPoints[3] = std::min<int>(segment + 2, static_cast<const int&>(m_controlPoints.size() - 1));
 
-  ControlPoint pts[4];
-  for (int i = 0; i < 4; ++i) {
-    pts[i] = m_controlPoints[derivs.controlPoints[i]];
-  }
-
-  const TensionDerivedParams tdp(pts[1].tension, pts[2].tension);
+  const TensionDerivedParams& tdp = basis.tdp;
 
   // Note that we don't want the derivate with respect to t that's
   // passed to us (ranging from 0 to 1 within a segment).
@@ -390,7 +483,7 @@ XSpline::DecomposedDerivs XSpline::decomposedDerivsImpl(const int segment, const
       // u(t) = ta * tt + tb
       // u'(t) = ta
       // g(t) = g(u(t), <tension derived params>)
-      GBlendFunc g(tdp.q[0], tdp.p[0]);
+      const GBlendFunc& g = basis.g0;
       A[0] = g.value(u);
 
       // g'(u(t(T))) = g'(u)*u'(t)*t'(T)
@@ -399,7 +492,7 @@ XSpline::DecomposedDerivs XSpline::decomposedDerivsImpl(const int segment, const
       // g"(u(t(T))) = g"(u)*u'(t)*t'(T)*u'(t)*t'(T)
       ddA[0] = g.secondDerivative(u) * (ta * dtdT) * (ta * dtdT);
     } else {
-      HBlendFunc h(tdp.q[0]);
+      const HBlendFunc& h = basis.h0;
       A[0] = h.value(u);
       dA[0] = h.firstDerivative(u) * (ta * dtdT);
       ddA[0] = h.secondDerivative(u) * (ta * dtdT) * (ta * dtdT);
@@ -411,7 +504,7 @@ XSpline::DecomposedDerivs XSpline::decomposedDerivsImpl(const int segment, const
     const double ta = 1.0 / (tdp.t1 - tdp.T1p);
     const double tb = -tdp.T1p * ta;
     const double u = ta * t + tb;
-    GBlendFunc g(tdp.q[1], tdp.p[1]);
+    const GBlendFunc& g = basis.g1;
     A[1] = g.value(u);
     dA[1] = g.firstDerivative(u) * (ta * dtdT);
     ddA[1] = g.secondDerivative(u) * (ta * dtdT) * (ta * dtdT);
@@ -423,7 +516,7 @@ XSpline::DecomposedDerivs XSpline::decomposedDerivsImpl(const int segment, const
     const double ta = 1.0 / (tdp.t2 - tdp.T2m);
     const double tb = -tdp.T2m * ta;
     const double u = ta * t + tb;
-    GBlendFunc g(tdp.q[2], tdp.p[2]);
+    const GBlendFunc& g = basis.g2;
     A[2] = g.value(u);
     dA[2] = g.firstDerivative(u) * (ta * dtdT);
     ddA[2] = g.secondDerivative(u) * (ta * dtdT) * (ta * dtdT);
@@ -435,12 +528,12 @@ XSpline::DecomposedDerivs XSpline::decomposedDerivsImpl(const int segment, const
     const double tb = -tdp.T3m * ta;
     const double u = ta * t + tb;
     if (t >= tdp.T3m) {
-      GBlendFunc g(tdp.q[3], tdp.p[3]);
+      const GBlendFunc& g = basis.g3;
       A[3] = g.value(u);
       dA[3] = g.firstDerivative(u) * (ta * dtdT);
       ddA[3] = g.secondDerivative(u) * (ta * dtdT) * (ta * dtdT);
     } else {
-      HBlendFunc h(tdp.q[3]);
+      const HBlendFunc& h = basis.h3;
       A[3] = h.value(u);
       dA[3] = h.firstDerivative(u) * (ta * dtdT);
       ddA[3] = h.secondDerivative(u) * (ta * dtdT) * (ta * dtdT);
@@ -515,8 +608,13 @@ QuadraticFunction XSpline::controlPointsAttractionForce(int segBegin, int segEnd
 
   const int numControlPoints = this->numControlPoints();
 
+  // Each term only involves the same coordinate of two adjacent control points,
+  // so the Hessian is mostly zeros.  Marking all of it non-zero would make every
+  // operation below quadratic in the number of control points.
   SparseMap<2> sparseMap(numControlPoints * 2);
-  sparseMap.markAllNonZero();
+  for (int i = segBegin + 1; i <= segEnd; ++i) {
+    markCoupled(sparseMap, i - 1, i);
+  }
 
   Function<2> force(sparseMap);
   if (segBegin != segEnd) {
@@ -529,7 +627,8 @@ QuadraticFunction XSpline::controlPointsAttractionForce(int segBegin, int segEnd
 
       const Function<2> dx(nextX - prevX);
       const Function<2> dy(nextY - prevY);
-      force += dx * dx + dy * dy;
+      force.addProduct(dx, dx);
+      force.addProduct(dy, dy);
 
       nextX.swap(prevX);
       nextY.swap(prevY);
@@ -556,14 +655,34 @@ QuadraticFunction XSpline::junctionPointsAttractionForce(int segBegin, int segEn
 
   const int numControlPoints = this->numControlPoints();
 
+  // A junction point only depends on a few control points around it.
+  std::vector<std::vector<LinearCoefficient>> junctionCoeffs(segEnd - segBegin + 1);
+  for (int i = segBegin; i <= segEnd; ++i) {
+    linearCombinationAt(controlPointIndexToT(i), junctionCoeffs[i - segBegin]);
+  }
+
   SparseMap<2> sparseMap(numControlPoints * 2);
-  sparseMap.markAllNonZero();
+  for (int i = segBegin + 1; i <= segEnd; ++i) {
+    const std::vector<LinearCoefficient>& prevCoeffs = junctionCoeffs[i - 1 - segBegin];
+    const std::vector<LinearCoefficient>& nextCoeffs = junctionCoeffs[i - segBegin];
+    for (const LinearCoefficient& coeff1 : prevCoeffs) {
+      for (const LinearCoefficient& coeff2 : prevCoeffs) {
+        markCoupled(sparseMap, coeff1.controlPointIdx, coeff2.controlPointIdx);
+      }
+      for (const LinearCoefficient& coeff2 : nextCoeffs) {
+        markCoupled(sparseMap, coeff1.controlPointIdx, coeff2.controlPointIdx);
+      }
+    }
+    for (const LinearCoefficient& coeff1 : nextCoeffs) {
+      for (const LinearCoefficient& coeff2 : nextCoeffs) {
+        markCoupled(sparseMap, coeff1.controlPointIdx, coeff2.controlPointIdx);
+      }
+    }
+  }
 
   Function<2> force(sparseMap);
 
   if (segBegin != segEnd) {
-    QPointF pt(pointAt(controlPointIndexToT(segBegin)));
-    std::vector<LinearCoefficient> coeffs;
     Function<2> prevX(0);
     Function<2> prevY(0);
 
@@ -571,8 +690,7 @@ QuadraticFunction XSpline::junctionPointsAttractionForce(int segBegin, int segEn
       Function<2> nextX(sparseMap);
       Function<2> nextY(sparseMap);
 
-      linearCombinationAt(controlPointIndexToT(i), coeffs);
-      for (const LinearCoefficient& coeff : coeffs) {
+      for (const LinearCoefficient& coeff : junctionCoeffs[i - segBegin]) {
         const QPointF cp(m_controlPoints[coeff.controlPointIdx].pos);
         Function<2> x(coeff.controlPointIdx * 2, cp.x(), sparseMap);
         Function<2> y(coeff.controlPointIdx * 2 + 1, cp.y(), sparseMap);
@@ -585,7 +703,8 @@ QuadraticFunction XSpline::junctionPointsAttractionForce(int segBegin, int segEn
       if (i != segBegin) {
         const Function<2> dx(nextX - prevX);
         const Function<2> dy(nextY - prevY);
-        force += dx * dx + dy * dy;
+        force.addProduct(dx, dx);
+        force.addProduct(dy, dy);
       }
 
       nextX.swap(prevX);
@@ -634,12 +753,13 @@ QPointF XSpline::pointClosestTo(const QPointF to, double* t, double accuracy) co
   const double sqAccuracy = accuracy * accuracy;
   double prevT = 0;
   double nextT = 1;
-  prevPt = pointAtImpl(bestSegment, prevT);
-  nextPt = pointAtImpl(bestSegment, nextT);
+  const SegmentBasis basis(m_controlPoints[bestSegment].tension, m_controlPoints[bestSegment + 1].tension);
+  prevPt = pointAtImpl(bestSegment, prevT, basis);
+  nextPt = pointAtImpl(bestSegment, nextT, basis);
 
   while (Vec2d(prevPt - nextPt).squaredNorm() > sqAccuracy) {
     const double midT = 0.5 * (prevT + nextT);
-    const QPointF midPt(pointAtImpl(bestSegment, midT));
+    const QPointF midPt(pointAtImpl(bestSegment, midT, basis));
 
     const ToLineProjector projector(QLineF(prevPt, nextPt));
     const double pt = projector.projectionScalar(to);
@@ -731,6 +851,17 @@ XSpline::TensionDerivedParams::TensionDerivedParams(const double tension1, const
   p[3] = 2.0 * square(t3 - T3m);
 }
 
+/*========================= SegmentBasis =========================*/
+
+XSpline::SegmentBasis::SegmentBasis(const double tension1, const double tension2)
+    : tdp(tension1, tension2),
+      g0(tdp.q[0], tdp.p[0]),
+      g1(tdp.q[1], tdp.p[1]),
+      g2(tdp.q[2], tdp.p[2]),
+      g3(tdp.q[3], tdp.p[3]),
+      h0(tdp.q[0]),
+      h3(tdp.q[3]) {}
+
 /*========================== GBlendFunc ==========================*/
 
 XSpline::GBlendFunc::GBlendFunc(double q, double p)
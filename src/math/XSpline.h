@@ -98,6 +98,21 @@ class XSpline : public spfit::FittableSpline {
    */
   PointAndDerivs pointAndDtsAt(double t) const;
 
+  /**
+   * \brief Same as calling pointAt() for each of \p ts, only faster.
+   *
+   * The blending functions of each segment are set up once rather
+   * than once per point.
+   */
+  std::vector<QPointF> pointsAt(const std::vector<double>& ts) const;
+
+  /**
+   * \brief Same as calling pointAndDtsAt() for each of \p ts, only faster.
+   *
+   * \see pointsAt()
+   */
+  std::vector<PointAndDerivs> pointsAndDtsAt(const std::vector<double>& ts) const;
+
   /** \see spfit::FittableSpline::linearCombinationAt() */
   void linearCombinationAt(double t, std::vector<LinearCoefficient>& coeffs) const override;
 
@@ -178,18 +193,42 @@ class XSpline : public spfit::FittableSpline {
 
   class GBlendFunc;
   class HBlendFunc;
+  struct SegmentBasis;
 
   struct DecomposedDerivs;
 
+  /**
+   * Returns the blending functions of each segment.  Those only change
+   * when control points are added, removed or have their tension changed.
+   */
+  std::vector<SegmentBasis> segmentBases() const;
+
+  /**
+   * Splits a position on the spline into a segment index
+   * and a position within that segment.
+   */
+  void toSegmentT(double t, int& segment, double& segmentT) const;
+
+  QPointF pointAt(double t, const std::vector<SegmentBasis>& bases) const;
+
   QPointF pointAtImpl(int segment, double t) const;
 
+  QPointF pointAtImpl(int segment, double t, const SegmentBasis& basis) const;
+
+  PointAndDerivs pointAndDtsFrom(const DecomposedDerivs& derivs) const;
+
   int linearCombinationFor(LinearCoefficient* coeffs, int segment, double t) const;
 
+  int linearCombinationFor(LinearCoefficient* coeffs, int segment, double t, const SegmentBasis& basis) const;
+
   DecomposedDerivs decomposedDerivs(double t) const;
 
   DecomposedDerivs decomposedDerivsImpl(int segment, double t) const;
 
+  DecomposedDerivs decomposedDerivsImpl(int segment, double t, const SegmentBasis& basis) const;
+
   void maybeAddMoreSamples(const VirtualFunction<void, const QPointF&, double, SampleFlags>& sink,
+                           const std::vector<SegmentBasis>& bases,
                            double maxSqdistToSpline,
                            double maxSqdistBetweenSamples,
                            double numSegments,
@@ -118,6 +118,25 @@ Function<2>& Function<2>::operator*=(double scalar) {
 
   for (size_t u = 0; u < p; ++u) {
     firstDerivs[u] *= scalar;
+    secondDerivs[u] *= scalar;
+  }
+  return *this;
+}
+
+Function<2>& Function<2>::addProduct(const Function<2>& f1, const Function<2>& f2) {
+  const size_t p = firstDerivs.size();
+  assert(secondDerivs.size() == p);
+  assert(f1.firstDerivs.size() == p);
+  assert(f1.secondDerivs.size() == p);
+  assert(f2.firstDerivs.size() == p);
+  assert(f2.secondDerivs.size() == p);
+
+  value += f1.value * f2.value;
+
+  for (size_t u = 0; u < p; ++u) {
+    firstDerivs[u] += f1.firstDerivs[u] * f2.value + f1.value * f2.firstDerivs[u];
+    secondDerivs[u]
+        += f1.secondDerivs[u] * f2.value + 2.0 * f1.firstDerivs[u] * f2.firstDerivs[u] + f1.value * f2.secondDerivs[u];
   }
   return *this;
 }
@@ -69,6 +69,13 @@ class Function<2> {
   Function& operator-=(const Function& other);
 
   Function& operator*=(double scalar);
+
+  /**
+   * \brief Adds f1 * f2 to this function.
+   *
+   * Does the same as "*this += f1 * f2", only without the temporary functions.
+   */
+  Function& addProduct(const Function& f1, const Function& f2);
 };
 
 
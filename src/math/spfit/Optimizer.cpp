@@ -5,9 +5,22 @@
 
 #include <boost/foreach.hpp>
 
+#include "BandedCholesky.h"
 #include "MatrixCalc.h"
 
 namespace spfit {
+namespace {
+/**
+ * Smaller systems are solved by dense LU decomposition, which is fast enough for them.
+ */
+const size_t MIN_VARS_FOR_BANDED_SOLVER = 16;
+
+/**
+ * The banded solver is used if the bandwidth doesn't exceed this fraction of the number of variables.
+ */
+const double MAX_RELATIVE_BANDWIDTH = 0.25;
+}  // namespace
+
 Optimizer::Optimizer(size_t numVars)
     : m_numVars(numVars),
       m_A(numVars, numVars),
@@ -101,7 +114,9 @@ OptimizationResult Optimizer::optimize(double internalForceWeight) {
   DynamicMatrixCalc<double> mc;
 
   try {
-    mc(m_A).solve(mc(m_b)).write(m_x.data());
+    if (!solveBanded()) {
+      mc(m_A).solve(mc(m_b)).write(m_x.data());
+    }
   } catch (const std::runtime_error&) {
     m_externalForce.reset();
     m_internalForce.reset();
@@ -118,6 +133,96 @@ OptimizationResult Optimizer::optimize(double internalForceWeight) {
   return OptimizationResult(totalForceBefore, totalForceAfter);
 }  // Optimizer::optimize
 
+bool Optimizer::solveBanded() {
+  // For the layout of m_A and m_b, see setConstraints()
+  const size_t numVars = m_numVars;
+  const size_t numConstraints = m_b.size() - numVars;
+  if (numVars < MIN_VARS_FOR_BANDED_SOLVER) {
+    return false;
+  }
+
+  // Spline control points only affect the nearby parts of a spline,
+  // so the non-constant part of the gradient tends to be banded.
+  size_t bandwidth = 0;
+  for (size_t col = 0; col < numVars; ++col) {
+    for (size_t row = numVars - 1; row > col + bandwidth; --row) {
+      if (m_A(row, col) != 0) {
+        bandwidth = row - col;
+        break;
+      }
+    }
+  }
+  if (bandwidth > numVars * MAX_RELATIVE_BANDWIDTH) {
+    return false;
+  }
+
+  BandedCholesky cholesky(numVars, bandwidth);
+  for (size_t row = 0; row < numVars; ++row) {
+    const size_t firstCol = row > bandwidth ? row - bandwidth : 0;
+    for (size_t col = firstCol; col <= row; ++col) {
+      cholesky(row, col) = m_A(row, col);
+    }
+  }
+  if (!cholesky.factorize()) {
+    return false;
+  }
+
+  // Instead of solving the whole system at once, we eliminate the displacements:
+  // with G being the N part, the system is:
+  // G * x + C^T * l = -D
+  // C * x = -J
+  // Then x = z - Y * l, where z = G^-1 * -D and Y = G^-1 * C^T,
+  // and the Lagrange multipliers come from (C * Y) * l = C * z + J.
+  std::vector<double> z(m_b.data(), m_b.data() + numVars);
+  cholesky.solveInPlace(z.data());
+
+  std::vector<double> y(numVars * numConstraints);
+  for (size_t i = 0; i < numConstraints; ++i) {
+    double* yCol = &y[i * numVars];
+    for (size_t j = 0; j < numVars; ++j) {
+      yCol[j] = m_A(numVars + i, j);
+    }
+    cholesky.solveInPlace(yCol);
+  }
+
+  std::vector<double> lambda(numConstraints);
+  if (numConstraints > 0) {
+    std::vector<double> cy(numConstraints * numConstraints);  // Column-major.
+    std::vector<double> rhs(numConstraints);
+    for (size_t row = 0; row < numConstraints; ++row) {
+      double cz = 0;
+      for (size_t j = 0; j < numVars; ++j) {
+        cz += m_A(numVars + row, j) * z[j];
+      }
+      rhs[row] = cz - m_b[numVars + row];
+
+      for (size_t col = 0; col < numConstraints; ++col) {
+        double sum = 0;
+        for (size_t j = 0; j < numVars; ++j) {
+          sum += m_A(numVars + row, j) * y[col * numVars + j];
+        }
+        cy[col * numConstraints + row] = sum;
+      }
+    }
+
+    const auto n = static_cast<int>(numConstraints);
+    DynamicMatrixCalc<double> mc;
+    mc(cy.data(), n, n).solve(mc(rhs.data(), n, 1)).write(lambda.data());
+  }
+
+  for (size_t j = 0; j < numVars; ++j) {
+    double x = z[j];
+    for (size_t i = 0; i < numConstraints; ++i) {
+      x -= y[i * numVars + j] * lambda[i];
+    }
+    m_x[j] = x;
+  }
+  for (size_t i = 0; i < numConstraints; ++i) {
+    m_x[numVars + i] = lambda[i];
+  }
+  return true;
+}  // Optimizer::solveBanded
+
 void Optimizer::undoLastStep() {
   adjustConstraints(-1.0);
   m_x.fill(0);
@@ -70,6 +70,16 @@ class Optimizer {
  private:
   void adjustConstraints(double direction);
 
+  /**
+   * \brief Solves the system in m_A and m_b with a banded Cholesky decomposition.
+   *
+   * \return false if the system is too small or not sparse enough for that
+   *         to pay off, or if it's not positive definite, in which case it
+   *         has to be solved the usual way.
+   * \throw std::runtime_error If the constraints can't be satisfied.
+   */
+  bool solveBanded();
+
   size_t m_numVars;
   MatT<double> m_A;
   VecT<double> m_b;
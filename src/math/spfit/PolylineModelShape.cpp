@@ -26,9 +26,11 @@ PolylineModelShape::PolylineModelShape(const std::vector<QPointF>& polyline) {
 
   const int numControlPoints = spline.numControlPoints();
   const double scale = 1.0 / (numControlPoints - 1);
+  std::vector<double> ts(numControlPoints);
   for (int i = 0; i < numControlPoints; ++i) {
-    m_vertices.push_back(spline.pointAndDtsAt(i * scale));
+    ts[i] = i * scale;
   }
+  m_vertices = spline.pointsAndDtsAt(ts);
 }
 
 SqDistApproximant PolylineModelShape::localSqDistApproximant(const QPointF& pt,
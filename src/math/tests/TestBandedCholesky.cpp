@@ -0,0 +1,141 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#include <BandedCholesky.h>
+#include <LinearFunction.h>
+#include <MatrixCalc.h>
+#include <QuadraticFunction.h>
+#include <spfit/Optimizer.h>
+
+#include <boost/test/tools/floating_point_comparison.hpp>
+#include <boost/test/unit_test.hpp>
+#include <cstdlib>
+#include <list>
+#include <vector>
+
+namespace imageproc {
+namespace tests {
+using namespace spfit;
+
+BOOST_AUTO_TEST_SUITE(BandedCholeskySuite)
+
+namespace {
+double frand(double from, double to) {
+  const double rand01 = rand() / double(RAND_MAX);
+  return from + (to - from) * rand01;
+}
+
+/**
+ * Makes a symmetric, diagonally dominant (hence positive definite) band matrix.
+ */
+MatT<double> randomBandMatrix(size_t size, size_t bandwidth) {
+  MatT<double> mat(size, size);
+  for (size_t i = 0; i < size; ++i) {
+    for (size_t j = i + 1; j < size && j <= i + bandwidth; ++j) {
+      mat(i, j) = mat(j, i) = frand(-1, 1);
+    }
+  }
+  for (size_t i = 0; i < size; ++i) {
+    mat(i, i) = 2.0 * bandwidth + frand(1, 2);
+  }
+  return mat;
+}
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(test_solve_matches_lu) {
+  const size_t size = 30;
+  const size_t bandwidth = 3;
+  const MatT<double> mat(randomBandMatrix(size, bandwidth));
+
+  std::vector<double> b(size);
+  for (double& val : b) {
+    val = frand(-10, 10);
+  }
+
+  BandedCholesky cholesky(size, bandwidth);
+  for (size_t i = 0; i < size; ++i) {
+    for (size_t j = (i > bandwidth ? i - bandwidth : 0); j <= i; ++j) {
+      cholesky(i, j) = mat(i, j);
+    }
+  }
+  BOOST_REQUIRE(cholesky.factorize());
+
+  std::vector<double> x(b);
+  cholesky.solveInPlace(x.data());
+
+  std::vector<double> control(size);
+  DynamicMatrixCalc<double> mc;
+  mc(mat).solve(mc(b.data(), static_cast<int>(size), 1)).write(control.data());
+
+  for (size_t i = 0; i < size; ++i) {
+    BOOST_REQUIRE_CLOSE(x[i], control[i], 1e-6);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_not_positive_definite) {
+  BandedCholesky cholesky(3, 1);
+  cholesky(0, 0) = 1;
+  cholesky(1, 0) = 2;
+  cholesky(1, 1) = 1;
+  cholesky(2, 1) = 0;
+  cholesky(2, 2) = 1;
+  BOOST_CHECK(!cholesky.factorize());
+}
+
+BOOST_AUTO_TEST_CASE(test_optimizer_with_constraints) {
+  // A system large and sparse enough for Optimizer to take the banded path.
+  const size_t numVars = 40;
+  const size_t bandwidth = 3;
+
+  QuadraticFunction force(numVars);
+  force.A = randomBandMatrix(numVars, bandwidth);
+  for (size_t i = 0; i < numVars; ++i) {
+    force.b[i] = frand(-10, 10);
+  }
+
+  std::list<LinearFunction> constraints;
+  for (int i = 0; i < 2; ++i) {
+    LinearFunction constraint(numVars);
+    constraint.a[i * 10] = 1;
+    constraint.a[i * 10 + 1] = -1;
+    constraint.b = frand(-1, 1);
+    constraints.push_back(constraint);
+  }
+
+  // Build and solve the full system the dense way.
+  const size_t numDimensions = numVars + constraints.size();
+  MatT<double> A(numDimensions, numDimensions);
+  std::vector<double> b(numDimensions);
+  const QuadraticFunction::Gradient grad(force.gradient());
+  for (size_t i = 0; i < numVars; ++i) {
+    b[i] = -grad.b[i];
+    for (size_t j = 0; j < numVars; ++j) {
+      A(i, j) = grad.A(i, j);
+    }
+  }
+  size_t row = numVars;
+  for (const LinearFunction& constraint : constraints) {
+    b[row] = -constraint.b;
+    for (size_t j = 0; j < numVars; ++j) {
+      A(row, j) = A(j, row) = constraint.a[j];
+    }
+    ++row;
+  }
+  std::vector<double> control(numDimensions);
+  DynamicMatrixCalc<double> mc;
+  mc(A).solve(mc(b.data(), static_cast<int>(numDimensions), 1)).write(control.data());
+
+  Optimizer optimizer(numVars);
+  optimizer.setConstraints(constraints);
+  optimizer.addExternalForce(force);
+  optimizer.optimize(0);
+
+  // LinearSolver treats values below sqrt(epsilon) as zeros, hence the tolerance.
+  for (size_t i = 0; i < numVars; ++i) {
+    BOOST_REQUIRE_CLOSE(optimizer.displacementVector()[i], control[i], 1e-4);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+}  // namespace tests
+}  // namespace imageproc
@@ -0,0 +1,138 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#include <FixedSizeMatrixOps.h>
+#include <HomographicTransform.h>
+#include <MatrixCalc.h>
+
+#include <boost/test/tools/floating_point_comparison.hpp>
+#include <boost/test/unit_test.hpp>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace imageproc {
+namespace tests {
+BOOST_AUTO_TEST_SUITE(FixedSizeMatrixOpsSuite)
+
+namespace {
+double frand(double from, double to) {
+  const double rand01 = rand() / double(RAND_MAX);
+  return from + (to - from) * rand01;
+}
+
+template <size_t N>
+MatMNT<N, N, double> randomMatrix() {
+  MatMNT<N, N, double> mat;
+  for (size_t i = 0; i < N * N; ++i) {
+    mat.data()[i] = frand(-10, 10);
+  }
+  return mat;
+}
+
+template <size_t N>
+void checkInvMatchesMatrixCalc() {
+  for (int iteration = 0; iteration < 100; ++iteration) {
+    const MatMNT<N, N, double> mat(randomMatrix<N>());
+
+    MatMNT<N, N, double> control;
+    MatrixCalc<double> mc;
+    mc(mat).inv().write(control.data());
+
+    const MatMNT<N, N, double> inv(fixedsize::inv(mat));
+    for (size_t i = 0; i < N * N; ++i) {
+      BOOST_REQUIRE_CLOSE(inv.data()[i], control.data()[i], 1e-6);
+    }
+  }
+}
+
+template <size_t N>
+void checkSolveMatchesMatrixCalc() {
+  for (int iteration = 0; iteration < 100; ++iteration) {
+    const MatMNT<N, N, double> mat(randomMatrix<N>());
+    VecNT<N, double> b;
+    for (size_t i = 0; i < N; ++i) {
+      b[i] = frand(-10, 10);
+    }
+
+    VecNT<N, double> control;
+    MatrixCalc<double> mc;
+    mc(mat).solve(mc(b)).write(control);
+
+    const VecNT<N, double> x(fixedsize::solve(mat, b));
+    for (size_t i = 0; i < N; ++i) {
+      BOOST_REQUIRE_CLOSE(x[i], control[i], 1e-6);
+    }
+  }
+}
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(test_det) {
+  static const double A[] = {1, 1, 1, 2, 4, -3, 3, 6, -5};
+  BOOST_REQUIRE_CLOSE(fixedsize::det(Mat33d(A)), -1.0, 1e-6);
+
+  static const double B[] = {4, 2, 7, 6};
+  BOOST_REQUIRE_CLOSE(fixedsize::det(Mat22d(B)), 10.0, 1e-6);
+}
+
+BOOST_AUTO_TEST_CASE(test_inv_matches_matrix_calc) {
+  checkInvMatchesMatrixCalc<2>();
+  checkInvMatchesMatrixCalc<3>();
+}
+
+BOOST_AUTO_TEST_CASE(test_solve_matches_matrix_calc) {
+  checkSolveMatchesMatrixCalc<2>();
+  checkSolveMatchesMatrixCalc<3>();
+}
+
+BOOST_AUTO_TEST_CASE(test_singular) {
+  static const double A[] = {1, 2, 3, 2, 4, 6, 0, 1, 1};
+  BOOST_CHECK_THROW(fixedsize::inv(Mat33d(A)), std::runtime_error);
+  BOOST_CHECK_THROW(fixedsize::solve(Mat33d(A), Vec3d(1, 2, 3)), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_homography_roundtrip) {
+  static const double H[] = {1.2, 0.1, 0.0003, -0.2, 0.9, 0.0001, 15, -7, 1};
+  const HomographicTransform<2, double> forward((VecNT<9, double>(H)));
+  const HomographicTransform<2, double> backward(forward.inv());
+
+  for (int i = 0; i < 100; ++i) {
+    const Vec2d pt(frand(0, 1000), frand(0, 1000));
+    const Vec2d roundtrip(backward(forward(pt)));
+    BOOST_REQUIRE_CLOSE(roundtrip[0], pt[0], 1e-6);
+    BOOST_REQUIRE_CLOSE(roundtrip[1], pt[1], 1e-6);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_homography_matches_generic) {
+  static const double H[] = {1.2, 0.1, 0.0003, -0.2, 0.9, 0.0001, 15, -7, 1};
+  const HomographicTransform<2, double> homography((VecNT<9, double>(H)));
+  const HomographicTransformBase<2, double> generic((VecNT<9, double>(H)));
+
+  for (int i = 0; i < 100; ++i) {
+    const Vec2d pt(frand(0, 1000), frand(0, 1000));
+    const Vec2d mapped(homography(pt));
+    const Vec2d control(generic(pt));
+    BOOST_REQUIRE_CLOSE(mapped[0], control[0], 1e-9);
+    BOOST_REQUIRE_CLOSE(mapped[1], control[1], 1e-9);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_singularity_is_relative_to_scale) {
+  // Well conditioned, but with a determinant far below any fixed threshold.
+  static const double A[] = {2e-4, 1e-4, 0, 1e-4, 3e-4, 1e-4, 0, 1e-4, 2e-4};
+  const Mat33d inv(fixedsize::inv(Mat33d(A)));
+  const Vec3d x(fixedsize::solve(Mat33d(A), Vec3d(3e-4, 5e-4, 3e-4)));
+  for (size_t i = 0; i < 3; ++i) {
+    BOOST_REQUIRE_CLOSE(x[i], 1.0, 1e-6);
+  }
+  BOOST_REQUIRE_CLOSE(inv(0, 0) * A[0] + inv(0, 1) * A[1] + inv(0, 2) * A[2], 1.0, 1e-6);
+
+  // Nearly singular, but with a determinant far above any fixed threshold.
+  static const double B[] = {1e6, 2e6, 3e6, 2e6, 4e6, 6e6 + 1e-6, 0, 1e6, 1e6};
+  BOOST_CHECK_THROW(fixedsize::inv(Mat33d(B)), std::runtime_error);
+  BOOST_CHECK_THROW(fixedsize::solve(Mat33d(B), Vec3d(1, 2, 3)), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+}  // namespace tests
+}  // namespace imageproc
@@ -7,6 +7,7 @@
 #include <boost/test/unit_test.hpp>
 #include <cmath>
 #include <cstdlib>
+#include <vector>
 
 namespace adiff {
 namespace tests {
@@ -92,6 +93,102 @@ BOOST_AUTO_TEST_CASE(test3) {
   BOOST_REQUIRE_CLOSE(hessian(1, 1), 16, 1e-06);
 }
 
+BOOST_AUTO_TEST_CASE(test_scalar_multiplication) {
+  // F(x) = 3 * x^2  | x = 2
+
+  SparseMap<2> sparseMap(1);
+  sparseMap.markAllNonZero();
+
+  const Function<2> x(0, 2, sparseMap);
+  const Function<2> res(3.0 * (x * x));
+
+  const VecT<double> gradient(res.gradient(sparseMap));
+  const MatT<double> hessian(res.hessian(sparseMap));
+
+  // F = 12
+  // Fx = 6 * x = 12
+  // Fxx = 6
+
+  BOOST_REQUIRE_CLOSE(res.value, 12, 1e-06);
+  BOOST_REQUIRE_CLOSE(gradient[0], 12, 1e-06);
+  BOOST_REQUIRE_CLOSE(hessian(0, 0), 6, 1e-06);
+}
+
+namespace {
+/**
+ * Sum of (x[i] - x[i - 1])^2 * x[i], accumulated with addProduct()
+ * or with the regular operators.
+ */
+Function<2> chain(const std::vector<double>& vals, const SparseMap<2>& sparseMap, bool fused) {
+  Function<2> res(sparseMap);
+  Function<2> prev(0, vals[0], sparseMap);
+  for (size_t i = 1; i < vals.size(); ++i) {
+    Function<2> next(i, vals[i], sparseMap);
+    const Function<2> diff(next - prev);
+    if (fused) {
+      res.addProduct(diff * diff, next);
+    } else {
+      res += diff * diff * next;
+    }
+    next.swap(prev);
+  }
+  return res;
+}
+
+SparseMap<2> chainSparseMap(size_t numVars) {
+  SparseMap<2> sparseMap(numVars);
+  for (size_t i = 1; i < numVars; ++i) {
+    sparseMap.markNonZero(i - 1, i - 1);
+    sparseMap.markNonZero(i, i);
+    sparseMap.markNonZero(i - 1, i);
+    sparseMap.markNonZero(i, i - 1);
+  }
+  return sparseMap;
+}
+
+std::vector<double> randomValues(size_t numVars) {
+  std::vector<double> vals(numVars);
+  for (double& val : vals) {
+    val = rand() / double(RAND_MAX) * 10.0 - 5.0;
+  }
+  return vals;
+}
+
+void checkSparseMatchesDense(const size_t numVars) {
+  const std::vector<double> vals(randomValues(numVars));
+
+  SparseMap<2> denseMap(numVars);
+  denseMap.markAllNonZero();
+  const SparseMap<2> sparseMap(chainSparseMap(numVars));
+  BOOST_REQUIRE_LT(sparseMap.numNonZeroElements(), denseMap.numNonZeroElements());
+
+  const Function<2> dense(chain(vals, denseMap, false));
+  const Function<2> sparse(chain(vals, sparseMap, true));
+
+  const VecT<double> denseGradient(dense.gradient(denseMap));
+  const VecT<double> sparseGradient(sparse.gradient(sparseMap));
+  const MatT<double> denseHessian(dense.hessian(denseMap));
+  const MatT<double> sparseHessian(sparse.hessian(sparseMap));
+
+  BOOST_REQUIRE_CLOSE(sparse.value, dense.value, 1e-06);
+  for (size_t i = 0; i < numVars; ++i) {
+    BOOST_REQUIRE_CLOSE(sparseGradient[i], denseGradient[i], 1e-06);
+    for (size_t j = 0; j < numVars; ++j) {
+      BOOST_REQUIRE_SMALL(sparseHessian(i, j) - denseHessian(i, j), 1e-06);
+    }
+  }
+}
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(test_sparse_matches_dense) {
+  checkSparseMatchesDense(12);
+}
+
+BOOST_AUTO_TEST_CASE(test_sparse_matches_dense_on_long_chain) {
+  // Long enough for the sparse map to leave out most of the dense one.
+  checkSparseMatchesDense(60);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 }  // namespace tests
 }  // namespace adiff
\ No newline at end of file
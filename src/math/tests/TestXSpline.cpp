@@ -0,0 +1,139 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#include <XSpline.h>
+#include <adiff/Function.h>
+
+#include <boost/test/unit_test.hpp>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace tests {
+using namespace adiff;
+
+BOOST_AUTO_TEST_SUITE(XSplineTestSuite)
+
+namespace {
+/**
+ * A wavy spline of approximating patches, so that each junction point
+ * depends on the control points on both sides of it.
+ */
+XSpline makeSpline() {
+  XSpline spline;
+  spline.appendControlPoint(QPointF(0, 0), 0);
+  for (int i = 1; i < 9; ++i) {
+    spline.appendControlPoint(QPointF(i * 10.0, 5.0 * std::sin(i * 1.3)), (i % 2 == 0) ? 1.0 : 0.5);
+  }
+  spline.appendControlPoint(QPointF(90, 0), 0);
+  return spline;
+}
+
+QuadraticFunction toQuadraticFunction(const Function<2>& force, const SparseMap<2>& sparseMap, const int numVars) {
+  QuadraticFunction f(numVars);
+  f.A = 0.5 * force.hessian(sparseMap);
+  f.b = force.gradient(sparseMap);
+  f.c = force.value;
+  return f;
+}
+
+/**
+ * XSpline::controlPointsAttractionForce() as it would be with no regard for sparsity.
+ */
+QuadraticFunction denseControlPointsAttractionForce(const XSpline& spline, const int segBegin, const int segEnd) {
+  const int numVars = spline.numControlPoints() * 2;
+  SparseMap<2> sparseMap(numVars);
+  sparseMap.markAllNonZero();
+
+  Function<2> force(sparseMap);
+  for (int i = segBegin + 1; i <= segEnd; ++i) {
+    const QPointF prev(spline.controlPointPosition(i - 1));
+    const QPointF next(spline.controlPointPosition(i));
+    const Function<2> dx(Function<2>(i * 2, next.x(), sparseMap) - Function<2>((i - 1) * 2, prev.x(), sparseMap));
+    const Function<2> dy(Function<2>(i * 2 + 1, next.y(), sparseMap)
+                         - Function<2>((i - 1) * 2 + 1, prev.y(), sparseMap));
+    force.addProduct(dx, dx);
+    force.addProduct(dy, dy);
+  }
+  return toQuadraticFunction(force, sparseMap, numVars);
+}
+
+/**
+ * XSpline::junctionPointsAttractionForce() as it would be with no regard for sparsity.
+ */
+QuadraticFunction denseJunctionPointsAttractionForce(const XSpline& spline, const int segBegin, const int segEnd) {
+  const int numVars = spline.numControlPoints() * 2;
+  SparseMap<2> sparseMap(numVars);
+  sparseMap.markAllNonZero();
+
+  std::vector<std::pair<Function<2>, Function<2>>> junctionPoints;
+  for (int i = segBegin; i <= segEnd; ++i) {
+    std::vector<XSpline::LinearCoefficient> coeffs;
+    spline.linearCombinationAt(spline.controlPointIndexToT(i), coeffs);
+
+    Function<2> x(sparseMap);
+    Function<2> y(sparseMap);
+    for (const XSpline::LinearCoefficient& coeff : coeffs) {
+      const QPointF cp(spline.controlPointPosition(coeff.controlPointIdx));
+      Function<2> cpX(coeff.controlPointIdx * 2, cp.x(), sparseMap);
+      Function<2> cpY(coeff.controlPointIdx * 2 + 1, cp.y(), sparseMap);
+      cpX *= coeff.coeff;
+      cpY *= coeff.coeff;
+      x += cpX;
+      y += cpY;
+    }
+    junctionPoints.emplace_back(x, y);
+  }
+
+  Function<2> force(sparseMap);
+  for (size_t i = 1; i < junctionPoints.size(); ++i) {
+    const Function<2> dx(junctionPoints[i].first - junctionPoints[i - 1].first);
+    const Function<2> dy(junctionPoints[i].second - junctionPoints[i - 1].second);
+    force.addProduct(dx, dx);
+    force.addProduct(dy, dy);
+  }
+  return toQuadraticFunction(force, sparseMap, numVars);
+}
+
+void checkSame(const QuadraticFunction& f, const QuadraticFunction& control) {
+  BOOST_REQUIRE_EQUAL(f.numVars(), control.numVars());
+  for (size_t i = 0; i < control.numVars(); ++i) {
+    for (size_t j = 0; j < control.numVars(); ++j) {
+      BOOST_REQUIRE_SMALL(f.A(i, j) - control.A(i, j), 1e-9);
+    }
+    BOOST_REQUIRE_SMALL(f.b[i] - control.b[i], 1e-9);
+  }
+  BOOST_REQUIRE_SMALL(f.c - control.c, 1e-9);
+}
+
+const std::vector<std::pair<int, int>> SEGMENT_RANGES{{0, 9}, {0, 1}, {2, 6}, {4, 4}, {8, 9}};
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(test_junction_points_depend_on_both_neighbors) {
+  const XSpline spline(makeSpline());
+  std::vector<XSpline::LinearCoefficient> coeffs;
+  spline.linearCombinationAt(spline.controlPointIndexToT(4), coeffs);
+  BOOST_REQUIRE(coeffs.size() >= 3);
+}
+
+BOOST_AUTO_TEST_CASE(test_control_points_attraction_force_matches_dense) {
+  const XSpline spline(makeSpline());
+  checkSame(spline.controlPointsAttractionForce(), denseControlPointsAttractionForce(spline, 0, spline.numSegments()));
+  for (const std::pair<int, int>& range : SEGMENT_RANGES) {
+    checkSame(spline.controlPointsAttractionForce(range.first, range.second),
+              denseControlPointsAttractionForce(spline, range.first, range.second));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_junction_points_attraction_force_matches_dense) {
+  const XSpline spline(makeSpline());
+  checkSame(spline.junctionPointsAttractionForce(),
+            denseJunctionPointsAttractionForce(spline, 0, spline.numSegments()));
+  for (const std::pair<int, int>& range : SEGMENT_RANGES) {
+    checkSame(spline.junctionPointsAttractionForce(range.first, range.second),
+              denseJunctionPointsAttractionForce(spline, range.first, range.second));
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+}  // namespace tests